@@ -0,0 +1,812 @@
+/*
+ * Copyright © 2011 compiz contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * copyright holders not be used in advertising or publicity pertaining
+ * to distribution of the software without specific, written prior
+ * permission. The copyright holders make no representations about the
+ * suitability of this software for any purpose. It is provided "as is"
+ * without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * compiz-bench starts an Xvfb server and compiz on it, using Mesa's
+ * software rasterizer, maps a number of client windows that update
+ * themselves with a scripted damage pattern and measures how the
+ * compositor keeps up:
+ *
+ * - frames: every repaint of the composite overlay window damages the
+ *   root window, each DamageNotify on it is counted as one frame
+ * - event latency: a _NET_WM_STATE change is requested on a probe
+ *   window and the time until compiz updates the property is measured,
+ *   which is a round trip through the core event loop
+ * - memory: VmRSS of the compiz process at the end of the run
+ *
+ * The results are written as a single JSON object so that runs with
+ * different plugin sets can be compared by scripts.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/select.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/Xdamage.h>
+
+#define WARMUP_MS     1000
+#define TICK_MS       16
+#define PROBE_MS      100
+#define MAX_WINDOWS   256
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+typedef enum {
+    PatternScroll = 0,
+    PatternVideo,
+    PatternSmall,
+    PatternResize,
+    PatternMixed
+} Pattern;
+
+static const char *patternNames[] = {
+    "scroll", "video", "small", "resize", "mixed"
+};
+
+typedef struct _BenchWindow {
+    Window  id;
+    Pattern pattern;
+    GC      gc;
+    XImage  *image;
+    int     width;
+    int     height;
+    int     tick;
+} BenchWindow;
+
+typedef struct _Samples {
+    double *values;
+    int    count;
+    int    size;
+} Samples;
+
+typedef struct _Bench {
+    const char  *compiz;
+    const char  *plugins;
+    const char  *output;
+    const char  *displayName;
+    int         serverNumber;
+    int         useServer;
+    int         nWindows;
+    Pattern     pattern;
+    int         duration;
+    int         width;
+    int         height;
+
+    pid_t       serverPid;
+    pid_t       compizPid;
+
+    Display     *dpy;
+    Window      root;
+    int         damageEvent;
+    int         damageError;
+    Damage      rootDamage;
+
+    BenchWindow windows[MAX_WINDOWS];
+    Window      probe;
+    Atom        wmStateAtom;
+    Atom        wmStateSkipPagerAtom;
+    int         probeState;
+    double      probeSent;
+
+    Samples     frameTimes;
+    Samples     latencies;
+    double      lastFrame;
+    long        rss;
+} Bench;
+
+static double
+now (void)
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, 0);
+
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static void
+addSample (Samples *s,
+	   double  value)
+{
+    if (s->count == s->size)
+    {
+	double *values;
+	int    size = s->size ? s->size * 2 : 1024;
+
+	values = realloc (s->values, size * sizeof (double));
+	if (!values)
+	    return;
+
+	s->values = values;
+	s->size   = size;
+    }
+
+    s->values[s->count++] = value;
+}
+
+static int
+compareDoubles (const void *a,
+		const void *b)
+{
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+
+    return (da > db) - (da < db);
+}
+
+/* expects sorted samples */
+static double
+percentile (Samples *s,
+	    double  p)
+{
+    int i;
+
+    if (!s->count)
+	return 0.0;
+
+    i = (int) (p / 100.0 * (s->count - 1) + 0.5);
+
+    return s->values[i];
+}
+
+static void
+usage (const char *programName)
+{
+    printf ("Usage: %s "
+	    "[--compiz PATH] "
+	    "[--plugins LIST] "
+	    "[--windows N]\n       "
+	    "[--pattern scroll|video|small|resize|mixed] "
+	    "[--duration SECONDS]\n       "
+	    "[--size WIDTHxHEIGHT] "
+	    "[--server-number N] "
+	    "[--display DISPLAY]\n       "
+	    "[--output FILE] "
+	    "[--help]\n\n"
+	    "PLUGINS is a comma separated list, \"composite,opengl\" "
+	    "by default.\n"
+	    "With --display, compiz-bench uses an already running X server "
+	    "instead of\nstarting Xvfb.\n", programName);
+}
+
+static int
+parseArguments (Bench *b,
+		int   argc,
+		char  **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+	const char *arg = argv[i];
+	const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+	if (!strcmp (arg, "--help"))
+	{
+	    usage (argv[0]);
+	    exit (0);
+	}
+
+	if (!value)
+	{
+	    fprintf (stderr, "%s: missing value for '%s'\n", argv[0], arg);
+	    return 0;
+	}
+
+	if (!strcmp (arg, "--compiz"))
+	    b->compiz = value;
+	else if (!strcmp (arg, "--plugins"))
+	    b->plugins = value;
+	else if (!strcmp (arg, "--output"))
+	    b->output = value;
+	else if (!strcmp (arg, "--windows"))
+	    b->nWindows = atoi (value);
+	else if (!strcmp (arg, "--duration"))
+	    b->duration = atoi (value);
+	else if (!strcmp (arg, "--server-number"))
+	    b->serverNumber = atoi (value);
+	else if (!strcmp (arg, "--display"))
+	{
+	    b->displayName = value;
+	    b->useServer   = 1;
+	}
+	else if (!strcmp (arg, "--size"))
+	{
+	    if (sscanf (value, "%dx%d", &b->width, &b->height) != 2)
+	    {
+		fprintf (stderr, "%s: invalid size '%s'\n", argv[0], value);
+		return 0;
+	    }
+	}
+	else if (!strcmp (arg, "--pattern"))
+	{
+	    unsigned int j;
+
+	    for (j = 0; j < sizeof (patternNames) / sizeof (patternNames[0]); j++)
+		if (!strcmp (value, patternNames[j]))
+		    break;
+
+	    if (j == sizeof (patternNames) / sizeof (patternNames[0]))
+	    {
+		fprintf (stderr, "%s: unknown pattern '%s'\n", argv[0], value);
+		return 0;
+	    }
+
+	    b->pattern = (Pattern) j;
+	}
+	else
+	{
+	    fprintf (stderr, "%s: unknown option '%s'\n", argv[0], arg);
+	    return 0;
+	}
+
+	i++;
+    }
+
+    if (b->nWindows < 0 || b->nWindows > MAX_WINDOWS)
+    {
+	fprintf (stderr, "%s: number of windows must be between 0 and %d\n",
+		 argv[0], MAX_WINDOWS);
+	return 0;
+    }
+
+    if (b->duration <= 0)
+    {
+	fprintf (stderr, "%s: duration must be positive\n", argv[0]);
+	return 0;
+    }
+
+    return 1;
+}
+
+static Display *
+waitForDisplay (const char *name,
+		int        timeout)
+{
+    Display *dpy;
+    double  start = now ();
+
+    do {
+	dpy = XOpenDisplay (name);
+	if (dpy)
+	    return dpy;
+
+	usleep (50 * 1000);
+    } while (now () - start < timeout);
+
+    return NULL;
+}
+
+static int
+startServer (Bench *b)
+{
+    static char name[32];
+    char        screen[64];
+
+    snprintf (name, sizeof (name), ":%d", b->serverNumber);
+    snprintf (screen, sizeof (screen), "%dx%dx24", b->width, b->height);
+
+    b->serverPid = fork ();
+    if (b->serverPid == 0)
+    {
+	execlp ("Xvfb", "Xvfb", name,
+		"-screen", "0", screen,
+		"+extension", "GLX",
+		"+extension", "Composite",
+		"-nolisten", "tcp",
+		(char *) NULL);
+
+	fprintf (stderr, "compiz-bench: failed to run Xvfb: %s\n",
+		 strerror (errno));
+	_exit (1);
+    }
+    else if (b->serverPid < 0)
+    {
+	return 0;
+    }
+
+    b->displayName = name;
+
+    return 1;
+}
+
+static int
+startCompiz (Bench *b)
+{
+    char **argv;
+    char *plugins, *plugin;
+    int  argc = 0, n = 5;
+
+    for (plugin = (char *) b->plugins; *plugin; plugin++)
+	if (*plugin == ',')
+	    n++;
+
+    argv = calloc (n + 1, sizeof (char *));
+    plugins = strdup (b->plugins);
+    if (!argv || !plugins)
+	return 0;
+
+    argv[argc++] = (char *) b->compiz;
+    argv[argc++] = "--replace";
+    argv[argc++] = "--display";
+    argv[argc++] = (char *) b->displayName;
+
+    for (plugin = strtok (plugins, ","); plugin; plugin = strtok (NULL, ","))
+	argv[argc++] = plugin;
+
+    argv[argc] = NULL;
+
+    b->compizPid = fork ();
+    if (b->compizPid == 0)
+    {
+	setenv ("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+
+	execvp (b->compiz, argv);
+
+	fprintf (stderr, "compiz-bench: failed to run %s: %s\n",
+		 b->compiz, strerror (errno));
+	_exit (1);
+    }
+
+    free (argv);
+    free (plugins);
+
+    return b->compizPid > 0;
+}
+
+/* the composite plugin owns the _NET_WM_CM_Sn selection once
+   compositing is up */
+static int
+waitForCompositing (Bench *b,
+		    int   timeout)
+{
+    char   name[32];
+    Atom   cmAtom;
+    double start = now ();
+
+    snprintf (name, sizeof (name), "_NET_WM_CM_S%d", DefaultScreen (b->dpy));
+    cmAtom = XInternAtom (b->dpy, name, False);
+
+    do {
+	int status;
+
+	if (XGetSelectionOwner (b->dpy, cmAtom) != None)
+	    return 1;
+
+	if (waitpid (b->compizPid, &status, WNOHANG) == b->compizPid)
+	{
+	    b->compizPid = 0;
+	    return 0;
+	}
+
+	usleep (50 * 1000);
+    } while (now () - start < timeout);
+
+    return 0;
+}
+
+static void
+createWindow (Bench       *b,
+	      BenchWindow *bw,
+	      int         index)
+{
+    XSetWindowAttributes attr;
+    XSizeHints           hints;
+    int                  cols = 1, x, y, depth;
+    Visual               *visual;
+
+    while (cols * cols < b->nWindows)
+	cols++;
+
+    switch (bw->pattern) {
+    case PatternVideo:
+	bw->width  = 640;
+	bw->height = 360;
+	break;
+    case PatternSmall:
+	bw->width  = 300;
+	bw->height = 300;
+	break;
+    default:
+	bw->width  = 480;
+	bw->height = 320;
+	break;
+    }
+
+    /* spread the windows over the screen so that they overlap a bit
+       but do not fully occlude each other */
+    x = (index % cols) * (b->width - bw->width) / MAX (cols - 1, 1);
+    y = (index / cols) * (b->height - bw->height) / MAX (cols - 1, 1);
+
+    attr.background_pixel = WhitePixel (b->dpy, DefaultScreen (b->dpy));
+    attr.event_mask       = StructureNotifyMask | PropertyChangeMask;
+
+    bw->id = XCreateWindow (b->dpy, b->root, x, y, bw->width, bw->height, 0,
+			    CopyFromParent, InputOutput, CopyFromParent,
+			    CWBackPixel | CWEventMask, &attr);
+
+    hints.flags = PPosition | USPosition;
+    hints.x     = x;
+    hints.y     = y;
+    XSetWMNormalHints (b->dpy, bw->id, &hints);
+    XStoreName (b->dpy, bw->id, patternNames[bw->pattern]);
+
+    bw->gc = XCreateGC (b->dpy, bw->id, 0, NULL);
+
+    if (bw->pattern == PatternVideo)
+    {
+	visual = DefaultVisual (b->dpy, DefaultScreen (b->dpy));
+	depth  = DefaultDepth (b->dpy, DefaultScreen (b->dpy));
+
+	bw->image = XCreateImage (b->dpy, visual, depth, ZPixmap, 0,
+				  malloc (bw->width * bw->height * 4),
+				  bw->width, bw->height, 32, 0);
+    }
+
+    XMapWindow (b->dpy, bw->id);
+}
+
+static void
+updateWindow (Bench       *b,
+	      BenchWindow *bw)
+{
+    int i, x, y;
+
+    bw->tick++;
+
+    switch (bw->pattern) {
+    case PatternScroll:
+	/* like a terminal: scroll up one line and draw a new one */
+	XCopyArea (b->dpy, bw->id, bw->id, bw->gc, 0, 16,
+		   bw->width, bw->height - 16, 0, 0);
+	XSetForeground (b->dpy, bw->gc, (bw->tick * 0x10203) & 0xffffff);
+	XFillRectangle (b->dpy, bw->id, bw->gc, 0, bw->height - 16,
+			bw->width, 16);
+	break;
+    case PatternVideo:
+	if (bw->image)
+	{
+	    for (y = 0; y < bw->height; y++)
+		for (x = 0; x < bw->width; x++)
+		    XPutPixel (bw->image, x, y,
+			       ((x + bw->tick) ^ (y - bw->tick)) * 0x10101);
+
+	    XPutImage (b->dpy, bw->id, bw->gc, bw->image, 0, 0, 0, 0,
+		       bw->width, bw->height);
+	}
+	break;
+    case PatternSmall:
+	for (i = 0; i < 32; i++)
+	{
+	    XSetForeground (b->dpy, bw->gc, rand () & 0xffffff);
+	    XFillRectangle (b->dpy, bw->id, bw->gc,
+			    rand () % (bw->width - 8),
+			    rand () % (bw->height - 8), 8, 8);
+	}
+	break;
+    case PatternResize:
+	XResizeWindow (b->dpy, bw->id,
+		       bw->width + (bw->tick % 32) * 8,
+		       bw->height + (bw->tick % 32) * 4);
+	break;
+    default:
+	break;
+    }
+}
+
+static void
+sendProbe (Bench *b)
+{
+    XEvent ev;
+
+    memset (&ev, 0, sizeof (ev));
+
+    b->probeState = !b->probeState;
+
+    ev.xclient.type         = ClientMessage;
+    ev.xclient.window       = b->probe;
+    ev.xclient.message_type = b->wmStateAtom;
+    ev.xclient.format       = 32;
+    ev.xclient.data.l[0]    = b->probeState ? 1 : 0;
+    ev.xclient.data.l[1]    = b->wmStateSkipPagerAtom;
+    ev.xclient.data.l[3]    = 1;
+
+    XSendEvent (b->dpy, b->root, False,
+		SubstructureRedirectMask | SubstructureNotifyMask, &ev);
+    XFlush (b->dpy);
+
+    b->probeSent = now ();
+}
+
+static void
+handleEvent (Bench  *b,
+	     XEvent *event,
+	     int    measure)
+{
+    if (event->type == b->damageEvent + XDamageNotify)
+    {
+	double t = now ();
+
+	XDamageSubtract (b->dpy, b->rootDamage, None, None);
+
+	if (measure && b->lastFrame > 0.0)
+	    addSample (&b->frameTimes, t - b->lastFrame);
+
+	b->lastFrame = t;
+    }
+    else if (event->type == PropertyNotify &&
+	     event->xproperty.window == b->probe &&
+	     event->xproperty.atom == b->wmStateAtom)
+    {
+	if (measure && b->probeSent > 0.0)
+	    addSample (&b->latencies, now () - b->probeSent);
+
+	b->probeSent = 0.0;
+    }
+}
+
+static void
+run (Bench  *b,
+     double duration,
+     int    measure)
+{
+    double start = now (), nextTick = start, nextProbe = start;
+    int    i;
+
+    for (;;)
+    {
+	double         t = now ();
+	struct timeval tv;
+	fd_set         fds;
+	int            fd = ConnectionNumber (b->dpy);
+
+	if (t - start >= duration)
+	    break;
+
+	if (t >= nextTick)
+	{
+	    for (i = 0; i < b->nWindows; i++)
+		updateWindow (b, &b->windows[i]);
+
+	    XFlush (b->dpy);
+	    nextTick += TICK_MS;
+	}
+
+	/* only one probe in flight, a lost one is retried */
+	if (t >= nextProbe)
+	{
+	    sendProbe (b);
+	    nextProbe = t + PROBE_MS;
+	}
+
+	while (XPending (b->dpy))
+	{
+	    XEvent event;
+
+	    XNextEvent (b->dpy, &event);
+	    handleEvent (b, &event, measure);
+	}
+
+	t = now ();
+	if (nextTick > t)
+	{
+	    tv.tv_sec  = 0;
+	    tv.tv_usec = (long) ((nextTick - t) * 1000.0);
+
+	    FD_ZERO (&fds);
+	    FD_SET (fd, &fds);
+	    select (fd + 1, &fds, NULL, NULL, &tv);
+	}
+    }
+}
+
+static long
+readRss (pid_t pid)
+{
+    char path[64], line[256];
+    FILE *fp;
+    long rss = 0;
+
+    snprintf (path, sizeof (path), "/proc/%d/status", (int) pid);
+
+    fp = fopen (path, "r");
+    if (!fp)
+	return 0;
+
+    while (fgets (line, sizeof (line), fp))
+	if (sscanf (line, "VmRSS: %ld", &rss) == 1)
+	    break;
+
+    fclose (fp);
+
+    return rss;
+}
+
+static void
+writeSamples (FILE       *fp,
+	      const char *name,
+	      Samples    *s)
+{
+    double sum = 0.0;
+    int    i;
+
+    qsort (s->values, s->count, sizeof (double), compareDoubles);
+
+    for (i = 0; i < s->count; i++)
+	sum += s->values[i];
+
+    fprintf (fp,
+	     "  \"%s\": { \"samples\": %d, \"mean\": %.3f, "
+	     "\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n",
+	     name, s->count, s->count ? sum / s->count : 0.0,
+	     percentile (s, 50.0), percentile (s, 90.0), percentile (s, 99.0),
+	     s->count ? s->values[s->count - 1] : 0.0);
+}
+
+static int
+writeReport (Bench *b)
+{
+    FILE *fp = stdout;
+
+    if (b->output)
+    {
+	fp = fopen (b->output, "w");
+	if (!fp)
+	{
+	    fprintf (stderr, "compiz-bench: can't write %s: %s\n",
+		     b->output, strerror (errno));
+	    return 0;
+	}
+    }
+
+    fprintf (fp, "{\n");
+    fprintf (fp, "  \"plugins\": \"%s\",\n", b->plugins);
+    fprintf (fp, "  \"pattern\": \"%s\",\n", patternNames[b->pattern]);
+    fprintf (fp, "  \"windows\": %d,\n", b->nWindows);
+    fprintf (fp, "  \"duration\": %d,\n", b->duration);
+    fprintf (fp, "  \"fps\": %.2f,\n",
+	     (b->frameTimes.count + 1) / (double) b->duration);
+    writeSamples (fp, "frame_time_ms", &b->frameTimes);
+    writeSamples (fp, "event_latency_ms", &b->latencies);
+    fprintf (fp, "  \"rss_kb\": %ld\n", b->rss);
+    fprintf (fp, "}\n");
+
+    if (fp != stdout)
+	fclose (fp);
+
+    return 1;
+}
+
+static void
+stopChild (pid_t pid)
+{
+    if (pid <= 0)
+	return;
+
+    kill (pid, SIGTERM);
+    waitpid (pid, NULL, 0);
+}
+
+int
+main (int  argc,
+      char **argv)
+{
+    Bench                b;
+    XSetWindowAttributes attr;
+    int                  i, status = 1;
+
+    memset (&b, 0, sizeof (b));
+
+    b.compiz       = "compiz";
+    b.plugins      = "composite,opengl";
+    b.serverNumber = 99;
+    b.nWindows     = 8;
+    b.pattern      = PatternMixed;
+    b.duration     = 10;
+    b.width        = 1280;
+    b.height       = 1024;
+
+    if (!parseArguments (&b, argc, argv))
+	return 1;
+
+    if (!b.useServer && !startServer (&b))
+    {
+	fprintf (stderr, "compiz-bench: failed to start Xvfb\n");
+	return 1;
+    }
+
+    b.dpy = waitForDisplay (b.displayName, 10000);
+    if (!b.dpy)
+    {
+	fprintf (stderr, "compiz-bench: can't open display %s\n",
+		 b.displayName);
+	goto out;
+    }
+
+    b.root = DefaultRootWindow (b.dpy);
+
+    if (!XDamageQueryExtension (b.dpy, &b.damageEvent, &b.damageError))
+    {
+	fprintf (stderr, "compiz-bench: no damage extension\n");
+	goto out;
+    }
+
+    if (!startCompiz (&b) || !waitForCompositing (&b, 20000))
+    {
+	fprintf (stderr, "compiz-bench: compiz failed to start compositing\n");
+	goto out;
+    }
+
+    b.wmStateAtom          = XInternAtom (b.dpy, "_NET_WM_STATE", False);
+    b.wmStateSkipPagerAtom = XInternAtom (b.dpy, "_NET_WM_STATE_SKIP_PAGER",
+					  False);
+
+    attr.event_mask = PropertyChangeMask;
+    b.probe = XCreateWindow (b.dpy, b.root, 0, 0, 16, 16, 0,
+			     CopyFromParent, InputOutput, CopyFromParent,
+			     CWEventMask, &attr);
+    XMapWindow (b.dpy, b.probe);
+
+    for (i = 0; i < b.nWindows; i++)
+    {
+	if (b.pattern == PatternMixed)
+	    b.windows[i].pattern = (Pattern) (i % PatternMixed);
+	else
+	    b.windows[i].pattern = b.pattern;
+
+	createWindow (&b, &b.windows[i], i);
+    }
+
+    b.rootDamage = XDamageCreate (b.dpy, b.root, XDamageReportNonEmpty);
+
+    run (&b, WARMUP_MS, 0);
+    run (&b, b.duration * 1000.0, 1);
+
+    b.rss = readRss (b.compizPid);
+
+    if (writeReport (&b))
+	status = 0;
+
+out:
+    stopChild (b.compizPid);
+
+    if (b.dpy)
+	XCloseDisplay (b.dpy);
+
+    if (!b.useServer)
+	stopChild (b.serverPid);
+
+    return status;
+}
@@ -0,0 +1,569 @@
+/*
+ * Copyright © 2011 compiz contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * copyright holders not be used in advertising or publicity pertaining
+ * to distribution of the software without specific, written prior
+ * permission. The copyright holders make no representations about the
+ * suitability of this software for any purpose. It is provided "as is"
+ * without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * place-bench places windows one after the other on a screen with
+ * random windows, with the smart and the cascade placement of the
+ * place plugin and with the per window scans they replaced, and
+ * reports the time per placement of both and how many placements
+ * differ, which should be none.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include <list>
+#include <vector>
+
+#include "smart.h"
+#include "cascade.h"
+
+#define SCREEN_WIDTH  1920
+#define SCREEN_HEIGHT 1200
+
+#define PANEL_HEIGHT 24
+#define BORDER_LEFT  4
+#define BORDER_TOP   24
+
+#define CASCADE_FUZZ     15
+#define CASCADE_INTERVAL 50
+
+#define NONE    0
+#define H_WRONG -1
+#define W_WRONG -2
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+static double
+now ()
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, 0);
+
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/* the placement the plugin used before, with the window list replaced
+   by the same extents placeSmartFit gets */
+static void
+placeSmartReference (const std::vector<PlaceSmartWindow> &windows,
+		     int                                 areaX,
+		     int                                 areaY,
+		     int                                 areaRight,
+		     int                                 areaBottom,
+		     int                                 cw,
+		     int                                 ch,
+		     int                                 *x,
+		     int                                 *y)
+{
+    int overlap, minOverlap = 0;
+    int xOptimal, yOptimal;
+    int possible;
+    int cxl, cxr, cyt, cyb;
+    int xl,  xr,  yt,  yb;
+    int basket;
+    bool firstPass = true;
+    int xTmp = areaX;
+    int yTmp = areaY;
+
+    xOptimal = xTmp;
+    yOptimal = yTmp;
+
+    do
+    {
+	if (yTmp + ch > areaBottom && ch < areaBottom - areaY)
+	    overlap = H_WRONG;
+	else if (xTmp + cw > areaRight)
+	    overlap = W_WRONG;
+	else
+	{
+	    overlap = NONE;
+
+	    cxl = xTmp;
+	    cxr = xTmp + cw;
+	    cyt = yTmp;
+	    cyb = yTmp + ch;
+
+	    for (unsigned int i = 0; i < windows.size (); i++)
+	    {
+		xl = windows[i].x1;
+		yt = windows[i].y1;
+		xr = windows[i].x2;
+		yb = windows[i].y2;
+
+		if (cxl < xr && cxr > xl && cyt < yb && cyb > yt)
+		{
+		    xl = MAX (cxl, xl);
+		    xr = MIN (cxr, xr);
+		    yt = MAX (cyt, yt);
+		    yb = MIN (cyb, yb);
+
+		    overlap += windows[i].weight * (xr - xl) * (yb - yt);
+		}
+	    }
+	}
+
+	if (overlap == NONE)
+	{
+	    xOptimal = xTmp;
+	    yOptimal = yTmp;
+	    break;
+	}
+
+	if (firstPass)
+	{
+	    firstPass  = false;
+	    minOverlap = overlap;
+	}
+	else if (overlap >= NONE && overlap < minOverlap)
+	{
+	    minOverlap = overlap;
+	    xOptimal = xTmp;
+	    yOptimal = yTmp;
+	}
+
+	if (overlap > NONE)
+	{
+	    possible = areaRight;
+
+	    if (possible - cw > xTmp)
+		possible -= cw;
+
+	    for (unsigned int i = 0; i < windows.size (); i++)
+	    {
+		xl = windows[i].x1;
+		yt = windows[i].y1;
+		xr = windows[i].x2;
+		yb = windows[i].y2;
+
+		if (yTmp < yb && yt < ch + yTmp)
+		{
+		    if (xr > xTmp && possible > xr)
+			possible = xr;
+
+		    basket = xl - cw;
+		    if (basket > xTmp && possible > basket)
+			possible = basket;
+		}
+	    }
+	    xTmp = possible;
+	}
+	else if (overlap == W_WRONG)
+	{
+	    xTmp     = areaX;
+	    possible = areaBottom;
+
+	    if (possible - ch > yTmp)
+		possible -= ch;
+
+	    for (unsigned int i = 0; i < windows.size (); i++)
+	    {
+		yt = windows[i].y1;
+		yb = windows[i].y2;
+
+		if (yb > yTmp && possible > yb)
+		    possible = yb;
+
+		basket = yt - ch;
+		if (basket > yTmp && possible > basket)
+		    possible = basket;
+	    }
+	    yTmp = possible;
+	}
+    }
+    while (overlap != NONE && overlap != H_WRONG && yTmp < areaBottom);
+
+    if (ch >= areaBottom - areaY)
+	yOptimal = areaY;
+
+    *x = xOptimal;
+    *y = yOptimal;
+}
+
+/* the cascade placement the plugin used before, with the window list
+   replaced by the same extents PlaceCascadeIndex gets, the sort
+   functions ordering windows with the same edges by stacking order
+   and windows overlapping if they intersect like it does */
+static const std::vector<PlaceCascadeWindow> *sortWindows;
+
+static bool
+compareLeftmost (int a,
+		 int b)
+{
+    const PlaceCascadeWindow &wa = (*sortWindows)[a], &wb = (*sortWindows)[b];
+
+    if (wa.x1 != wb.x1)
+	return wa.x1 < wb.x1;
+
+    return wa.y1 < wb.y1 || (wa.y1 == wb.y1 && a < b);
+}
+
+static bool
+compareTopmost (int a,
+		int b)
+{
+    const PlaceCascadeWindow &wa = (*sortWindows)[a], &wb = (*sortWindows)[b];
+
+    if (wa.y1 != wb.y1)
+	return wa.y1 < wb.y1;
+
+    return wa.x1 < wb.x1 || (wa.x1 == wb.x1 && a < b);
+}
+
+static bool
+compareNorthWestCorner (int a,
+			int b)
+{
+    const PlaceCascadeWindow &wa = (*sortWindows)[a], &wb = (*sortWindows)[b];
+    int                      fromOriginA, fromOriginB;
+
+    fromOriginA = sqrt (wa.x1 * wa.x1 + wa.y1 * wa.y1);
+    fromOriginB = sqrt (wb.x1 * wb.x1 + wb.y1 * wb.y1);
+
+    if (fromOriginA != fromOriginB)
+	return fromOriginA < fromOriginB;
+
+    return a < b;
+}
+
+static bool
+rectOverlapsWindow (int                                   x,
+		    int                                   y,
+		    int                                   width,
+		    int                                   height,
+		    const std::vector<PlaceCascadeWindow> &windows)
+{
+    for (unsigned int i = 0; i < windows.size (); i++)
+    {
+	const PlaceCascadeWindow &w = windows[i];
+
+	if (w.obstacle &&
+	    MAX (x, w.x1) < MIN (x + width, w.x2) &&
+	    MAX (y, w.y1) < MIN (y + height, w.y2))
+	    return true;
+    }
+
+    return false;
+}
+
+static void
+placeCascadeReference (const std::vector<PlaceCascadeWindow> &windows,
+		       int                                   areaX,
+		       int                                   areaY,
+		       int                                   areaRight,
+		       int                                   areaBottom,
+		       int                                   width,
+		       int                                   height,
+		       int                                   clientWidth,
+		       int                                   clientHeight,
+		       int                                   *px,
+		       int                                   *py)
+{
+    std::list<int> sorted, belowSorted, rightSorted;
+    int            x, y, cascadeX, cascadeY, cascadeStage;
+
+    for (unsigned int i = 0; i < windows.size (); i++)
+	sorted.push_back (i);
+
+    sortWindows = &windows;
+
+    belowSorted = sorted;
+    belowSorted.sort (compareTopmost);
+
+    rightSorted = sorted;
+    rightSorted.sort (compareLeftmost);
+
+    x = areaX + ((areaRight - areaX) % (width + 1)) / 2;
+    y = areaY + ((areaBottom - areaY) % (height + 1)) / 3;
+
+#define FITS(x, y) ((x) >= areaX && (x) + width <= areaRight &&		\
+		    (y) >= areaY && (y) + height <= areaBottom &&	\
+		    !rectOverlapsWindow (x, y, width, height, windows))
+
+    if (FITS (x, y))
+    {
+	*px = x;
+	*py = y;
+	return;
+    }
+
+    for (std::list<int>::iterator iter = belowSorted.begin ();
+	 iter != belowSorted.end (); iter++)
+    {
+	x = windows[*iter].x1;
+	y = windows[*iter].y2;
+
+	if (FITS (x, y))
+	{
+	    *px = x;
+	    *py = y;
+	    return;
+	}
+    }
+
+    for (std::list<int>::iterator iter = rightSorted.begin ();
+	 iter != rightSorted.end (); iter++)
+    {
+	x = windows[*iter].x2;
+	y = windows[*iter].y1;
+
+	if (FITS (x, y))
+	{
+	    *px = x;
+	    *py = y;
+	    return;
+	}
+    }
+
+    sorted.sort (compareNorthWestCorner);
+
+    cascadeX = MAX (0, areaX);
+    cascadeY = MAX (0, areaY);
+    cascadeStage = 0;
+
+    for (std::list<int>::iterator iter = sorted.begin ();
+	 iter != sorted.end (); iter++)
+    {
+	const PlaceCascadeWindow &w = windows[*iter];
+
+	if (abs (w.x1 - cascadeX) < MAX (BORDER_LEFT, CASCADE_FUZZ) &&
+	    abs (w.y1 - cascadeY) < MAX (BORDER_TOP, CASCADE_FUZZ))
+	{
+	    cascadeX = w.x;
+	    cascadeY = w.y;
+
+	    if ((cascadeX + clientWidth > areaRight) ||
+		(cascadeY + clientHeight > areaBottom))
+	    {
+		cascadeX = MAX (0, areaX);
+		cascadeY = MAX (0, areaY);
+
+		cascadeStage += 1;
+		cascadeX += CASCADE_INTERVAL * cascadeStage;
+
+		if (cascadeX + clientWidth < areaRight)
+		{
+		    iter = sorted.begin ();
+		    continue;
+		}
+		else
+		{
+		    cascadeX = MAX (0, areaX);
+		    break;
+		}
+	    }
+	}
+    }
+
+    *px = cascadeX;
+    *py = cascadeY;
+}
+
+static PlaceSmartWindow
+randomWindow ()
+{
+    PlaceSmartWindow w;
+    int              r = rand () % 20;
+
+    w.x1 = rand () % SCREEN_WIDTH - 100;
+    w.y1 = rand () % SCREEN_HEIGHT - 100;
+    w.x2 = w.x1 + 100 + rand () % 900;
+    w.y2 = w.y1 + 80 + rand () % 700;
+    w.weight = r == 0 ? 16 : r == 1 ? 0 : 1;
+
+    return w;
+}
+
+/* a decorated window of a session being restored, every tenth is a
+   dialog that others may overlap */
+static PlaceCascadeWindow
+randomCascadeWindow (int x,
+		     int y)
+{
+    PlaceCascadeWindow w;
+
+    w.x  = x;
+    w.y  = y;
+    w.x1 = x - BORDER_LEFT;
+    w.y1 = y - BORDER_TOP;
+    w.x2 = x + 100 + rand () % 300 + BORDER_LEFT;
+    w.y2 = y + 80 + rand () % 250 + BORDER_LEFT;
+    w.obstacle = rand () % 10 != 0;
+
+    return w;
+}
+
+/* Places a burst of nWindows windows with both cascade placements and
+   returns how many placements differ */
+static int
+benchCascade (int    nWindows,
+	      int    nRuns,
+	      double *refTime,
+	      double *indexTime)
+{
+    PlaceCascadeIndex index;
+    int               differences = 0;
+    double            start;
+
+    for (int run = 0; run < nRuns; run++)
+    {
+	std::vector<PlaceCascadeWindow> windows;
+
+	for (int i = 0; i < nWindows; i++)
+	{
+	    PlaceCascadeWindow w = randomCascadeWindow (0, 0);
+	    int                width = w.x2 - w.x1, height = w.y2 - w.y1;
+	    int                rx, ry, cx, cy;
+
+	    start = now ();
+	    placeCascadeReference (windows, 0, PANEL_HEIGHT, SCREEN_WIDTH,
+				   SCREEN_HEIGHT, width, height,
+				   w.x2 - w.x - BORDER_LEFT, w.y2 - w.y -
+				   BORDER_LEFT, &rx, &ry);
+	    *refTime += now () - start;
+
+	    start = now ();
+	    index.update (windows);
+	    if (!index.firstFit (0, PANEL_HEIGHT, SCREEN_WIDTH,
+				 SCREEN_HEIGHT, width, height, &cx, &cy))
+		index.next (0, PANEL_HEIGHT, SCREEN_WIDTH,
+			    SCREEN_HEIGHT, w.x2 - w.x - BORDER_LEFT,
+			    w.y2 - w.y - BORDER_LEFT,
+			    MAX (BORDER_LEFT, CASCADE_FUZZ),
+			    MAX (BORDER_TOP, CASCADE_FUZZ), &cx, &cy);
+	    *indexTime += now () - start;
+
+	    if (rx != cx || ry != cy)
+	    {
+		differences++;
+		fprintf (stderr, "run %d cascade window %d: %d,%d instead "
+			 "of %d,%d\n", run, i, cx, cy, rx, ry);
+	    }
+
+	    w.x1 += rx;
+	    w.y1 += ry;
+	    w.x2 += rx;
+	    w.y2 += ry;
+	    w.x  += rx + BORDER_LEFT;
+	    w.y  += ry + BORDER_TOP;
+
+	    windows.push_back (w);
+	}
+    }
+
+    return differences;
+}
+
+int
+main (int  argc,
+      char **argv)
+{
+    int            nWindows = argc > 1 ? atoi (argv[1]) : 50;
+    int            nRuns = argc > 2 ? atoi (argv[2]) : 20;
+    int            nCascade = argc > 3 ? atoi (argv[3]) : 200;
+    double         start, refTime = 0.0, smartTime = 0.0;
+    double         cascadeRefTime = 0.0, cascadeTime = 0.0;
+    int            differences = 0;
+    PlaceOccupancy occupancy;
+
+    if (nWindows <= 0 || nRuns <= 0 || nCascade <= 0)
+    {
+	fprintf (stderr, "Usage: %s [WINDOWS] [RUNS] [CASCADED WINDOWS]\n",
+		 argv[0]);
+	return 1;
+    }
+
+    srand (1);
+
+    for (int run = 0; run < nRuns; run++)
+    {
+	std::vector<PlaceSmartWindow> refWindows, smartWindows;
+
+	/* a few windows that were there before, then a burst of new
+	   ones placed one after the other like at login */
+	for (int i = 0; i < 5; i++)
+	    refWindows.push_back (randomWindow ());
+
+	smartWindows = refWindows;
+
+	for (int i = 0; i < nWindows; i++)
+	{
+	    PlaceSmartWindow w = randomWindow ();
+	    int              cw = w.x2 - w.x1 - 1, ch = w.y2 - w.y1 - 1;
+	    int              rx, ry, sx, sy;
+
+	    start = now ();
+	    placeSmartReference (refWindows, 0, 0, SCREEN_WIDTH,
+				 SCREEN_HEIGHT, cw, ch, &rx, &ry);
+	    refTime += now () - start;
+
+	    start = now ();
+	    placeSmartFit (occupancy, smartWindows, 0, 0, SCREEN_WIDTH,
+			   SCREEN_HEIGHT, cw, ch, &sx, &sy);
+	    smartTime += now () - start;
+
+	    if (rx != sx || ry != sy)
+	    {
+		differences++;
+		fprintf (stderr, "run %d window %d: %d,%d instead of %d,%d\n",
+			 run, i, sx, sy, rx, ry);
+	    }
+
+	    /* keep both screens the same */
+	    w.x2 = rx + cw + 1;
+	    w.y2 = ry + ch + 1;
+	    w.x1 = rx;
+	    w.y1 = ry;
+
+	    refWindows.push_back (w);
+	    smartWindows.push_back (w);
+	}
+    }
+
+    printf ("%d runs of %d placements\n", nRuns, nWindows);
+    printf ("window scan:     %8.1f us per placement\n",
+	    refTime * 1e3 / ((double) nRuns * nWindows));
+    printf ("occupancy table: %8.1f us per placement\n",
+	    smartTime * 1e3 / ((double) nRuns * nWindows));
+
+    differences += benchCascade (nCascade, nRuns, &cascadeRefTime,
+				 &cascadeTime);
+
+    printf ("%d runs of %d cascaded placements\n", nRuns, nCascade);
+    printf ("window scan:     %8.1f us per placement\n",
+	    cascadeRefTime * 1e3 / ((double) nRuns * nCascade));
+    printf ("cascade index:   %8.1f us per placement\n",
+	    cascadeTime * 1e3 / ((double) nRuns * nCascade));
+    printf ("%d placements differ\n", differences);
+
+    return differences ? 1 : 0;
+}
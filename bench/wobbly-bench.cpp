@@ -0,0 +1,288 @@
+/*
+ * Copyright © 2011 compiz contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * copyright holders not be used in advertising or publicity pertaining
+ * to distribution of the software without specific, written prior
+ * permission. The copyright holders make no representations about the
+ * suitability of this software for any purpose. It is provided "as is"
+ * without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * wobbly-bench steps N wobbly spring models M times with the solver of
+ * the wobbly plugin and with the per object solver it replaced, and
+ * reports the time per model step of both and the largest difference
+ * between the object positions they arrive at.
+ *
+ * Edge snapping is not part of the comparison, the plugin runs the
+ * same per object code for snapped objects with either solver.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include "solver.h"
+
+#define GRID_WIDTH  4
+#define GRID_HEIGHT 4
+#define NUM_OBJECTS (GRID_WIDTH * GRID_HEIGHT)
+
+#define FRICTION 3.0f
+#define SPRING_K 8.0f
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+/* the object and spring layout the plugin used before */
+struct RefObject {
+    Vector force;
+    Point  position;
+    Vector velocity;
+    bool   immobile;
+};
+
+struct RefSpring {
+    RefObject *a;
+    RefObject *b;
+    Vector    offset;
+};
+
+struct RefModel {
+    RefObject objects[NUM_OBJECTS];
+    RefSpring springs[NUM_OBJECTS * 2];
+    int       numSprings;
+};
+
+struct SoaModel {
+    Point  positions[NUM_OBJECTS];
+    Vector velocities[NUM_OBJECTS];
+    Vector forces[NUM_OBJECTS];
+    bool   immobile[NUM_OBJECTS];
+    Vector scratch[GRID_WIDTH];
+    float  hpad, vpad;
+};
+
+static double
+now ()
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, 0);
+
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static void
+initModels (RefModel &ref,
+	    SoaModel &soa,
+	    int      seed)
+{
+    float width = 400 + seed % 300, height = 300 + seed % 200;
+    int   anchor = GRID_WIDTH * ((GRID_HEIGHT - 1) / 2) +
+		   (GRID_WIDTH - 1) / 2;
+
+    srand (seed);
+
+    soa.hpad = width / (GRID_WIDTH - 1);
+    soa.vpad = height / (GRID_HEIGHT - 1);
+
+    for (int i = 0; i < NUM_OBJECTS; i++)
+    {
+	RefObject &o = ref.objects[i];
+
+	o.position.x = (i % GRID_WIDTH) * soa.hpad;
+	o.position.y = (i / GRID_WIDTH) * soa.vpad;
+	o.velocity.x = (rand () % 200 - 100) / 10.0f;
+	o.velocity.y = (rand () % 200 - 100) / 10.0f;
+	o.force.x    = 0.0f;
+	o.force.y    = 0.0f;
+	o.immobile   = i == anchor;
+
+	soa.positions[i]  = o.position;
+	soa.velocities[i] = o.velocity;
+	soa.forces[i]     = o.force;
+	soa.immobile[i]   = o.immobile;
+    }
+
+    ref.numSprings = 0;
+    for (int i = 0; i < NUM_OBJECTS; i++)
+    {
+	if (i % GRID_WIDTH)
+	{
+	    RefSpring &s = ref.springs[ref.numSprings++];
+
+	    s.a = &ref.objects[i - 1];
+	    s.b = &ref.objects[i];
+	    s.offset.x = soa.hpad;
+	    s.offset.y = 0.0f;
+	}
+
+	if (i >= GRID_WIDTH)
+	{
+	    RefSpring &s = ref.springs[ref.numSprings++];
+
+	    s.a = &ref.objects[i - GRID_WIDTH];
+	    s.b = &ref.objects[i];
+	    s.offset.x = 0.0f;
+	    s.offset.y = soa.vpad;
+	}
+    }
+}
+
+static float
+stepReference (RefModel &model)
+{
+    float velocitySum = 0.0f;
+
+    for (int i = 0; i < model.numSprings; i++)
+    {
+	RefSpring &s = model.springs[i];
+	Vector    da, db;
+
+	da.x = 0.5f * (s.b->position.x - s.a->position.x - s.offset.x);
+	da.y = 0.5f * (s.b->position.y - s.a->position.y - s.offset.y);
+
+	db.x = 0.5f * (s.a->position.x - s.b->position.x + s.offset.x);
+	db.y = 0.5f * (s.a->position.y - s.b->position.y + s.offset.y);
+
+	s.a->force.x += SPRING_K * da.x;
+	s.a->force.y += SPRING_K * da.y;
+	s.b->force.x += SPRING_K * db.x;
+	s.b->force.y += SPRING_K * db.y;
+    }
+
+    for (int i = 0; i < NUM_OBJECTS; i++)
+    {
+	RefObject &o = model.objects[i];
+
+	if (o.immobile)
+	{
+	    o.velocity.x = o.velocity.y = 0.0f;
+	    o.force.x = o.force.y = 0.0f;
+	    continue;
+	}
+
+	o.force.x -= FRICTION * o.velocity.x;
+	o.force.y -= FRICTION * o.velocity.y;
+
+	o.velocity.x += o.force.x / MASS;
+	o.velocity.y += o.force.y / MASS;
+
+	o.position.x += o.velocity.x;
+	o.position.y += o.velocity.y;
+
+	o.force.x = o.force.y = 0.0f;
+
+	velocitySum += fabs (o.velocity.x) + fabs (o.velocity.y);
+    }
+
+    return velocitySum;
+}
+
+static float
+stepSoa (SoaModel &model)
+{
+    float velocitySum = 0.0f, forceSum = 0.0f;
+
+    modelSpringForces (model.positions, model.forces, model.scratch,
+		       GRID_WIDTH, GRID_HEIGHT, model.hpad, model.vpad,
+		       SPRING_K);
+
+    for (int i = 0; i < NUM_OBJECTS;)
+    {
+	int n = 0;
+
+	while (i + n < NUM_OBJECTS && !model.immobile[i + n])
+	    n++;
+
+	if (n)
+	{
+	    velocitySum += modelIntegrate (&model.positions[i],
+					   &model.velocities[i],
+					   &model.forces[i],
+					   n, FRICTION, &forceSum);
+	    i += n;
+	}
+	else
+	{
+	    model.velocities[i].x = model.velocities[i].y = 0.0f;
+	    model.forces[i].x = model.forces[i].y = 0.0f;
+	    i++;
+	}
+    }
+
+    return velocitySum;
+}
+
+int
+main (int  argc,
+      char **argv)
+{
+    int    nModels = argc > 1 ? atoi (argv[1]) : 64;
+    int    nSteps = argc > 2 ? atoi (argv[2]) : 10000;
+    double start, refTime, soaTime;
+    float  sum = 0.0f, maxDiff = 0.0f;
+
+    if (nModels <= 0 || nSteps <= 0)
+    {
+	fprintf (stderr, "Usage: %s [MODELS] [STEPS]\n", argv[0]);
+	return 1;
+    }
+
+    std::vector<RefModel> ref (nModels);
+    std::vector<SoaModel> soa (nModels);
+
+    for (int i = 0; i < nModels; i++)
+	initModels (ref[i], soa[i], i);
+
+    start = now ();
+    for (int j = 0; j < nSteps; j++)
+	for (int i = 0; i < nModels; i++)
+	    sum += stepReference (ref[i]);
+    refTime = now () - start;
+
+    start = now ();
+    for (int j = 0; j < nSteps; j++)
+	for (int i = 0; i < nModels; i++)
+	    sum += stepSoa (soa[i]);
+    soaTime = now () - start;
+
+    for (int i = 0; i < nModels; i++)
+    {
+	for (int j = 0; j < NUM_OBJECTS; j++)
+	{
+	    maxDiff = MAX (maxDiff, fabs (ref[i].objects[j].position.x -
+					  soa[i].positions[j].x));
+	    maxDiff = MAX (maxDiff, fabs (ref[i].objects[j].position.y -
+					  soa[i].positions[j].y));
+	}
+    }
+
+    printf ("%d models x %d steps\n", nModels, nSteps);
+    printf ("per object solver: %8.1f ns per model step\n",
+	    refTime * 1e6 / ((double) nModels * nSteps));
+    printf ("array solver:      %8.1f ns per model step\n",
+	    soaTime * 1e6 / ((double) nModels * nSteps));
+    printf ("largest position difference: %g pixels\n", maxDiff);
+
+    /* keep the velocity sums from being optimized away */
+    return sum < 0.0f ? 1 : 0;
+}
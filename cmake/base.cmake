@@ -28,6 +28,7 @@ function (_print_configure_results)
     compiz_print_result_message ("gconf schemas" USE_GCONF)
     compiz_print_result_message ("gnome" USE_GNOME)
     compiz_print_result_message ("kde4 window decorator" USE_KDE4)
+    compiz_print_result_message ("compiz-bench" USE_BENCH)
 
     compiz_print_configure_footer ()
     compiz_print_plugin_stats ("${CMAKE_SOURCE_DIR}/plugins")
@@ -190,6 +190,10 @@ main (int argc, char *argv[])
 	    }
 	    cmdline_options |= CMDLINE_BLUR;
 	}
+	else if (strcmp (argv[i], "--client-shadow-blur") == 0)
+	{
+	    decor_shadow_set_client_blur (1);
+	}
 
 #ifdef USE_METACITY
 	else if (strcmp (argv[i], "--opacity") == 0)
@@ -228,6 +232,7 @@ main (int argc, char *argv[])
 		     "[--minimal] "
 		     "[--replace] "
 		     "[--blur none|titlebar|all] "
+		     "[--client-shadow-blur] "
 
 #ifdef USE_METACITY
 		     "[--opacity OPACITY] "
@@ -27,7 +27,7 @@
 #define _COMPIZ_CORE_H
 
 
-#define CORE_ABIVERSION 20110322
+#define CORE_ABIVERSION 20110419
 
 #include <stdio.h>
 #include <assert.h>
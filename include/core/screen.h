@@ -71,6 +71,26 @@ typedef boost::function<void (const char *)> FileWatchCallBack;
 typedef int CompFileWatchHandle;
 typedef int CompWatchFdHandle;
 
+/**
+ * Decodes the image in file, which exists, at its natural size or at
+ * the requested size if it is not empty and the format is scalable.
+ * Returns premultiplied ARGB32 data with a stride of width * 4 that the
+ * caller frees with free (). Decoders run on the image loading thread,
+ * possibly at the same time as on the main thread.
+ */
+typedef boost::function<bool (const CompString &, const CompSize &,
+			      CompSize &, void *&)> ImageDecodeProc;
+
+/**
+ * Receives the result of CompScreen::readImageFromFileAsync on the main
+ * thread. The callee owns the data and frees it with free ().
+ */
+typedef boost::function<void (bool, const CompSize &, void *)>
+    ImageLoadCallBack;
+
+typedef int CompImageDecoderHandle;
+typedef int CompImageLoadHandle;
+
 /**
  * Information needed to invoke a CallBack when a file changes.
  */
@@ -220,6 +240,18 @@ class CompScreen :
 			       CompSize   &size,
 			       void       *data);
 
+	CompImageLoadHandle readImageFromFileAsync (CompString        &name,
+						    CompString        &pname,
+						    const CompSize    &request,
+						    ImageLoadCallBack callBack);
+
+	void cancelImageLoad (CompImageLoadHandle handle);
+
+	CompImageDecoderHandle registerImageDecoder (const CompString &extension,
+						     ImageDecodeProc  proc);
+
+	void unregisterImageDecoder (CompImageDecoderHandle handle);
+
 	unsigned int getWindowProp (Window       id,
 				    Atom         property,
 				    unsigned int defaultValue);
@@ -292,6 +324,11 @@ class CompScreen :
 	 * by anything (another application, pluigins etc) */
 	bool grabbed ();
 
+	/* Sends the positions deferred with CompWindow::deferSyncPosition
+	 * to the server. Compositing plugins call this once per frame,
+	 * otherwise it happens from a timer */
+	void flushDeferredConfigures ();
+
 	const CompWindowVector & clientList (bool stackingOrder = true);
 
 	bool addAction (CompAction *action);
@@ -423,6 +423,11 @@ class CompWindow :
 
 	void syncPosition ();
 
+	/* Like syncPosition, but the position is only sent to the server
+	   when deferred configure requests are flushed, at most once per
+	   frame. Painting uses the new position right away. */
+	void deferSyncPosition ();
+
 	void moveInputFocusTo ();
 
 	void moveInputFocusToOtherWindow ();
@@ -338,6 +338,12 @@ decor_shadow_destroy (Display	     *xdisplay,
 void
 decor_shadow_reference (decor_shadow_t *shadow);
 
+/* Blur shadows on the client and upload them once instead of running
+   the convolution on the server. Shadows are always blurred on the
+   client when the server has no convolution filter. */
+void
+decor_shadow_set_client_blur (int client_blur);
+
 void
 decor_shadow (Display	     *xdisplay,
 		      decor_shadow_t *shadow);
@@ -51,6 +51,8 @@ main (int argc, char **argv)
     options.add ("replace", ki18n ("Replace existing window decorator"));
     options.add ("sm-disable", ki18n ("Disable connection to session manager"));
     options.add ("blur <type>", ki18n ("Blur type (none,titlebar,all)"), "none");
+    options.add ("client-shadow-blur",
+		 ki18n ("Blur shadows in the decorator instead of the X server"));
     KAboutData about("kde-window-decorator", "kwin", ki18n ("KDE Window Decorator"),
                      "0.0.1", KLocalizedString(), KAboutData::License_GPL,
                      KLocalizedString(), KLocalizedString(), "http://www.compiz.org", 
@@ -73,6 +75,9 @@ main (int argc, char **argv)
 	    blurType = BLUR_TYPE_ALL;
     }
 
+    if (args->isSet ("client-shadow-blur"))
+	decor_shadow_set_client_blur (1);
+
     app = new KWD::Decorator ();
 
     if (args->isSet ("sm-disable"))
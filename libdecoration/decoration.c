@@ -27,10 +27,15 @@
 #include <stdlib.h>
 #include <math.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <decoration.h>
 
 #include <X11/Xatom.h>
 #include <X11/Xregion.h>
+#include <X11/Xutil.h>
 
 int
 decor_version (void)
@@ -1228,6 +1233,256 @@ create_gaussian_kernel (double radius,
 #define SIGMA(r) ((r) / 2.0)
 #define ALPHA(r) (r)
 
+/*
+ * Shadows drawn with decor_draw_simple only depend on the arguments of
+ * decor_shadow_create, so they are kept in a list while referenced
+ * and handed out again for the same arguments. Decorators create the
+ * same few shadows over and over when the theme or the options
+ * change.
+ */
+typedef struct _decor_shadow_entry {
+    decor_shadow_t		shadow;
+    Display			*xdisplay;
+    Screen			*screen;
+    int				width, height;
+    int				left, right, top, bottom;
+    int				solid_left, solid_right;
+    int				solid_top, solid_bottom;
+    decor_shadow_options_t	opt;
+    int				client_blur;
+    int				cached;
+    struct _decor_shadow_entry	*next;
+} decor_shadow_entry_t;
+
+static decor_shadow_entry_t *shadow_cache = NULL;
+
+static int shadow_client_blur = 0;
+
+void
+decor_shadow_set_client_blur (int client_blur)
+{
+    shadow_client_blur = client_blur;
+}
+
+static int
+shadow_options_equal (const decor_shadow_options_t *a,
+		      const decor_shadow_options_t *b)
+{
+    return a->shadow_radius   == b->shadow_radius   &&
+	   a->shadow_opacity  == b->shadow_opacity  &&
+	   a->shadow_color[0] == b->shadow_color[0] &&
+	   a->shadow_color[1] == b->shadow_color[1] &&
+	   a->shadow_color[2] == b->shadow_color[2] &&
+	   a->shadow_offset_x == b->shadow_offset_x &&
+	   a->shadow_offset_y == b->shadow_offset_y;
+}
+
+static decor_shadow_entry_t *
+find_cached_shadow (const decor_shadow_entry_t *key)
+{
+    decor_shadow_entry_t *e;
+
+    for (e = shadow_cache; e; e = e->next)
+    {
+	if (e->xdisplay	    == key->xdisplay	 &&
+	    e->screen	    == key->screen	 &&
+	    e->width	    == key->width	 &&
+	    e->height	    == key->height	 &&
+	    e->left	    == key->left	 &&
+	    e->right	    == key->right	 &&
+	    e->top	    == key->top		 &&
+	    e->bottom	    == key->bottom	 &&
+	    e->solid_left   == key->solid_left	 &&
+	    e->solid_right  == key->solid_right	 &&
+	    e->solid_top    == key->solid_top	 &&
+	    e->solid_bottom == key->solid_bottom &&
+	    e->client_blur  == key->client_blur	 &&
+	    shadow_options_equal (&e->opt, &key->opt))
+	    return e;
+    }
+
+    return NULL;
+}
+
+static void
+cache_shadow (decor_shadow_entry_t *e,
+	      decor_draw_func_t	   draw)
+{
+    if (draw != decor_draw_simple)
+	return;
+
+    e->cached = 1;
+    e->next   = shadow_cache;
+
+    shadow_cache = e;
+}
+
+static void
+uncache_shadow (decor_shadow_entry_t *e)
+{
+    decor_shadow_entry_t **p;
+
+    if (!e->cached)
+	return;
+
+    for (p = &shadow_cache; *p; p = &(*p)->next)
+    {
+	if (*p == e)
+	{
+	    *p = e->next;
+	    break;
+	}
+    }
+}
+
+/* dst[i] += weight * src[i] for n floats */
+static void
+accumulate (float	*dst,
+	    const float *src,
+	    float	weight,
+	    int		n)
+{
+    int i = 0;
+
+#ifdef __SSE2__
+    __m128 w = _mm_set1_ps (weight);
+
+    for (; i + 4 <= n; i += 4)
+	_mm_storeu_ps (dst + i,
+		       _mm_add_ps (_mm_loadu_ps (dst + i),
+				   _mm_mul_ps (w, _mm_loadu_ps (src + i))));
+#endif
+
+    for (; i < n; i++)
+	dst[i] += weight * src[i];
+}
+
+/*
+ * Does what the convolution passes of decor_shadow_create do on the
+ * server on the client: reads back the drawn decoration in d_pixmap,
+ * blurs its alpha with the kernel horizontally and then vertically,
+ * both as rows of floats so that the passes vectorize, and uploads the
+ * colored shadow into pixmap with a single XPutImage. The area inside
+ * the clip rectangle keeps the drawn decoration, like the server path
+ * leaves it.
+ */
+static int
+blur_shadow_on_client (Display		      *xdisplay,
+		       Pixmap		      d_pixmap,
+		       Pixmap		      pixmap,
+		       int		      width,
+		       int		      height,
+		       const XFixed	      *params,
+		       int		      size,
+		       int		      shadow_offset_x,
+		       int		      shadow_offset_y,
+		       const XRenderColor     *color,
+		       double		      opacity,
+		       int		      clipX1,
+		       int		      clipY1,
+		       int		      clipX2,
+		       int		      clipY2)
+{
+    XImage *image;
+    GC	   gc;
+    float  *alpha, *tmp, *blur, *kernel;
+    float  r, g, b, a;
+    int	   n = size * 2 + 1;
+    int	   x, y, j;
+
+    image = XGetImage (xdisplay, d_pixmap, 0, 0, width, height,
+		       AllPlanes, ZPixmap);
+    if (!image)
+	return 0;
+
+    alpha  = malloc (sizeof (float) * width * height * 3 + sizeof (float) * n);
+    if (!alpha)
+    {
+	XDestroyImage (image);
+	return 0;
+    }
+
+    tmp    = alpha + width * height;
+    blur   = tmp + width * height;
+    kernel = blur + width * height;
+
+    for (j = 0; j < n; j++)
+	kernel[j] = XFixedToDouble (params[j]);
+
+    for (y = 0; y < height; y++)
+	for (x = 0; x < width; x++)
+	    alpha[y * width + x] =
+		(XGetPixel (image, x, y) >> 24) / 255.0f;
+
+    memset (tmp, 0, sizeof (float) * width * height * 2);
+
+    /* first pass, horizontal, moved by the x offset */
+    for (y = 0; y < height; y++)
+    {
+	for (j = 0; j < n; j++)
+	{
+	    int offset = j - size - shadow_offset_x;
+	    int x1 = MAX (0, -offset);
+	    int x2 = MIN (width, width - offset);
+
+	    if (x1 < x2)
+		accumulate (tmp + y * width + x1,
+			    alpha + y * width + x1 + offset,
+			    kernel[j], x2 - x1);
+	}
+    }
+
+    /* second pass, vertical, moved by the y offset */
+    for (y = 0; y < height; y++)
+    {
+	for (j = 0; j < n; j++)
+	{
+	    int row = y + j - size - shadow_offset_y;
+
+	    if (row >= 0 && row < height)
+		accumulate (blur + y * width, tmp + row * width,
+			    kernel[j], width);
+	}
+    }
+
+    /* the shadow color is premultiplied, opacity above 1 makes the
+       shadow stronger */
+    a = color->alpha / 65535.0f;
+    r = color->red   / 65535.0f;
+    g = color->green / 65535.0f;
+    b = color->blue  / 65535.0f;
+
+    for (y = 0; y < height; y++)
+    {
+	for (x = 0; x < width; x++)
+	{
+	    float	  v = blur[y * width + x] * opacity;
+	    unsigned long pixel;
+
+	    if (clipX1 < clipX2 && clipY1 < clipY2 &&
+		x >= clipX1 && x < clipX2 && y >= clipY1 && y < clipY2)
+		continue;
+
+	    pixel = (unsigned long) (MIN (1.0f, a * v) * 255.0f + 0.5f) << 24 |
+		    (unsigned long) (MIN (1.0f, r * v) * 255.0f + 0.5f) << 16 |
+		    (unsigned long) (MIN (1.0f, g * v) * 255.0f + 0.5f) << 8  |
+		    (unsigned long) (MIN (1.0f, b * v) * 255.0f + 0.5f);
+
+	    XPutPixel (image, x, y, pixel);
+	}
+    }
+
+    free (alpha);
+
+    gc = XCreateGC (xdisplay, pixmap, 0, NULL);
+    XPutImage (xdisplay, pixmap, gc, image, 0, 0, 0, 0, width, height);
+    XFreeGC (xdisplay, gc);
+
+    XDestroyImage (image);
+
+    return 1;
+}
+
 decor_shadow_t *
 decor_shadow_create (Display		    *xdisplay,
 		     Screen		    *screen,
@@ -1262,12 +1517,33 @@ decor_shadow_create (Display		    *xdisplay,
     int			d_height;
     Window		xroot = screen->root;
     decor_shadow_t	*shadow;
+    decor_shadow_entry_t key, *entry;
     int			clipX1, clipY1, clipX2, clipY2;
 
-    shadow = malloc (sizeof (decor_shadow_t));
-    if (!shadow)
+    key.xdisplay     = xdisplay;
+    key.screen	     = screen;
+    key.width	     = width;
+    key.height	     = height;
+    key.left	     = left;
+    key.right	     = right;
+    key.top	     = top;
+    key.bottom	     = bottom;
+    key.solid_left   = solid_left;
+    key.solid_right  = solid_right;
+    key.solid_top    = solid_top;
+    key.solid_bottom = solid_bottom;
+    key.opt	     = *opt;
+    key.client_blur  = shadow_client_blur;
+    key.cached	     = 0;
+    key.next	     = NULL;
+
+    entry = malloc (sizeof (decor_shadow_entry_t));
+    if (!entry)
 	return NULL;
 
+    *entry = key;
+    shadow = &entry->shadow;
+
     shadow->ref_count = 1;
 
     shadow->pixmap  = 0;
@@ -1314,6 +1590,24 @@ decor_shadow_create (Display		    *xdisplay,
     c->top_corner_space    = MAX (1, size - solid_top    + shadow_offset_y);
     c->bottom_corner_space = MAX (1, size - solid_bottom - shadow_offset_y);
 
+    /* the context is filled in, the rest may have been done before */
+    if (draw == decor_draw_simple)
+    {
+	decor_shadow_entry_t *cached = find_cached_shadow (&key);
+
+	if (cached)
+	{
+	    if (params)
+		free (params);
+
+	    free (entry);
+
+	    cached->shadow.ref_count++;
+
+	    return &cached->shadow;
+	}
+    }
+
     width  = MAX (width, c->left_corner_space + c->right_corner_space);
     height = MAX (height, c->top_corner_space + c->bottom_corner_space);
 
@@ -1332,6 +1626,8 @@ decor_shadow_create (Display		    *xdisplay,
 	if (params)
 	    free (params);
 
+	cache_shadow (entry, draw);
+
 	return shadow;
     }
 
@@ -1360,14 +1656,6 @@ decor_shadow_create (Display		    *xdisplay,
 	XFree (filters);
     }
 
-    if (!filter)
-    {
-	XFreePixmap (xdisplay, pixmap);
-	free (params);
-
-	return shadow;
-    }
-
     /* create pixmap for temporary decorations */
     d_pixmap = XCreatePixmap (xdisplay, xroot, d_width, d_height, 32);
     if (!d_pixmap)
@@ -1378,46 +1666,11 @@ decor_shadow_create (Display		    *xdisplay,
 	return shadow;
     }
 
-    src = XRenderCreateSolidFill (xdisplay, &white);
     dst = XRenderCreatePicture (xdisplay, d_pixmap, format, 0, NULL);
-    tmp = XRenderCreatePicture (xdisplay, pixmap, format, 0, NULL);
 
     /* draw decoration */
     (*draw) (xdisplay, d_pixmap, dst, d_width, d_height, c, closure);
 
-    /* first pass */
-    params[0] = (n_params - 2) << 16;
-    params[1] = 1 << 16;
-
-    clipX1 = c->left_space + size;
-    clipY1 = c->top_space  + size;
-    clipX2 = d_width - c->right_space - size;
-    clipY2 = d_height - c->bottom_space - size;
-
-    if (clipX1 < clipX2 && clipY1 < clipY2)
-	set_picture_clip (xdisplay, tmp, d_width, d_height,
-			  clipX1, clipY1, clipX2, clipY2);
-
-    set_picture_transform (xdisplay, dst, shadow_offset_x, 0);
-    XRenderSetPictureFilter (xdisplay, dst, filter, params, n_params);
-    XRenderComposite (xdisplay,
-		      PictOpSrc,
-		      src,
-		      dst,
-		      tmp,
-		      0, 0,
-		      0, 0,
-		      0, 0,
-		      d_width, d_height);
-
-    set_no_picture_clip (xdisplay, tmp);
-
-    XRenderFreePicture (xdisplay, src);
-
-    /* second pass */
-    params[0] = 1 << 16;
-    params[1] = (n_params - 2) << 16;
-
     opacity = XDoubleToFixed (opt->shadow_opacity);
     if (opacity < (1 << 16))
     {
@@ -1438,69 +1691,133 @@ decor_shadow_create (Display		    *xdisplay,
 	color.alpha = 0xffff;
     }
 
-    src = XRenderCreateSolidFill (xdisplay, &color);
-
     clipX1 = c->left_space;
     clipY1 = c->top_space;
     clipX2 = d_width - c->right_space;
     clipY2 = d_height - c->bottom_space;
 
-    if (clipX1 < clipX2 && clipY1 < clipY2)
-	set_picture_clip (xdisplay, dst, d_width, d_height,
-			  clipX1, clipY1, clipX2, clipY2);
-
-    set_picture_transform (xdisplay, tmp, 0, shadow_offset_y);
-    XRenderSetPictureFilter (xdisplay, tmp, filter, params, n_params);
-    XRenderComposite (xdisplay,
-		      PictOpSrc,
-		      src,
-		      tmp,
-		      dst,
-		      0, 0,
-		      0, 0,
-		      0, 0,
-		      d_width, d_height);
+    /* blur on the client if asked to or if the server can't */
+    if (shadow_client_blur || !filter)
+    {
+	XRenderFreePicture (xdisplay, dst);
+	XFreePixmap (xdisplay, pixmap);
 
-    set_no_picture_clip (xdisplay, dst);
+	if (!blur_shadow_on_client (xdisplay, d_pixmap, d_pixmap,
+				    d_width, d_height, params + 2, size,
+				    shadow_offset_x, shadow_offset_y,
+				    &color, XFixedToDouble (opacity),
+				    clipX1, clipY1, clipX2, clipY2))
+	{
+	    XFreePixmap (xdisplay, d_pixmap);
+	    free (params);
 
-    XRenderFreePicture (xdisplay, src);
+	    return shadow;
+	}
 
-    if (opacity != (1 << 16))
+	shadow->pixmap = d_pixmap;
+    }
+    else
     {
-	XFixed p[3];
+	src = XRenderCreateSolidFill (xdisplay, &white);
+	tmp = XRenderCreatePicture (xdisplay, pixmap, format, 0, NULL);
+
+	/* first pass */
+	params[0] = (n_params - 2) << 16;
+	params[1] = 1 << 16;
 
-	p[0] = 1 << 16;
-	p[1] = 1 << 16;
-	p[2] = opacity;
+	clipX1 = c->left_space + size;
+	clipY1 = c->top_space  + size;
+	clipX2 = d_width - c->right_space - size;
+	clipY2 = d_height - c->bottom_space - size;
 
 	if (clipX1 < clipX2 && clipY1 < clipY2)
 	    set_picture_clip (xdisplay, tmp, d_width, d_height,
 			      clipX1, clipY1, clipX2, clipY2);
 
-	/* apply opacity */
-	set_picture_transform (xdisplay, dst, 0, 0);
-	XRenderSetPictureFilter (xdisplay, dst, filter, p, 3);
+	set_picture_transform (xdisplay, dst, shadow_offset_x, 0);
+	XRenderSetPictureFilter (xdisplay, dst, filter, params, n_params);
 	XRenderComposite (xdisplay,
 			  PictOpSrc,
+			  src,
 			  dst,
-			  None,
 			  tmp,
 			  0, 0,
 			  0, 0,
 			  0, 0,
 			  d_width, d_height);
 
-	XFreePixmap (xdisplay, d_pixmap);
-	shadow->pixmap = pixmap;
-    }
-    else
-    {
-	XFreePixmap (xdisplay, pixmap);
-	shadow->pixmap = d_pixmap;
-    }
+	set_no_picture_clip (xdisplay, tmp);
+
+	XRenderFreePicture (xdisplay, src);
+
+	/* second pass */
+	params[0] = 1 << 16;
+	params[1] = (n_params - 2) << 16;
+
+	src = XRenderCreateSolidFill (xdisplay, &color);
+
+	clipX1 = c->left_space;
+	clipY1 = c->top_space;
+	clipX2 = d_width - c->right_space;
+	clipY2 = d_height - c->bottom_space;
+
+	if (clipX1 < clipX2 && clipY1 < clipY2)
+	    set_picture_clip (xdisplay, dst, d_width, d_height,
+			      clipX1, clipY1, clipX2, clipY2);
+
+	set_picture_transform (xdisplay, tmp, 0, shadow_offset_y);
+	XRenderSetPictureFilter (xdisplay, tmp, filter, params, n_params);
+	XRenderComposite (xdisplay,
+			  PictOpSrc,
+			  src,
+			  tmp,
+			  dst,
+			  0, 0,
+			  0, 0,
+			  0, 0,
+			  d_width, d_height);
+
+	set_no_picture_clip (xdisplay, dst);
+
+	XRenderFreePicture (xdisplay, src);
+
+	if (opacity != (1 << 16))
+	{
+	    XFixed p[3];
+
+	    p[0] = 1 << 16;
+	    p[1] = 1 << 16;
+	    p[2] = opacity;
+
+	    if (clipX1 < clipX2 && clipY1 < clipY2)
+		set_picture_clip (xdisplay, tmp, d_width, d_height,
+				  clipX1, clipY1, clipX2, clipY2);
+
+	    /* apply opacity */
+	    set_picture_transform (xdisplay, dst, 0, 0);
+	    XRenderSetPictureFilter (xdisplay, dst, filter, p, 3);
+	    XRenderComposite (xdisplay,
+			      PictOpSrc,
+			      dst,
+			      None,
+			      tmp,
+			      0, 0,
+			      0, 0,
+			      0, 0,
+			      d_width, d_height);
+
+	    XFreePixmap (xdisplay, d_pixmap);
+	    shadow->pixmap = pixmap;
+	}
+	else
+	{
+	    XFreePixmap (xdisplay, pixmap);
+	    shadow->pixmap = d_pixmap;
+	}
 
-    XRenderFreePicture (xdisplay, tmp);
-    XRenderFreePicture (xdisplay, dst);
+	XRenderFreePicture (xdisplay, tmp);
+	XRenderFreePicture (xdisplay, dst);
+    }
 
     shadow->picture = XRenderCreatePicture (xdisplay, shadow->pixmap,
 					    format, 0, NULL);
@@ -1510,6 +1827,8 @@ decor_shadow_create (Display		    *xdisplay,
 
     free (params);
 
+    cache_shadow (entry, draw);
+
     return shadow;
 }
 
@@ -1521,6 +1840,9 @@ decor_shadow_destroy (Display	     *xdisplay,
     if (shadow->ref_count)
 	return;
 
+    /* every shadow is the first member of its entry */
+    uncache_shadow ((decor_shadow_entry_t *) shadow);
+
     if (shadow->picture)
 	XRenderFreePicture (xdisplay, shadow->picture);
 
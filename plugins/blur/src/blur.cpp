@@ -122,6 +122,17 @@ BlurScreen::updateFilterRadius ()
 
 	    filterRadius = powf (2.0f, ceilf (lod));
 	} break;
+	case BlurOptions::FilterDualFilter: {
+	    int   passes = optionGetDualFilterPasses ();
+	    float offset = optionGetDualFilterOffset ();
+
+	    /* how far the samples of all down- and upsampling passes
+	       reach in full resolution pixels, including the texel of
+	       bilinear filtering at each level */
+	    filterRadius = ceilf ((offset + 1.0f) * ((1 << passes) - 1) +
+				  (2.0f * offset + 1.0f) *
+				  ((2 << passes) - 4) + 2.0f);
+	} break;
     }
 }
 
@@ -145,6 +156,109 @@ BlurScreen::blurReset ()
 	GL::deletePrograms (1, &program);
 	program = 0;
     }
+
+    for (int i = 0; i < 2; i++)
+    {
+	if (dualProgram[i])
+	{
+	    GL::deletePrograms (1, &dualProgram[i]);
+	    dualProgram[i] = 0;
+	}
+    }
+
+    clearBlurCache ();
+}
+
+/* The textures hold the blurred background of the windows painted last,
+   each window keeps using its part of them until something below it is
+   damaged. Damage that is not reported through a window is taken to
+   be below all windows. */
+void
+BlurScreen::updateBlurCache ()
+{
+    if (cachedWindows.empty ())
+    {
+	/* nothing to invalidate */
+    }
+    else if (cScreen->damageMask () & COMPOSITE_SCREEN_DAMAGE_ALL_MASK)
+    {
+	clearBlurCache ();
+    }
+    else if (cScreen->damageMask () & COMPOSITE_SCREEN_DAMAGE_REGION_MASK)
+    {
+	CompRegion below (lostDamage);
+	int        left = cachedWindows.size ();
+
+	/* walk from bottom to top, adding up the damage of the windows
+	   below each cached window */
+	foreach (CompWindow *w, screen->windows ())
+	{
+	    BLUR_WINDOW (w);
+
+	    if (!bw->blurCache.isEmpty ())
+	    {
+		CompRect extents = bw->blurCache.boundingRect ();
+
+		extents.setGeometry (extents.x () - filterRadius,
+				     extents.y () - filterRadius,
+				     extents.width () + filterRadius * 2,
+				     extents.height () + filterRadius * 2);
+
+		if (below.intersects (extents))
+		    bw->clearBlurCache ();
+
+		if (!--left)
+		    break;
+	    }
+
+	    below += bw->frameDamage;
+	}
+    }
+
+    foreach (CompWindow *w, damagedWindows.windows ())
+	BlurWindow::get (w)->frameDamage = CompRegion ();
+
+    damagedWindows.clear ();
+    lostDamage = CompRegion ();
+}
+
+/* Damage of a window reaches this through composite right after the
+   damageRect call that recorded it, or from inside that call when a
+   plugin wrapped below us damages the screen for the window. Anything
+   else can't be told apart from a change below all windows. */
+void
+BlurScreen::damageRegion (const CompRegion &region)
+{
+    if (!cachedWindows.empty ())
+    {
+	if (damagingWindow)
+	{
+	    BlurWindow::get (damagingWindow)->frameDamage += region;
+	    damagedWindows.add (damagingWindow);
+	}
+	else if (!windowDamagePending || !(region == windowDamage))
+	{
+	    lostDamage += region;
+	}
+    }
+
+    windowDamagePending = false;
+
+    cScreen->damageRegion (region);
+}
+
+void
+BlurScreen::clearBlurCache ()
+{
+    foreach (CompWindow *w, cachedWindows.windows ())
+	BlurWindow::get (w)->clearBlurCache ();
+}
+
+void
+BlurWindow::clearBlurCache ()
+{
+    blurCache = CompRegion ();
+    bScreen->cachedWindows.remove (window);
 }
 
 static CompRegion
@@ -277,7 +391,8 @@ void
 BlurWindow::updateMatch ()
 {
     CompMatch *match;
-    bool      focus;
+    bool      focus, changed = false;
+    int       target = 0;
 
     updateAlphaMatch ();
 
@@ -287,8 +402,20 @@ BlurWindow::updateMatch ()
     if (focus != focusBlur)
     {
 	focusBlur = focus;
+	changed   = true;
 	cWindow->addDamage ();
     }
+
+    /* the value preparePaint animates the blur towards */
+    if (pulse || (focusBlur && bScreen->optionGetFocusBlur () &&
+		  window->id () != screen->activeWindow ()))
+	target = 0xffff;
+
+    if (changed || blur != target)
+    {
+	bScreen->animatingWindows.add (window);
+	bScreen->moreBlur = true;
+    }
 }
 
 
@@ -365,12 +492,12 @@ BlurScreen::preparePaint (int msSinceLastPaint)
 	if (steps < 12)
 	    steps = 12;
 
-	moreBlur = false;
-
-	foreach (CompWindow *w, screen->windows ())
+	foreach (CompWindow *w, animatingWindows.windows ())
 	{
 	    BLUR_WINDOW (w);
 
+	    bool animating = false;
+
 	    focusBlur = bw->focusBlur && focus;
 
 	    if (!bw->pulse &&
@@ -380,7 +507,7 @@ BlurScreen::preparePaint (int msSinceLastPaint)
 		{
 		    bw->blur -= steps;
 		    if (bw->blur > 0)
-			moreBlur = true;
+			animating = true;
 		    else
 			bw->blur = 0;
 		}
@@ -399,23 +526,30 @@ BlurScreen::preparePaint (int msSinceLastPaint)
 			    bw->pulse = false;
 			}
 
-			moreBlur = true;
+			animating = true;
 		    }
 		    else
 		    {
 			bw->blur += steps;
 			if (bw->blur < 0xffff)
-			    moreBlur = true;
+			    animating = true;
 			else
 			    bw->blur = 0xffff;
 		    }
 		}
 	    }
+
+	    if (!animating)
+		animatingWindows.remove (w);
 	}
+
+	moreBlur = !animatingWindows.empty ();
     }
 
     cScreen->preparePaint (msSinceLastPaint);
 
+    updateBlurCache ();
+
     if (cScreen->damageMask () & COMPOSITE_SCREEN_DAMAGE_REGION_MASK)
     {
 	/* walk from bottom to top and expand damage */
@@ -452,8 +586,13 @@ BlurScreen::preparePaint (int msSinceLastPaint)
 		}
 	    }
 
+	    /* only repaints what is already known to be damaged */
 	    if (count)
+	    {
+		cScreen->damageRegionSetEnabled (this, false);
 		cScreen->damageRegion (damage);
+		cScreen->damageRegionSetEnabled (this, true);
+	    }
 
 	    this->count = count;
 	}
@@ -524,7 +663,7 @@ BlurScreen::donePaint ()
 {
     if (moreBlur)
     {
-	foreach (CompWindow *w, screen->windows ())
+	foreach (CompWindow *w, animatingWindows.windows ())
 	{
 	    BLUR_WINDOW (w);
 
@@ -821,6 +960,18 @@ BlurScreen::getDstBlurFragmentFunction (GLTexture *texture,
 		    param, param, unit, targetString,
 		    param + 1);
 
+		break;
+	    case BlurOptions::FilterDualFilter:
+		data.addFetchOp ("output", NULL, target);
+		data.addColorOp ("output", "output");
+
+		data.addDataOp (
+		    "MUL fCoord, fragment.position, program.env[%d];"
+		    "TEX sum, fCoord, texture[%d], %s;"
+		    "MUL_SAT mask, output.a, program.env[%d];",
+		    param, unit, targetString,
+		    param + 1);
+
 		break;
 	}
 
@@ -1027,21 +1178,23 @@ BlurScreen::loadFilterProgram (int numITC)
 }
 
 bool
-BlurScreen::fboPrologue ()
+BlurScreen::fboPrologue (GLuint texture,
+			 int    width,
+			 int    height)
 {
     if (!fbo)
 	return false;
 
     (*GL::bindFramebuffer) (GL_FRAMEBUFFER_EXT, fbo);
 
-    /* bind texture and check status the first time */
+    (*GL::framebufferTexture2D) (GL_FRAMEBUFFER_EXT,
+				 GL_COLOR_ATTACHMENT0_EXT,
+				 target, texture,
+				 0);
+
+    /* check status the first time */
     if (!fboStatus)
     {
-	(*GL::framebufferTexture2D) (GL_FRAMEBUFFER_EXT,
-				     GL_COLOR_ATTACHMENT0_EXT,
-				     target, texture[1],
-				     0);
-
 	int currStatus = (*GL::checkFramebufferStatus) (GL_FRAMEBUFFER_EXT);
 	if (currStatus != GL_FRAMEBUFFER_COMPLETE_EXT)
 	{
@@ -1121,7 +1274,7 @@ BlurScreen::fboUpdate (BoxPtr pBox,
 	if (!loadFilterProgram (iTC))
 	    return false;
 
-    if (!fboPrologue ())
+    if (!fboPrologue (texture[1], width, height))
 	return false;
 
     glDisable (GL_CULL_FACE);
@@ -1210,6 +1363,238 @@ BlurScreen::fboUpdate (BoxPtr pBox,
     return true;
 }
 
+/* Level 0 of the dual filter is half the size of the screen */
+void
+BlurScreen::dualFilterSize (int level,
+			    int *width,
+			    int *height)
+{
+    *width  = MAX (1, this->width >> (level + 1));
+    *height = MAX (1, this->height >> (level + 1));
+}
+
+bool
+BlurScreen::loadDualFilterPrograms ()
+{
+    char buffer[4096];
+    char *targetString;
+
+    if (target == GL_TEXTURE_2D)
+	targetString = (char *) "2D";
+    else
+	targetString = (char *) "RECT";
+
+    /* downsampling, the texel itself and four diagonal neighbours at
+       program.local[0] */
+    snprintf (buffer, sizeof (buffer),
+	      "!!ARBfp1.0"
+	      "PARAM offset = program.local[0];"
+	      "ATTRIB texcoord = fragment.texcoord[0];"
+	      "TEMP sum, c0, c1, c2, c3, p0, p1, p2, p3;"
+	      "ADD c0, texcoord, offset;"
+	      "SUB c1, texcoord, offset;"
+	      "MAD c2, offset, { 1.0, -1.0, 0.0, 0.0 }, texcoord;"
+	      "MAD c3, offset, { -1.0, 1.0, 0.0, 0.0 }, texcoord;"
+	      "TEX sum, texcoord, texture[0], %s;"
+	      "TEX p0, c0, texture[0], %s;"
+	      "TEX p1, c1, texture[0], %s;"
+	      "TEX p2, c2, texture[0], %s;"
+	      "TEX p3, c3, texture[0], %s;"
+	      "MUL sum, sum, 4.0;"
+	      "ADD sum, sum, p0;"
+	      "ADD sum, sum, p1;"
+	      "ADD sum, sum, p2;"
+	      "ADD sum, sum, p3;"
+	      "MUL result.color, sum, 0.125;"
+	      "END",
+	      targetString, targetString, targetString, targetString,
+	      targetString);
+
+    if (!loadFragmentProgram (&dualProgram[0], buffer))
+	return false;
+
+    /* upsampling, four neighbours at twice the offset along the axes
+       and four diagonal ones with double weight */
+    snprintf (buffer, sizeof (buffer),
+	      "!!ARBfp1.0"
+	      "PARAM offset = program.local[0];"
+	      "ATTRIB texcoord = fragment.texcoord[0];"
+	      "TEMP sum, c0, c1, c2, c3, c4, c5, c6, c7;"
+	      "TEMP p0, p1, p2, p3, p4, p5, p6, p7;"
+	      "MAD c0, offset, { -2.0, 0.0, 0.0, 0.0 }, texcoord;"
+	      "MAD c1, offset, { 2.0, 0.0, 0.0, 0.0 }, texcoord;"
+	      "MAD c2, offset, { 0.0, -2.0, 0.0, 0.0 }, texcoord;"
+	      "MAD c3, offset, { 0.0, 2.0, 0.0, 0.0 }, texcoord;"
+	      "ADD c4, texcoord, offset;"
+	      "SUB c5, texcoord, offset;"
+	      "MAD c6, offset, { 1.0, -1.0, 0.0, 0.0 }, texcoord;"
+	      "MAD c7, offset, { -1.0, 1.0, 0.0, 0.0 }, texcoord;"
+	      "TEX p0, c0, texture[0], %s;"
+	      "TEX p1, c1, texture[0], %s;"
+	      "TEX p2, c2, texture[0], %s;"
+	      "TEX p3, c3, texture[0], %s;"
+	      "TEX p4, c4, texture[0], %s;"
+	      "TEX p5, c5, texture[0], %s;"
+	      "TEX p6, c6, texture[0], %s;"
+	      "TEX p7, c7, texture[0], %s;"
+	      "ADD sum, p0, p1;"
+	      "ADD sum, sum, p2;"
+	      "ADD sum, sum, p3;"
+	      "MAD sum, p4, 2.0, sum;"
+	      "MAD sum, p5, 2.0, sum;"
+	      "MAD sum, p6, 2.0, sum;"
+	      "MAD sum, p7, 2.0, sum;"
+	      "MUL result.color, sum, %f;"
+	      "END",
+	      targetString, targetString, targetString, targetString,
+	      targetString, targetString, targetString, targetString,
+	      1.0f / 12.0f);
+
+    return loadFragmentProgram (&dualProgram[1], buffer);
+}
+
+/* Blurs box, which is in screen coordinates, by halving the background
+   level by level and then doubling it back up to level 0, only the
+   part of each level that box and the reach of the filter cover is
+   drawn */
+bool
+BlurScreen::dualFilterUpdate (const CompRect &box)
+{
+    int    nLevels = dualTexture.size ();
+    int    x1, y1, x2, y2;
+    float  offset = optionGetDualFilterOffset ();
+    bool   wasCulled = glIsEnabled (GL_CULL_FACE);
+
+    if (!nLevels)
+	return false;
+
+    if (!dualProgram[0] || !dualProgram[1])
+	if (!loadDualFilterPrograms ())
+	    return false;
+
+    /* in GL coordinates at full resolution */
+    x1 = MAX (0, box.x1 () - filterRadius);
+    x2 = MIN (width, box.x2 () + filterRadius);
+    y1 = MAX (0, height - box.y2 () - filterRadius);
+    y2 = MIN (height, height - box.y1 () + filterRadius);
+
+    if (!fboPrologue (dualTexture[0], width / 2, height / 2))
+	return false;
+
+    glDisable (GL_CULL_FACE);
+    glDisable (GL_BLEND);
+    glDisableClientState (GL_TEXTURE_COORD_ARRAY);
+    glEnable (GL_FRAGMENT_PROGRAM_ARB);
+
+    /* downsample into level 0 to nLevels - 1 and upsample back into
+       level nLevels - 2 to 0 */
+    for (int pass = 0; pass < nLevels * 2 - 1; pass++)
+    {
+	bool   down = pass < nLevels;
+	int    level = down ? pass : nLevels * 2 - 2 - pass;
+	int    w, h, srcW, srcH;
+	int    lx1, ly1, lx2, ly2;
+	float  sx, sy;
+	GLuint src;
+
+	dualFilterSize (level, &w, &h);
+
+	if (down && level == 0)
+	{
+	    src  = texture[0];
+	    srcW = width;
+	    srcH = height;
+	}
+	else
+	{
+	    int srcLevel = down ? level - 1 : level + 1;
+
+	    src = dualTexture[srcLevel];
+	    dualFilterSize (srcLevel, &srcW, &srcH);
+	}
+
+	(*GL::framebufferTexture2D) (GL_FRAMEBUFFER_EXT,
+				     GL_COLOR_ATTACHMENT0_EXT,
+				     target, dualTexture[level], 0);
+
+	glViewport (0, 0, w, h);
+	glMatrixMode (GL_PROJECTION);
+	glLoadIdentity ();
+	glOrtho (0.0, w, 0.0, h, -1.0, 1.0);
+	glMatrixMode (GL_MODELVIEW);
+
+	/* the box at this level, rounded outwards. Level 0 is what
+	   windows draw from and other windows only lose their cache as
+	   far as the box and the reach of the filter go, so it is
+	   rounded inwards instead. The samples outside of that don't
+	   reach the box. */
+	if (level == 0)
+	{
+	    lx1 = (x1 + 1) >> 1;
+	    ly1 = (y1 + 1) >> 1;
+	    lx2 = MIN (w, x2 >> 1);
+	    ly2 = MIN (h, y2 >> 1);
+	}
+	else
+	{
+	    lx1 = MAX (0, (x1 >> (level + 1)) - 1);
+	    ly1 = MAX (0, (y1 >> (level + 1)) - 1);
+	    lx2 = MIN (w, (x2 >> (level + 1)) + 2);
+	    ly2 = MIN (h, (y2 >> (level + 1)) + 2);
+	}
+
+	if (lx1 >= lx2 || ly1 >= ly2)
+	    continue;
+
+	/* from this level's pixels to texture coordinates of the source */
+	if (target == GL_TEXTURE_2D)
+	{
+	    sx = 1.0f / w;
+	    sy = 1.0f / h;
+	}
+	else
+	{
+	    sx = (float) srcW / w;
+	    sy = (float) srcH / h;
+	}
+
+	glBindTexture (target, src);
+
+	(*GL::bindProgram) (GL_FRAGMENT_PROGRAM_ARB,
+			    dualProgram[down ? 0 : 1]);
+	(*GL::programLocalParameter4f) (GL_FRAGMENT_PROGRAM_ARB, 0,
+					offset * sx * w / srcW,
+					offset * sy * h / srcH,
+					0.0f, 0.0f);
+
+	glBegin (GL_QUADS);
+
+	glTexCoord2f (sx * lx1, sy * ly1);
+	glVertex2i   (lx1, ly1);
+	glTexCoord2f (sx * lx2, sy * ly1);
+	glVertex2i   (lx2, ly1);
+	glTexCoord2f (sx * lx2, sy * ly2);
+	glVertex2i   (lx2, ly2);
+	glTexCoord2f (sx * lx1, sy * ly2);
+	glVertex2i   (lx1, ly2);
+
+	glEnd ();
+    }
+
+    glBindTexture (target, 0);
+
+    glDisable (GL_FRAGMENT_PROGRAM_ARB);
+
+    glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+
+    if (wasCulled)
+	glEnable (GL_CULL_FACE);
+
+    fboEpilogue ();
+
+    return true;
+}
+
 #define MAX_VERTEX_PROJECT_COUNT 20
 
 void
@@ -1357,7 +1742,8 @@ BlurWindow::projectRegion (CompOutput     *output,
 bool
 BlurWindow::updateDstTexture (const GLMatrix &transform,
 			      CompRect       *pExtents,
-			      int            clientThreshold)
+			      int            clientThreshold,
+			      bool           transformed)
 {
     int        y;
     int        filter;
@@ -1452,11 +1838,25 @@ BlurWindow::updateDstTexture (const GLMatrix &transform,
 
     *pExtents = bScreen->tmpRegion.boundingRect ();
 
+    /* the background has not changed since it was last blurred */
+    if (!transformed && bScreen->texture[0]           &&
+	bScreen->width == screen->width ()           &&
+	bScreen->height == screen->height ()         &&
+	(bScreen->tmpRegion - blurCache).isEmpty ())
+    {
+	bScreen->cacheHits++;
+	return true;
+    }
+
+    bScreen->reblurs++;
+
     if (!bScreen->texture[0] || bScreen->width != screen->width () ||
 	bScreen->height != screen->height ())
     {
 	int i, textures = 1;
 
+	bScreen->clearBlurCache ();
+
 	bScreen->width  = screen->width ();
 	bScreen->height = screen->height ();
 
@@ -1474,7 +1874,8 @@ BlurWindow::updateDstTexture (const GLMatrix &transform,
 	    bScreen->ty = 1;
 	}
 
-	if (filter == BlurOptions::FilterGaussian)
+	if (filter == BlurOptions::FilterGaussian ||
+	    filter == BlurOptions::FilterDualFilter)
 	{
 	    if (GL::fbo && !bScreen->fbo)
 		(*GL::genFramebuffers) (1, &bScreen->fbo);
@@ -1483,7 +1884,47 @@ BlurWindow::updateDstTexture (const GLMatrix &transform,
 		compLogMessage ("blur", CompLogLevelError,
 				"Failed to create framebuffer object");
 
-	    textures = 2;
+	    if (filter == BlurOptions::FilterGaussian)
+		textures = 2;
+	}
+
+	if (!bScreen->dualTexture.empty ())
+	{
+	    glDeleteTextures (bScreen->dualTexture.size (),
+			      &bScreen->dualTexture[0]);
+	    bScreen->dualTexture.clear ();
+	}
+
+	if (filter == BlurOptions::FilterDualFilter)
+	{
+	    bScreen->dualTexture.resize (bScreen->optionGetDualFilterPasses ());
+	    glGenTextures (bScreen->dualTexture.size (),
+			   &bScreen->dualTexture[0]);
+
+	    for (i = 0; i < (int) bScreen->dualTexture.size (); i++)
+	    {
+		int w, h;
+
+		bScreen->dualFilterSize (i, &w, &h);
+
+		glBindTexture (bScreen->target, bScreen->dualTexture[i]);
+		glTexImage2D (bScreen->target, 0, GL_RGB, w, h, 0, GL_BGRA,
+#if IMAGE_BYTE_ORDER == MSBFirst
+			      GL_UNSIGNED_INT_8_8_8_8_REV,
+#else
+			      GL_UNSIGNED_BYTE,
+#endif
+			      NULL);
+
+		glTexParameteri (bScreen->target, GL_TEXTURE_MIN_FILTER,
+				 GL_LINEAR);
+		glTexParameteri (bScreen->target, GL_TEXTURE_MAG_FILTER,
+				 GL_LINEAR);
+		glTexParameteri (bScreen->target, GL_TEXTURE_WRAP_S,
+				 GL_CLAMP_TO_EDGE);
+		glTexParameteri (bScreen->target, GL_TEXTURE_WRAP_T,
+				 GL_CLAMP_TO_EDGE);
+	    }
 	}
 
 	bScreen->fboStatus = false;
@@ -1549,6 +1990,16 @@ BlurWindow::updateDstTexture (const GLMatrix &transform,
 
 	CompRect br = bScreen->tmpRegion.boundingRect ();
 
+	/* the dual filter samples the whole reach of the filter */
+	if (filter == BlurOptions::FilterDualFilter)
+	{
+	    int r = bScreen->filterRadius;
+
+	    br = CompRect (br.x () - r, br.y () - r,
+			   br.width () + r * 2, br.height () + r * 2);
+	    br &= CompRect (0, 0, screen->width (), screen->height ());
+	}
+
 	y = screen->height () - br.y2 ();
 
 	glCopyTexSubImage2D (bScreen->target, 0,
@@ -1558,14 +2009,26 @@ BlurWindow::updateDstTexture (const GLMatrix &transform,
 			     br.height ());
     }
 
+    updateBlurCache (filter, transformed);
+
     switch (filter) {
 	case BlurOptions::FilterGaussian:
-	    return bScreen->fboUpdate (bScreen->tmpRegion.handle ()->rects,
-				       bScreen->tmpRegion.numRects ());
+	    if (bScreen->fboUpdate (bScreen->tmpRegion.handle ()->rects,
+				    bScreen->tmpRegion.numRects ()))
+		return true;
+
+	    clearBlurCache ();
+	    return false;
 	case BlurOptions::FilterMipmap:
 	    if (GL::generateMipmap)
 		(*GL::generateMipmap) (bScreen->target);
 	    break;
+	case BlurOptions::FilterDualFilter:
+	    if (bScreen->dualFilterUpdate (bScreen->tmpRegion.boundingRect ()))
+		return true;
+
+	    clearBlurCache ();
+	    return false;
 	case BlurOptions::Filter4xbilinear:
 	    break;
     }
@@ -1575,6 +2038,47 @@ BlurWindow::updateDstTexture (const GLMatrix &transform,
     return true;
 }
 
+/* The textures now hold the background of this window in tmpRegion,
+   that of other windows nearby is gone */
+void
+BlurWindow::updateBlurCache (int  filter,
+			     bool transformed)
+{
+    CompRect br = bScreen->tmpRegion.boundingRect ();
+    int      r = bScreen->filterRadius;
+
+    br.setGeometry (br.x () - r, br.y () - r,
+		    br.width () + r * 2, br.height () + r * 2);
+
+    foreach (CompWindow *w, bScreen->cachedWindows.windows ())
+    {
+	BlurWindow *bw = BlurWindow::get (w);
+
+	if (bw == this)
+	    continue;
+
+	/* mipmaps are generated for the whole texture */
+	if (filter == BlurOptions::FilterMipmap)
+	    bw->clearBlurCache ();
+	else if (bw->blurCache.intersects (br))
+	{
+	    bw->blurCache -= br;
+	    if (bw->blurCache.isEmpty ())
+		bw->clearBlurCache ();
+	}
+    }
+
+    if (transformed)
+    {
+	clearBlurCache ();
+    }
+    else
+    {
+	blurCache += bScreen->tmpRegion;
+	bScreen->cachedWindows.add (window);
+    }
+}
+
 bool
 BlurWindow::glDraw (const GLMatrix     &transform,
 		    GLFragment::Attrib &attrib,
@@ -1612,7 +2116,11 @@ BlurWindow::glDraw (const GLMatrix     &transform,
 		!(mask & PAINT_WINDOW_TRANSFORMED_MASK))
 		bScreen->tmpRegion -= clip;
 
-	    if (updateDstTexture (transform, &box, clientThreshold))
+	    /* the cache is in screen space, which a transform of the
+	       window or the screen doesn't paint the window into */
+	    if (updateDstTexture (transform, &box, clientThreshold,
+				  mask & (PAINT_WINDOW_TRANSFORMED_MASK |
+					  PAINT_WINDOW_ON_TRANSFORMED_SCREEN_MASK)))
 	    {
 		if (clientThreshold)
 		{
@@ -1725,6 +2233,9 @@ BlurWindow::glDrawTexture (GLTexture          *texture,
 	if (texture == tex)
 	    state = BLUR_STATE_CLIENT;
 
+    if (texture == gWindow->thumbnail ())
+	state = BLUR_STATE_CLIENT;
+
     if (blur || this->state[state].active)
     {
 	GLFragment::Attrib fa (attrib);
@@ -1959,6 +2470,46 @@ BlurWindow::glDrawTexture (GLTexture          *texture,
 						      threshold, threshold);
 		    }
 		    break;
+		case BlurOptions::FilterDualFilter:
+		    if (bScreen->dualTexture.empty ())
+			break;
+
+		    param = dstFa.allocParameters (2);
+		    unit  = dstFa.allocTextureUnits (1);
+
+		    function =
+			bScreen->getDstBlurFragmentFunction (texture, param,
+							     unit, 0, 0);
+		    if (function)
+		    {
+			int w, h;
+
+			bScreen->dualFilterSize (0, &w, &h);
+
+			dstFa.addFunction (function);
+
+			(*GL::activeTexture) (GL_TEXTURE0_ARB + unit);
+			glBindTexture (bScreen->target,
+				       bScreen->dualTexture[0]);
+			(*GL::activeTexture) (GL_TEXTURE0_ARB);
+
+			/* level 0 is half the size of the screen */
+			if (bScreen->target == GL_TEXTURE_2D)
+			    (*GL::programEnvParameter4f) (
+				GL_FRAGMENT_PROGRAM_ARB, param,
+				bScreen->tx, bScreen->ty, 0.0f, 0.0f);
+			else
+			    (*GL::programEnvParameter4f) (
+				GL_FRAGMENT_PROGRAM_ARB, param,
+				(float) w / bScreen->width,
+				(float) h / bScreen->height, 0.0f, 0.0f);
+
+			(*GL::programEnvParameter4f) (GL_FRAGMENT_PROGRAM_ARB,
+						      param + 1,
+						      threshold, threshold,
+						      threshold, threshold);
+		    }
+		    break;
 	    }
 
 	    if (this->state[state].clipped ||
@@ -2036,6 +2587,7 @@ BlurScreen::handleEvent (XEvent *event)
 	    if (optionGetFocusBlur ())
 	    {
 		CompositeWindow::get (w)->addDamage ();
+		animatingWindows.add (w);
 		moreBlur = true;
 	    }
 	}
@@ -2046,6 +2598,7 @@ BlurScreen::handleEvent (XEvent *event)
 	    if (optionGetFocusBlur ())
 	    {
 		CompositeWindow::get (w)->addDamage ();
+		animatingWindows.add (w);
 		moreBlur = true;
 	    }
 	}
@@ -2082,6 +2635,8 @@ BlurWindow::resizeNotify (int dx,
 	    updateRegion ();
     }
 
+    clearBlurCache ();
+
     window->resizeNotify (dx, dy, dwidth, dheight);
 
 }
@@ -2094,9 +2649,55 @@ BlurWindow::moveNotify (int  dx,
     if (!region.isEmpty ())
 	region.translate (dx, dy);
 
+    clearBlurCache ();
+
     window->moveNotify (dx, dy, immediate);
 }
 
+void
+BlurWindow::windowNotify (CompWindowNotify n)
+{
+    /* the damage of the window no longer tells whether it was below
+       or above the others */
+    if (n == CompWindowNotifyRestack)
+	bScreen->clearBlurCache ();
+
+    window->windowNotify (n);
+}
+
+bool
+BlurWindow::damageRect (bool           initial,
+			const CompRect &rect)
+{
+    const CompWindow::Geometry &geom = window->geometry ();
+    CompWindow                 *damaging = bScreen->damagingWindow;
+    CompRect                   screenRect (rect.x () + geom.x () +
+					   geom.border (),
+					   rect.y () + geom.y () +
+					   geom.border (),
+					   rect.width (), rect.height ());
+    bool                       status;
+
+    bScreen->damagingWindow = window;
+    status = cWindow->damageRect (initial, rect);
+    bScreen->damagingWindow = damaging;
+
+    if (!bScreen->cachedWindows.empty ())
+    {
+	frameDamage += screenRect;
+	bScreen->damagedWindows.add (window);
+    }
+
+    /* composite damages the screen with the rectangle next */
+    if (!status)
+    {
+	bScreen->windowDamage        = screenRect;
+	bScreen->windowDamagePending = true;
+    }
+
+    return status;
+}
+
 static bool
 blurPulse (CompAction         *action,
 	   CompAction::State  state,
@@ -2116,6 +2717,7 @@ blurPulse (CompAction         *action,
 
 	bw->pulse    = true;
 	bs->moreBlur = true;
+	bs->animatingWindows.add (w);
 
 	bw->cWindow->addDamage ();
     }
@@ -2159,12 +2761,18 @@ BlurScreen::setOption (const CompString &name, CompOption::Value &value)
 	case BlurOptions::FocusBlurMatch:
 	case BlurOptions::AlphaBlurMatch:
 	    foreach (CompWindow *w, screen->windows ())
+	    {
 		BlurWindow::get (w)->updateMatch ();
+		animatingWindows.add (w);
+	    }
 
 	    moreBlur = true;
 	    cScreen->damageScreen ();
 	    break;
 	case BlurOptions::FocusBlur:
+	    foreach (CompWindow *w, screen->windows ())
+		animatingWindows.add (w);
+
 	    moreBlur = true;
 	    cScreen->damageScreen ();
 	    break;
@@ -2196,6 +2804,14 @@ BlurScreen::setOption (const CompString &name, CompOption::Value &value)
 		cScreen->damageScreen ();
 	    }
 	    break;
+	case BlurOptions::DualFilterPasses:
+	case BlurOptions::DualFilterOffset:
+	    if (optionGetFilter () == BlurOptions::FilterDualFilter)
+	    {
+		blurReset ();
+		cScreen->damageScreen ();
+	    }
+	    break;
 	case BlurOptions::Saturation:
 	    blurReset ();
 	    cScreen->damageScreen ();
@@ -2225,7 +2841,11 @@ BlurScreen::BlurScreen (CompScreen *screen) :
     program (0),
     maxTemp (32),
     fbo (0),
-    fboStatus (0)
+    fboStatus (0),
+    damagingWindow (NULL),
+    windowDamagePending (false),
+    cacheHits (0),
+    reblurs (0)
 {
 
     blurAtom[BLUR_STATE_CLIENT] =
@@ -2237,7 +2857,10 @@ BlurScreen::BlurScreen (CompScreen *screen) :
     blurOcclusion = optionGetOcclusion ();
 
     for (int i = 0; i < 2; i++)
+    {
 	texture[i] = 0;
+	dualProgram[i] = 0;
+    }
 
     glGetIntegerv (GL_STENCIL_BITS, &stencilBits);
     if (!stencilBits)
@@ -2278,12 +2901,23 @@ BlurScreen::~BlurScreen ()
 
     cScreen->damageScreen ();
 
+    compLogMessage ("blur", CompLogLevelDebug,
+		    "%u blurred backgrounds reused, %u blurred again",
+		    cacheHits, reblurs);
+
     if (fbo)
 	(*GL::deleteFramebuffers) (1, &fbo);
 
     for (int i = 0; i < 2; i++)
+    {
 	if (texture[i])
 	    glDeleteTextures (1, &texture[i]);
+	if (dualProgram[i])
+	    GL::deletePrograms (1, &dualProgram[i]);
+    }
+
+    if (!dualTexture.empty ())
+	glDeleteTextures (dualTexture.size (), &dualTexture[0]);
 
 }
 
@@ -2313,11 +2947,13 @@ BlurWindow::BlurWindow (CompWindow *w) :
 
 
     WindowInterface::setHandler (window, true);
+    CompositeWindowInterface::setHandler (cWindow, true);
     GLWindowInterface::setHandler (gWindow, true);
 }
 
 BlurWindow::~BlurWindow ()
 {
+    bScreen->lostDamage += frameDamage;
 }
 
 bool
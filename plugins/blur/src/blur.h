@@ -86,6 +86,7 @@ class BlurScreen :
 
 	void preparePaint (int);
 	void donePaint ();
+	void damageRegion (const CompRegion &);
 
 	bool glPaintOutput (const GLScreenPaintAttrib &,
 			    const GLMatrix &, const CompRegion &,
@@ -116,10 +117,17 @@ class BlurScreen :
 
 	bool loadFilterProgram (int numITC);
 
-	bool fboPrologue ();
+	bool fboPrologue (GLuint texture, int width, int height);
 	void fboEpilogue ();
 	bool fboUpdate (BoxPtr pBox, int nBox);
 
+	void dualFilterSize (int level, int *width, int *height);
+	bool loadDualFilterPrograms ();
+	bool dualFilterUpdate (const CompRect &box);
+
+	void updateBlurCache ();
+	void clearBlurCache ();
+
 
     public:
 	GLScreen        *gScreen;
@@ -132,6 +140,9 @@ class BlurScreen :
 	int  blurTime;
 	bool moreBlur;
 
+	/* windows with a changing focus blur */
+	CompositeWindowSet animatingWindows;
+
 	bool blurOcclusion;
 
 	int filterRadius;
@@ -168,11 +179,32 @@ class BlurScreen :
 	float pos[BLUR_GAUSSIAN_RADIUS_MAX];
 	int   numTexop;
 
+	/* dual filter levels, each half the size of the one before, and
+	   the down- and upsampling programs */
+	std::vector<GLuint> dualTexture;
+	GLuint              dualProgram[2];
+
 	GLMatrix mvp;
+
+	/* windows whose blurred background is kept in the textures and
+	   windows that were damaged since the last preparePaint */
+	CompositeWindowSet cachedWindows;
+	CompositeWindowSet damagedWindows;
+	CompRegion         lostDamage;
+
+	/* the window whose damageRect is running, and the damage
+	   composite adds for the last window that didn't handle it */
+	CompWindow *damagingWindow;
+	CompRegion windowDamage;
+	bool       windowDamagePending;
+
+	unsigned int cacheHits;
+	unsigned int reblurs;
 };
 
 class BlurWindow :
     public WindowInterface,
+    public CompositeWindowInterface,
     public GLWindowInterface,
     public PluginClassHandler<BlurWindow,CompWindow>
 {
@@ -184,6 +216,9 @@ class BlurWindow :
 
 	void resizeNotify (int dx, int dy, int dwidth, int dheight);
 	void moveNotify (int dx, int dy, bool immediate);
+	void windowNotify (CompWindowNotify n);
+
+	bool damageRect (bool initial, const CompRect &rect);
 
 	bool glPaint (const GLWindowPaintAttrib &, const GLMatrix &,
 		      const CompRegion &, unsigned int);
@@ -207,7 +242,11 @@ class BlurWindow :
 
 	bool updateDstTexture (const GLMatrix &transform,
 			       CompRect       *pExtents,
-			       int            clientThreshold);
+			       int            clientThreshold,
+			       bool           transformed);
+
+	void updateBlurCache (int filter, bool transformed);
+	void clearBlurCache ();
 
     public:
 	CompWindow      *window;
@@ -224,6 +263,11 @@ class BlurWindow :
 
 	CompRegion region;
 	CompRegion clip;
+
+	/* the part of the textures that holds the blurred background of
+	   this window and what the window damaged since the last frame */
+	CompRegion blurCache;
+	CompRegion frameDamage;
 };
 
 #define BLUR_SCREEN(s) \
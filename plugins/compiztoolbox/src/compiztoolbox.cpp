@@ -482,7 +482,9 @@ BaseSwitchWindow::paintThumb (const GLWindowPaintAttrib &attrib,
 	   very ugly but necessary until the vertex stage has been made
 	   fully pluggable. */
 	gWindow->glAddGeometrySetCurrentIndex (MAXSHORT);
+	gWindow->setThumbnailScale (sAttrib.xScale);
 	gWindow->glDraw (wTransform, fragment, infiniteRegion, mask);
+	gWindow->setThumbnailScale (1.0f);
 	gWindow->glAddGeometrySetCurrentIndex (addWindowGeometryIndex);
 
 	gScreen->setTextureFilter (filter);
@@ -30,7 +30,7 @@
 
 #include <X11/extensions/Xcomposite.h>
 
-#define COMPIZ_COMPOSITE_ABI 2
+#define COMPIZ_COMPOSITE_ABI 4
 
 #include <core/pluginclasshandler.h>
 #include <core/timer.h>
@@ -90,6 +90,7 @@ class PrivateCompositeScreen;
 class PrivateCompositeWindow;
 class CompositeScreen;
 class CompositeWindow;
+class CompositeWindowSet;
 
 /**
  * Wrapable function interface for CompositeScreen
@@ -129,11 +130,18 @@ class CompositeScreenInterface :
 	 * evaluated for repainting
 	 */
 	virtual const CompWindowList & getWindowPaintList ();
+
+	/**
+	 * Hookable function which adds a region to the damage of the
+	 * next repaint, hook it to learn where the screen is damaged
+	 * by what
+	 */
+	virtual void damageRegion (const CompRegion &);
 };
 
 
 class CompositeScreen :
-    public WrapableHandler<CompositeScreenInterface, 4>,
+    public WrapableHandler<CompositeScreenInterface, 5>,
     public PluginClassHandler<CompositeScreen, CompScreen, COMPIZ_COMPOSITE_ABI>,
     public CompOption::Class
 {
@@ -178,11 +186,6 @@ class CompositeScreen :
 	 */
 	void damageScreen ();
 
-	/**
-	 * Adds a specific region to be redrawn on the next
-	 * event loop
-	 */
-	void damageRegion (const CompRegion &);
 	void damagePending ();
 	
 
@@ -219,8 +222,11 @@ class CompositeScreen :
 
 	WRAPABLE_HND (3, CompositeScreenInterface, const CompWindowList &,
 		      getWindowPaintList);
+	WRAPABLE_HND (4, CompositeScreenInterface, void, damageRegion,
+		      const CompRegion &);
 
 	friend class PrivateCompositeDisplay;
+	friend class CompositeWindowSet;
 
     private:
 	PrivateCompositeScreen *priv;
@@ -231,6 +237,42 @@ class CompositeScreen :
 					  CompOption::Vector &options);
 };
 
+/**
+ * A set of windows a plugin is currently animating, so that the
+ * plugin only has to visit those in preparePaint and donePaint
+ * instead of every window of the screen. Windows are removed from
+ * all sets when they are destroyed.
+ */
+class CompositeWindowSet
+{
+    public:
+	CompositeWindowSet ();
+	~CompositeWindowSet ();
+
+	void add (CompWindow *w);
+	void remove (CompWindow *w);
+	void clear ();
+	bool contains (CompWindow *w) const;
+	bool empty () const;
+	unsigned int size () const;
+
+	/**
+	 * Returns a copy of the set in the order the windows were
+	 * added, windows may be removed while iterating over it
+	 */
+	CompWindowVector windows () const;
+
+    private:
+	CompositeWindowSet (const CompositeWindowSet &);
+	CompositeWindowSet & operator= (const CompositeWindowSet &);
+
+	static void windowDestroyed (CompWindow *w);
+
+	CompWindowVector mWindows;
+
+    friend class CompositeWindow;
+};
+
 /*
   window paint flags
 
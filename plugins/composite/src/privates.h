@@ -38,6 +38,10 @@
 extern bool       useCow;
 #endif
 
+/* damage received while a window waits for a sync alarm is merged
+   into at most this many rectangles */
+#define MAX_SYNC_DAMAGE_RECTS 32
+
 extern CompPlugin::VTable *compositeVTable;
 
 extern CompWindow *lastDamagedWindow;
@@ -112,6 +116,8 @@ class PrivateCompositeScreen :
 
 	CompositeFPSLimiterMode FPSLimiterMode;
 	int frameTimeAccumulator;
+
+	std::list<CompositeWindowSet *> windowSets;
 };
 
 class PrivateCompositeWindow : WindowInterface
@@ -130,6 +136,8 @@ class PrivateCompositeWindow : WindowInterface
 				      int             width,
 				      int             height);
 
+	void addSyncDamage (const XRectangle &rect);
+
     public:
 	CompWindow      *window;
 	CompositeWindow *cWindow;
@@ -149,9 +157,9 @@ class PrivateCompositeWindow : WindowInterface
 	unsigned short brightness;
 	unsigned short saturation;
 
-	XRectangle *damageRects;
-	int        sizeDamage;
-	int        nDamage;
+	std::vector<XRectangle> damageRects;
+	unsigned int		damageRectsPeak;
+	unsigned int		damageRectsMerged;
 };
 
 #endif
@@ -468,6 +468,8 @@ CompositeScreen::damageScreen ()
 void
 CompositeScreen::damageRegion (const CompRegion &region)
 {
+    WRAPABLE_HND_FUNC (4, damageRegion, region)
+
     if (priv->damageMask & COMPOSITE_SCREEN_DAMAGE_ALL_MASK)
 	return;
 
@@ -773,6 +775,9 @@ CompositeScreen::handlePaintTimeout ()
     struct      timeval tv;
     int         timeToNextRedraw;
 
+    /* send window positions deferred since the last frame */
+    screen->flushDeferredConfigures ();
+
     gettimeofday (&tv, 0);
 
     if (priv->damageMask)
@@ -990,6 +995,10 @@ const CompWindowList &
 CompositeScreenInterface::getWindowPaintList ()
     WRAPABLE_DEF (getWindowPaintList)
 
+void
+CompositeScreenInterface::damageRegion (const CompRegion &region)
+    WRAPABLE_DEF (damageRegion, region)
+
 const CompRegion &
 CompositeScreen::currentDamage () const
 {
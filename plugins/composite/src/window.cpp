@@ -60,6 +60,7 @@ CompositeWindow::CompositeWindow (CompWindow *w) :
 
 CompositeWindow::~CompositeWindow ()
 {
+    CompositeWindowSet::windowDestroyed (priv->window);
 
     if (priv->damage)
 	XDamageDestroy (screen->dpy (), priv->damage);
@@ -96,18 +97,20 @@ PrivateCompositeWindow::PrivateCompositeWindow (CompWindow      *w,
     opacity (OPAQUE),
     brightness (BRIGHT),
     saturation (COLOR),
-    damageRects (0),
-    sizeDamage (0),
-    nDamage (0)
+    damageRects (),
+    damageRectsPeak (0),
+    damageRectsMerged (0)
 {
     WindowInterface::setHandler (w);
 }
 
 PrivateCompositeWindow::~PrivateCompositeWindow ()
 {
-
-    if (sizeDamage)
-	free (damageRects);
+    if (damageRectsPeak)
+	compLogMessage ("composite", CompLogLevelDebug,
+			"window 0x%lx: %u damage rects merged during sync "
+			"waits, at most %u buffered", window->id (),
+			damageRectsMerged, damageRectsPeak);
 }
 
 bool
@@ -366,24 +369,68 @@ CompositeWindow::processDamage (XDamageNotifyEvent *de)
 {
     if (priv->window->syncWait ())
     {
-	if (priv->nDamage == priv->sizeDamage)
+	priv->addSyncDamage (de->area);
+    }
+    else
+    {
+        priv->handleDamageRect (this, de->area.x, de->area.y,
+				de->area.width, de->area.height);
+    }
+}
+
+/* Merges rect into a buffered rectangle when their bounding box is no
+   larger than both of them together, or into the one that grows the
+   least when the buffer is full. The buffer keeps its storage between
+   sync waits. */
+void
+PrivateCompositeWindow::addSyncDamage (const XRectangle &rect)
+{
+    int		 x2 = rect.x + rect.width;
+    int		 y2 = rect.y + rect.height;
+    int		 area = rect.width * rect.height;
+    int		 bestGrowth = MAXSHORT * MAXSHORT;
+    unsigned int best = 0;
+
+    for (unsigned int i = 0; i < damageRects.size (); i++)
+    {
+	XRectangle &r = damageRects[i];
+	int	   ux1, uy1, ux2, uy2, growth;
+
+	ux1 = MIN (r.x, rect.x);
+	uy1 = MIN (r.y, rect.y);
+	ux2 = MAX (r.x + r.width, x2);
+	uy2 = MAX (r.y + r.height, y2);
+
+	growth = (ux2 - ux1) * (uy2 - uy1) - r.width * r.height;
+	if (growth < bestGrowth)
 	{
-	    priv->damageRects = (XRectangle *) realloc (priv->damageRects,
-				 (priv->sizeDamage + 1) *
-				 sizeof (XRectangle));
-	    priv->sizeDamage += 1;
+	    bestGrowth = growth;
+	    best       = i;
 	}
+    }
 
-	priv->damageRects[priv->nDamage].x      = de->area.x;
-	priv->damageRects[priv->nDamage].y      = de->area.y;
-	priv->damageRects[priv->nDamage].width  = de->area.width;
-	priv->damageRects[priv->nDamage].height = de->area.height;
-	priv->nDamage++;
+    if (!damageRects.empty () &&
+	(bestGrowth <= area || damageRects.size () == MAX_SYNC_DAMAGE_RECTS))
+    {
+	XRectangle &r = damageRects[best];
+	int	   ux1, uy1, ux2, uy2;
+
+	ux1 = MIN (r.x, rect.x);
+	uy1 = MIN (r.y, rect.y);
+	ux2 = MAX (r.x + r.width, x2);
+	uy2 = MAX (r.y + r.height, y2);
+
+	r.x	 = ux1;
+	r.y	 = uy1;
+	r.width  = ux2 - ux1;
+	r.height = uy2 - uy1;
+
+	damageRectsMerged++;
     }
     else
     {
-        priv->handleDamageRect (this, de->area.x, de->area.y,
-				de->area.width, de->area.height);
+	damageRects.push_back (rect);
+	damageRectsPeak = MAX (damageRectsPeak, damageRects.size ());
     }
 }
 
@@ -528,17 +575,12 @@ PrivateCompositeWindow::windowNotify (CompWindowNotify n)
 	    break;
 	case CompWindowNotifySyncAlarm:
 	{
-	    XRectangle *rects;
-
-	    rects   = damageRects;
-	    while (nDamage--)
-	    {
+	    foreach (XRectangle &r, damageRects)
 		PrivateCompositeWindow::handleDamageRect (cWindow,
-							  rects[nDamage].x,
-							  rects[nDamage].y,
-							  rects[nDamage].width,
-							  rects[nDamage].height);
-	    }
+							  r.x, r.y,
+							  r.width, r.height);
+
+	    damageRects.clear ();
 	    break;
 	}
 	default:
@@ -635,6 +677,72 @@ PrivateCompositeWindow::moveNotify (int dx, int dy, bool now)
     window->moveNotify (dx, dy, now);
 }
 
+CompositeWindowSet::CompositeWindowSet ()
+{
+    CompositeScreen::get (screen)->priv->windowSets.push_back (this);
+}
+
+CompositeWindowSet::~CompositeWindowSet ()
+{
+    CompositeScreen::get (screen)->priv->windowSets.remove (this);
+}
+
+void
+CompositeWindowSet::add (CompWindow *w)
+{
+    if (!contains (w))
+	mWindows.push_back (w);
+}
+
+void
+CompositeWindowSet::remove (CompWindow *w)
+{
+    CompWindowVector::iterator it;
+
+    it = std::find (mWindows.begin (), mWindows.end (), w);
+    if (it != mWindows.end ())
+	mWindows.erase (it);
+}
+
+void
+CompositeWindowSet::clear ()
+{
+    mWindows.clear ();
+}
+
+bool
+CompositeWindowSet::contains (CompWindow *w) const
+{
+    return std::find (mWindows.begin (), mWindows.end (), w) !=
+	   mWindows.end ();
+}
+
+bool
+CompositeWindowSet::empty () const
+{
+    return mWindows.empty ();
+}
+
+unsigned int
+CompositeWindowSet::size () const
+{
+    return mWindows.size ();
+}
+
+CompWindowVector
+CompositeWindowSet::windows () const
+{
+    return mWindows;
+}
+
+void
+CompositeWindowSet::windowDestroyed (CompWindow *w)
+{
+    foreach (CompositeWindowSet *set,
+	     CompositeScreen::get (screen)->priv->windowSets)
+	set->remove (w);
+}
+
 bool
 CompositeWindowInterface::damageRect (bool initial, const CompRect &rect)
     WRAPABLE_DEF (damageRect, initial, rect)
@@ -50,7 +50,6 @@ CopyPixmap::bindPixmapToTexture (Pixmap pixmap,
 	GLTexture::List tl (cp->textures.size ());
 	for (unsigned int i = 0; i < cp->textures.size (); i++)
 	    tl[i] = cp->textures[i];
-	delete cp;
         return tl;
     }
     return GLTexture::List ();
@@ -61,7 +60,7 @@ CopyPixmap::CopyPixmap (Pixmap pixmap,
 			int height,
 			int depth) :
     pixmap (pixmap),
-    damage (damage),
+    damage (None),
     depth (depth)
 {
     int maxTS = MIN (MAX_SUB_TEX, GL::maxTextureSize);
@@ -93,7 +92,8 @@ CopyPixmap::~CopyPixmap ()
 CopyTexture::CopyTexture (CopyPixmap *cp, CompRect dim) :
     cp (cp),
     dim (dim),
-    damage (0, 0, dim.width (), dim.height ())
+    damage (0, 0, dim.width (), dim.height ()),
+    queued (false)
 {
     GLenum            target;
     GLTexture::Matrix matrix = _identity_matrix;
@@ -130,10 +130,22 @@ CopyTexture::CopyTexture (CopyPixmap *cp, CompRect dim) :
 
     setFilter (GL_NEAREST);
     setWrap (GL_CLAMP_TO_EDGE);
+
+    /* the initial upload goes with the next batch */
+    COPY_SCREEN (screen);
+
+    cs->queued.push_back (this);
+    queued = true;
+    cs->cScreen->preparePaintSetEnabled (cs, true);
 }
 
 CopyTexture::~CopyTexture ()
 {
+    CopytexScreen *cs = CopytexScreen::get (screen);
+
+    if (queued && cs)
+	cs->queued.remove (this);
+
     CopyPixmap::Textures::iterator it = std::find (cp->textures.begin (),
 					           cp->textures.end (), this);
     if (it != cp->textures.end ())
@@ -149,75 +161,259 @@ CopyTexture::update ()
 {
     COPY_SCREEN (screen);
 
-    char   *addr = 0;
-    Pixmap tmpPix;
-    XImage *image = 0;
-
-    XGCValues gcv;
-    GC        gc;
-
-    if (!damage.width () || !damage.height ())
+    if (damage.isEmpty ())
 	return;
 
-    gcv.graphics_exposures = false;
-    gcv.subwindow_mode = IncludeInferiors;
-    gc = XCreateGC (screen->dpy (), cp->pixmap,
-		    GCGraphicsExposures | GCSubwindowMode, &gcv);
+    /* a queued texture is uploaded with everything else that waits,
+       such as the other tiles of a pixmap or other windows bound
+       since the last frame */
+    if (queued)
+    {
+	std::list<CopyTexture *> textures;
 
-    if (cs->useShm)
-	tmpPix = XShmCreatePixmap (screen->dpy (), cp->pixmap,
-				   cs->shmInfo.shmaddr, &cs->shmInfo,
-				   damage.width (), damage.height (),
-				   cp->depth);
+	textures.swap (cs->queued);
+	cs->updateTextures (textures);
+    }
     else
-	tmpPix = XCreatePixmap (screen->dpy (), cp->pixmap, damage.width (),
-				damage.height (), cp->depth);
+    {
+	cs->updateTextures (std::list<CopyTexture *> (1, this));
+    }
+}
+
+void
+CopyTexture::enable (Filter filter)
+{
+    update ();
+    GLTexture::enable (filter);
+}
+
+void
+CopyTexture::disable ()
+{
+    GLTexture::disable ();
+}
 
-    XCopyArea (screen->dpy (), cp->pixmap, tmpPix, gc,
-	       dim.x () + damage.x (), dim.y () + damage.y (),
-	       damage.width (), damage.height (), 0, 0);
-    XSync (screen->dpy (), false);
+char *
+CopytexScreen::allocShm (int        size,
+			 ShmSegment **segment)
+{
+    ShmSegment *seg;
 
-    if (cs->useShm)
-	addr = cs->shmInfo.shmaddr;
-    else
+    /* keep offsets aligned for the upload */
+    size = (size + 15) & ~15;
+
+    foreach (ShmSegment *s, shmPool)
     {
-	image = XGetImage (screen->dpy (), tmpPix, 0, 0, damage.width (),
-			   damage.height (), AllPlanes, ZPixmap);
-	if (image)
-	    addr = image->data;
+	if (s->size - s->used >= size)
+	{
+	    char *addr = s->info.shmaddr + s->used;
+
+	    s->used += size;
+	    *segment = s;
+
+	    return addr;
+	}
+    }
+
+    if (shmPoolSize + MAX (size, SHM_SEGMENT_SIZE) > SHM_POOL_SIZE)
+	return NULL;
+
+    seg = new ShmSegment;
+    seg->size = MAX (size, SHM_SEGMENT_SIZE);
+    seg->used = 0;
+
+    seg->info.shmid = shmget (IPC_PRIVATE, seg->size, IPC_CREAT | 0600);
+    if (seg->info.shmid < 0)
+    {
+	compLogMessage ("copytex", CompLogLevelError,
+			"Can't create shared memory\n");
+	delete seg;
+	useShm = false;
+	return NULL;
     }
 
-    glBindTexture (target (), name ());
-    glTexSubImage2D (target (), 0, damage.x (), damage.y (),
-		     damage.width (), damage.height (), GL_BGRA,
+    seg->info.shmaddr = (char *) shmat (seg->info.shmid, 0, 0);
+    if (seg->info.shmaddr == ((char *)-1))
+    {
+	shmctl (seg->info.shmid, IPC_RMID, 0);
+	compLogMessage ("copytex", CompLogLevelError,
+			"Can't attach shared memory\n");
+	delete seg;
+	useShm = false;
+	return NULL;
+    }
+
+    seg->info.readOnly = false;
+    if (!XShmAttach (screen->dpy (), &seg->info))
+    {
+	shmdt (seg->info.shmaddr);
+	shmctl (seg->info.shmid, IPC_RMID, 0);
+	compLogMessage ("copytex", CompLogLevelError,
+			"Can't attach X shared memory\n");
+	delete seg;
+	useShm = false;
+	return NULL;
+    }
+
+    shmPool.push_back (seg);
+    shmPoolSize += seg->size;
+
+    seg->used = size;
+    *segment = seg;
+
+    return seg->info.shmaddr;
+}
+
+GC
+CopytexScreen::gcForDepth (Drawable drawable,
+			   int      depth)
+{
+    GC *gc = depth == 32 ? &gc32 : &gc24;
+
+    if (!*gc)
+    {
+	XGCValues gcv;
+
+	gcv.graphics_exposures = false;
+	gcv.subwindow_mode = IncludeInferiors;
+	*gc = XCreateGC (screen->dpy (), drawable,
+			 GCGraphicsExposures | GCSubwindowMode, &gcv);
+    }
+
+    return *gc;
+}
+
+/* Uploads the copied rectangles once the server has written all of
+   them to shared memory, so that a batch costs one round trip. */
+void
+CopytexScreen::finishCopies (std::vector<Copy> &copies)
+{
+    bool sync = false;
+
+    foreach (Copy &c, copies)
+	if (c.pixmap)
+	    sync = true;
+
+    if (sync)
+    {
+	XSync (screen->dpy (), false);
+	syncs++;
+    }
+
+    foreach (Copy &c, copies)
+    {
+	CopyTexture *t = c.texture;
+	XImage      *image = NULL;
+	char        *addr = c.addr;
+
+	if (!c.pixmap)
+	{
+	    image = XGetImage (screen->dpy (), t->cp->pixmap,
+			       t->dim.x () + c.rect.x (),
+			       t->dim.y () + c.rect.y (),
+			       c.rect.width (), c.rect.height (),
+			       AllPlanes, ZPixmap);
+	    if (!image)
+		continue;
+
+	    addr = image->data;
+	}
+
+	glBindTexture (t->target (), t->name ());
+	glTexSubImage2D (t->target (), 0, c.rect.x (), c.rect.y (),
+			 c.rect.width (), c.rect.height (), GL_BGRA,
 #if IMAGE_BYTE_ORDER == MSBFirst
-		     GL_UNSIGNED_INT_8_8_8_8_REV,
+			 GL_UNSIGNED_INT_8_8_8_8_REV,
 #else
-		     GL_UNSIGNED_BYTE,
+			 GL_UNSIGNED_BYTE,
 #endif
-		     addr);
+			 addr);
+	glBindTexture (t->target (), 0);
+
+	if (c.pixmap)
+	    XFreePixmap (screen->dpy (), c.pixmap);
+	if (image)
+	    XDestroyImage (image);
+    }
 
-    glBindTexture (target (), 0);
-    XFreePixmap (screen->dpy (), tmpPix);
-    XFreeGC (screen->dpy (), gc);
-    if (image)
-	XDestroyImage (image);
+    copies.clear ();
 
-    damage.setGeometry (0, 0, 0, 0);
+    foreach (ShmSegment *s, shmPool)
+	s->used = 0;
 }
 
 void
-CopyTexture::enable (Filter filter)
+CopytexScreen::updateTextures (const std::list<CopyTexture *> &textures)
 {
-    update ();
-    GLTexture::enable (filter);
+    std::vector<Copy> copies;
+
+    foreach (CopyTexture *t, textures)
+    {
+	CompRect::vector rects;
+
+	if (t->damage.numRects () > MAX_DAMAGE_RECTS)
+	    rects.push_back (t->damage.boundingRect ());
+	else
+	    rects = t->damage.rects ();
+
+	foreach (const CompRect &r, rects)
+	{
+	    Copy c;
+
+	    c.texture = t;
+	    c.rect    = r;
+	    c.segment = NULL;
+	    c.addr    = NULL;
+	    c.pixmap  = None;
+
+	    if (useShm)
+	    {
+		int size = r.width () * r.height () * 4;
+
+		c.addr = allocShm (size, &c.segment);
+		if (!c.addr && useShm && !copies.empty ())
+		{
+		    /* pool is full, make room by finishing what we have */
+		    finishCopies (copies);
+		    c.addr = allocShm (size, &c.segment);
+		}
+	    }
+
+	    if (c.addr)
+	    {
+		c.pixmap = XShmCreatePixmap (screen->dpy (), t->cp->pixmap,
+					     c.addr, &c.segment->info,
+					     r.width (), r.height (),
+					     t->cp->depth);
+		XCopyArea (screen->dpy (), t->cp->pixmap, c.pixmap,
+			   gcForDepth (t->cp->pixmap, t->cp->depth),
+			   t->dim.x () + r.x (), t->dim.y () + r.y (),
+			   r.width (), r.height (), 0, 0);
+	    }
+
+	    copies.push_back (c);
+	    rectsCopied++;
+	}
+
+	t->damage = CompRegion ();
+	t->queued = false;
+    }
+
+    finishCopies (copies);
+    updatePasses++;
 }
 
 void
-CopyTexture::disable ()
+CopytexScreen::preparePaint (int msSinceLastPaint)
 {
-    GLTexture::disable ();
+    std::list<CopyTexture *> textures;
+
+    textures.swap (queued);
+    if (!textures.empty ())
+	updateTextures (textures);
+
+    cScreen->preparePaintSetEnabled (this, false);
+    cScreen->preparePaint (msSinceLastPaint);
 }
 
 void
@@ -244,17 +440,17 @@ CopytexScreen::handleEvent (XEvent *event)
 		y2 = MIN (de->area.y + de->area.height, t->dim.y2 ()) -
 		     t->dim.y1 ();
 
-		if (t->damage.width () && t->damage.height ())
-		{
-		    x1 = MIN (x1, t->damage.x1 ());
-		    x2 = MAX (x2, t->damage.x2 ());
-		    y1 = MIN (y1, t->damage.y1 ());
-		    y2 = MAX (y2, t->damage.y2 ());
-		}
+		if (x1 >= x2 || y1 >= y2)
+		    continue;
 
-		if (x1 < x2 && y1 < y2)
-		    t->damage.setGeometry (x1, y1, x2 - x1, y2 - y1);
+		t->damage += CompRect (x1, y1, x2 - x1, y2 - y1);
 
+		if (!t->queued)
+		{
+		    queued.push_back (t);
+		    t->queued = true;
+		    cScreen->preparePaintSetEnabled (this, true);
+		}
 	    }
 	}
     }
@@ -262,7 +458,14 @@ CopytexScreen::handleEvent (XEvent *event)
 
 
 CopytexScreen::CopytexScreen (CompScreen *screen) :
-    PluginClassHandler<CopytexScreen,CompScreen> (screen)
+    PluginClassHandler<CopytexScreen,CompScreen> (screen),
+    cScreen (CompositeScreen::get (screen)),
+    shmPoolSize (0),
+    gc24 (None),
+    gc32 (None),
+    updatePasses (0),
+    rectsCopied (0),
+    syncs (0)
 {
     useShm = false;
     if (XShmQueryExtension (screen->dpy ()))
@@ -274,46 +477,10 @@ CopytexScreen::CopytexScreen (CompScreen *screen) :
 	    useShm = true;
     }
 
-    if (useShm)
-    {
-	shmInfo.shmid = shmget (IPC_PRIVATE, SHM_SIZE, IPC_CREAT | 0600);
-	if (shmInfo.shmid < 0)
-	{
-	    compLogMessage ("copytex", CompLogLevelError,
-			    "Can't create shared memory\n");
-	    useShm = false;
-	}
-    }
-
-    if (useShm)
-    {
-	shmInfo.shmaddr = (char *) shmat (shmInfo.shmid, 0, 0);
-	if (shmInfo.shmaddr == ((char *)-1))
-	{
-	    shmctl (shmInfo.shmid, IPC_RMID, 0);
-	    compLogMessage ("copytex", CompLogLevelError,
-			    "Can't attach shared memory\n");
-	    useShm = false;
-	}
-    }
-
-    if (useShm)
-    {
-	shmInfo.readOnly = false;
-	if (!XShmAttach (screen->dpy (), &shmInfo))
-	{
-	    shmdt (shmInfo.shmaddr);
-	    shmctl (shmInfo.shmid, IPC_RMID, 0);
-	    compLogMessage ("copytex", CompLogLevelError,
-			    "Can't attach X shared memory\n");
-	    useShm = false;
-	}
-    }
-
-    damageNotify = CompositeScreen::get (screen)->damageEvent () +
-	           XDamageNotify;
+    damageNotify = cScreen->damageEvent () + XDamageNotify;
 
     ScreenInterface::setHandler (screen);
+    CompositeScreenInterface::setHandler (cScreen, false);
 
     hnd = GLScreen::get (screen)->
 	registerBindPixmap (CopyPixmap::bindPixmapToTexture);
@@ -321,12 +488,26 @@ CopytexScreen::CopytexScreen (CompScreen *screen) :
 
 CopytexScreen::~CopytexScreen ()
 {
-    if (useShm)
+    compLogMessage ("copytex", CompLogLevelDebug,
+		    "%u update passes, %u rectangles copied, %u syncs",
+		    updatePasses, rectsCopied, syncs);
+
+    foreach (CopyTexture *t, queued)
+	t->queued = false;
+
+    foreach (ShmSegment *s, shmPool)
     {
-	XShmDetach (screen->dpy (), &shmInfo);
-	shmdt (shmInfo.shmaddr);
-	shmctl (shmInfo.shmid, IPC_RMID, 0);
+	XShmDetach (screen->dpy (), &s->info);
+	shmdt (s->info.shmaddr);
+	shmctl (s->info.shmid, IPC_RMID, 0);
+	delete s;
     }
+
+    if (gc24)
+	XFreeGC (screen->dpy (), gc24);
+    if (gc32)
+	XFreeGC (screen->dpy (), gc32);
+
     GLScreen::get (screen)->unregisterBindPixmap (hnd);
 }
 
@@ -334,6 +515,7 @@ bool
 CopytexPluginVTable::init ()
 {
     if (!CompPlugin::checkPluginABI ("core", CORE_ABIVERSION) ||
+        !CompPlugin::checkPluginABI ("composite", COMPIZ_COMPOSITE_ABI) ||
         !CompPlugin::checkPluginABI ("opengl", COMPIZ_OPENGL_ABI))
 	 return false;
 
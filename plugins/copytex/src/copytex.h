@@ -34,7 +34,14 @@
 #include <sys/ipc.h>
 
 #define MAX_SUB_TEX 2048
-#define SHM_SIZE MAX_SUB_TEX * MAX_SUB_TEX * 4
+
+/* shared memory is allocated in segments of at least SHM_SEGMENT_SIZE
+   bytes, up to SHM_POOL_SIZE bytes for all segments together */
+#define SHM_SEGMENT_SIZE (1024 * 1024 * 4)
+#define SHM_POOL_SIZE    (MAX_SUB_TEX * MAX_SUB_TEX * 4)
+
+/* damage with more rectangles is copied as its bounding box */
+#define MAX_DAMAGE_RECTS 8
 
 class CopyTexture;
 
@@ -79,11 +86,19 @@ class CopyTexture : public GLTexture {
     public:
 	CopyPixmap *cp;
 	CompRect   dim;
-	CompRect   damage;
+	CompRegion damage;
+	bool       queued;
+};
+
+struct ShmSegment {
+    XShmSegmentInfo info;
+    int             size;
+    int             used;
 };
 
 class CopytexScreen :
     public ScreenInterface,
+    public CompositeScreenInterface,
     public PluginClassHandler<CopytexScreen,CompScreen>
 {
     public:
@@ -91,9 +106,39 @@ class CopytexScreen :
 	~CopytexScreen ();
 
 	void handleEvent (XEvent *);
+	void preparePaint (int);
+
+	void updateTextures (const std::list<CopyTexture *> &textures);
+
+    private:
+	struct Copy {
+	    CopyTexture *texture;
+	    CompRect    rect;
+	    ShmSegment  *segment;
+	    char        *addr;
+	    Pixmap      pixmap;
+	};
+
+	char * allocShm (int size, ShmSegment **segment);
+	GC gcForDepth (Drawable drawable, int depth);
+	void finishCopies (std::vector<Copy> &copies);
+
+    public:
+	CompositeScreen *cScreen;
+
+	bool                      useShm;
+	std::vector<ShmSegment *> shmPool;
+	int                       shmPoolSize;
+
+	GC gc24;
+	GC gc32;
+
+	/* textures with damage that are updated on the next frame */
+	std::list<CopyTexture *> queued;
 
-	bool            useShm;
-	XShmSegmentInfo shmInfo;
+	unsigned int updatePasses;
+	unsigned int rectsCopied;
+	unsigned int syncs;
 
 	int damageNotify;
 
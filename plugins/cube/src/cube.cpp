@@ -382,6 +382,12 @@ PrivateCubeScreen::updateOutputs ()
 void
 PrivateCubeScreen::updateSkydomeTexture ()
 {
+    if (mSkyLoad)
+    {
+	screen->cancelImageLoad (mSkyLoad);
+	mSkyLoad = 0;
+    }
+
     mSky.clear ();
 
     if (!optionGetSkydome ())
@@ -390,47 +396,83 @@ PrivateCubeScreen::updateSkydomeTexture ()
     CompString imgName = optionGetSkydomeImage ();
     CompString pname = "cube";
 
-    if (optionGetSkydomeImage ().empty () ||
-	(mSky = GLTexture::readImageToTexture (imgName, pname, mSkySize)).empty ())
+    if (!imgName.empty ())
     {
-	GLfloat aaafTextureData[128][128][3];
-	GLfloat fRStart = (GLfloat) optionGetSkydomeGradientStartColorRed () / 0xffff;
-	GLfloat fGStart = (GLfloat) optionGetSkydomeGradientStartColorGreen () / 0xffff;
-	GLfloat fBStart = (GLfloat) optionGetSkydomeGradientStartColorBlue () / 0xffff;
-	GLfloat fREnd = (GLfloat) optionGetSkydomeGradientEndColorRed () / 0xffff;
-	GLfloat fGEnd = (GLfloat) optionGetSkydomeGradientEndColorGreen () / 0xffff;
-	GLfloat fBEnd = (GLfloat) optionGetSkydomeGradientEndColorBlue () / 0xffff;
-	GLfloat fRStep = (fREnd - fRStart) / 128.0f;
-	GLfloat fGStep = (fGEnd - fGStart) / 128.0f;
-	GLfloat fBStep = (fBStart - fBEnd) / 128.0f;
-	GLfloat fR = fRStart;
-	GLfloat fG = fGStart;
-	GLfloat fB = fBStart;
-
-	int	iX, iY;
-
-	for (iX = 127; iX >= 0; iX--)
-	{
-	    fR += fRStep;
-	    fG += fGStep;
-	    fB -= fBStep;
+	/* the sky is painted once the image is decoded */
+	mSkyLoad = screen->readImageFromFileAsync (imgName, pname, CompSize (),
+	    boost::bind (&PrivateCubeScreen::skydomeImageLoaded, this,
+			 _1, _2, _3));
+	if (mSkyLoad)
+	    return;
+
+	mSky = GLTexture::readImageToTexture (imgName, pname, mSkySize);
+    }
 
-	    for (iY = 0; iY < 128; iY++)
-	    {
-		aaafTextureData[iX][iY][0] = fR;
-		aaafTextureData[iX][iY][1] = fG;
-		aaafTextureData[iX][iY][2] = fB;
-	    }
-	}
+    if (mSky.empty ())
+	updateSkydomeGradient ();
+}
 
-	mSkySize = CompSize (128, 128);
+void
+PrivateCubeScreen::skydomeImageLoaded (bool           status,
+				       const CompSize &size,
+				       void           *data)
+{
+    mSkyLoad = 0;
 
-	mSky = GLTexture::imageDataToTexture ((char *) aaafTextureData,
-					      mSkySize, GL_RGB, GL_FLOAT);
+    if (status)
+    {
+	mSkySize = size;
+	mSky = GLTexture::imageBufferToTexture ((char *) data, mSkySize);
+	free (data);
+    }
 
-	mSky[0]->setFilter (GL_LINEAR);
-	mSky[0]->setWrap (GL_CLAMP_TO_EDGE);
+    if (mSky.empty ())
+	updateSkydomeGradient ();
+
+    updateSkydomeList (1.0f);
+    cScreen->damageScreen ();
+}
+
+void
+PrivateCubeScreen::updateSkydomeGradient ()
+{
+    GLfloat aaafTextureData[128][128][3];
+    GLfloat fRStart = (GLfloat) optionGetSkydomeGradientStartColorRed () / 0xffff;
+    GLfloat fGStart = (GLfloat) optionGetSkydomeGradientStartColorGreen () / 0xffff;
+    GLfloat fBStart = (GLfloat) optionGetSkydomeGradientStartColorBlue () / 0xffff;
+    GLfloat fREnd = (GLfloat) optionGetSkydomeGradientEndColorRed () / 0xffff;
+    GLfloat fGEnd = (GLfloat) optionGetSkydomeGradientEndColorGreen () / 0xffff;
+    GLfloat fBEnd = (GLfloat) optionGetSkydomeGradientEndColorBlue () / 0xffff;
+    GLfloat fRStep = (fREnd - fRStart) / 128.0f;
+    GLfloat fGStep = (fGEnd - fGStart) / 128.0f;
+    GLfloat fBStep = (fBStart - fBEnd) / 128.0f;
+    GLfloat fR = fRStart;
+    GLfloat fG = fGStart;
+    GLfloat fB = fBStart;
+
+    int	iX, iY;
+
+    for (iX = 127; iX >= 0; iX--)
+    {
+	fR += fRStep;
+	fG += fGStep;
+	fB -= fBStep;
+
+	for (iY = 0; iY < 128; iY++)
+	{
+	    aaafTextureData[iX][iY][0] = fR;
+	    aaafTextureData[iX][iY][1] = fG;
+	    aaafTextureData[iX][iY][2] = fB;
+	}
     }
+
+    mSkySize = CompSize (128, 128);
+
+    mSky = GLTexture::imageDataToTexture ((char *) aaafTextureData,
+					  mSkySize, GL_RGB, GL_FLOAT);
+
+    mSky[0]->setFilter (GL_LINEAR);
+    mSky[0]->setWrap (GL_CLAMP_TO_EDGE);
 }
 
 static bool
@@ -1660,6 +1702,7 @@ PrivateCubeScreen::PrivateCubeScreen (CompScreen *s) :
     mSrcOutput = 0;
 
     mSkyListId = 0;
+    mSkyLoad   = 0;
 
     mImgCurFile = 0;
 
@@ -1702,6 +1745,9 @@ PrivateCubeScreen::PrivateCubeScreen (CompScreen *s) :
 
 PrivateCubeScreen::~PrivateCubeScreen ()
 {
+    if (mSkyLoad)
+	screen->cancelImageLoad (mSkyLoad);
+
     if (mVertices)
 	free (mVertices);
 
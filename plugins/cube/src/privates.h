@@ -75,6 +75,8 @@ class PrivateCubeScreen :
 	bool updateGeometry (int sides, int invert);
 	void updateOutputs ();
 	void updateSkydomeTexture ();
+	void updateSkydomeGradient ();
+	void skydomeImageLoaded (bool status, const CompSize &size, void *data);
 	void updateSkydomeList (GLfloat fRadius);
 
 	bool setOption (const CompString &name, CompOption::Value &value);
@@ -135,6 +137,8 @@ class PrivateCubeScreen :
 	CompSize mSkySize;
 	GLTexture::List mTexture, mSky;
 
+	CompImageLoadHandle mSkyLoad;
+
 	int	mImgCurFile;
 
 	int mNOutput;
@@ -288,15 +288,17 @@ DecorTexture::~DecorTexture ()
 DecorTexture *
 DecorScreen::getTexture (Pixmap pixmap)
 {
+    std::map<Pixmap, DecorTexture *>::iterator it;
+
     if (!cmActive)
 	return NULL;
 
-    foreach (DecorTexture *t, textures)
-	if (t->pixmap == pixmap)
-	{
-	    t->refCount++;
-	    return t;
-	}
+    it = textures.find (pixmap);
+    if (it != textures.end ())
+    {
+	it->second->refCount++;
+	return it->second;
+    }
 
     DecorTexture *texture = new DecorTexture (pixmap);
 
@@ -306,7 +308,7 @@ DecorScreen::getTexture (Pixmap pixmap)
 	return NULL;
     }
 
-    textures.push_back (texture);
+    textures[pixmap] = texture;
 
     return texture;
 }
@@ -319,16 +321,57 @@ DecorScreen::releaseTexture (DecorTexture *texture)
     if (texture->refCount)
 	return;
 
-    std::list<DecorTexture *>::iterator it =
-	std::find (textures.begin (), textures.end (), texture);
+    std::map<Pixmap, DecorTexture *>::iterator it =
+	textures.find (texture->pixmap);
 
-    if (it == textures.end ())
+    if (it == textures.end () || it->second != texture)
 	return;
 
     textures.erase (it);
     delete texture;
 }
 
+/* FNV-1a of the property */
+static unsigned int
+hashProperty (const long    *prop,
+	      unsigned long n)
+{
+    unsigned int hash = 2166136261u;
+
+    for (unsigned long i = 0; i < n; i++)
+    {
+	unsigned long v = prop[i];
+
+	for (unsigned int j = 0; j < sizeof (long); j++)
+	{
+	    hash ^= (v >> (j * 8)) & 0xff;
+	    hash *= 16777619u;
+	}
+    }
+
+    return hash;
+}
+
+Decoration *
+DecorScreen::findDecoration (unsigned int  hash,
+			     const long    *prop,
+			     unsigned long n)
+{
+    std::multimap<unsigned int, Decoration *>::iterator it;
+
+    for (it = decorations.lower_bound (hash);
+	 it != decorations.end () && it->first == hash; it++)
+    {
+	const std::vector<long> &property = it->second->property;
+
+	if (property.size () == n &&
+	    std::equal (property.begin (), property.end (), prop))
+	    return it->second;
+    }
+
+    return NULL;
+}
+
 static void
 computeQuadBox (decor_quad_t *q,
 		int	     width,
@@ -422,6 +465,9 @@ Decoration::create (Window id,
     int		    left, right, top, bottom;
     int		    x1, y1, x2, y2;
     int		    type;
+    unsigned int    hash;
+    DecorScreen	    *ds = DecorScreen::get (screen);
+    std::vector<long> property;
 
     result = XGetWindowProperty (screen->dpy (), id,
 				 decorAtom, 0L, 1024L, false,
@@ -446,9 +492,29 @@ Decoration::create (Window id,
 
     type = decor_property_get_type (prop);
 
-    if (type ==  WINDOW_DECORATION_TYPE_PIXMAP &&
-	!DecorScreen::get (screen)->cmActive)
+    if (type == WINDOW_DECORATION_TYPE_PIXMAP && !ds->cmActive)
+    {
+	XFree (data);
 	return NULL;
+    }
+
+    /* most windows get the same decoration as many others, those
+       share one Decoration and texture instead of parsing the
+       property again */
+    hash = hashProperty (prop, n);
+
+    decoration = ds->findDecoration (hash, prop, n);
+    if (decoration)
+    {
+	XFree (data);
+
+	decoration->refCount++;
+	ds->decorationsShared++;
+
+	return decoration;
+    }
+
+    property.assign (prop, prop + n);
 
     if (type == WINDOW_DECORATION_TYPE_PIXMAP)
     {
@@ -488,7 +554,10 @@ Decoration::create (Window id,
 	XFree (data);
     }
     else
+    {
+	XFree (data);
 	return NULL;
+    }
 
     decoration = new Decoration ();
     if (!decoration)
@@ -498,7 +567,7 @@ Decoration::create (Window id,
     }
 
     if (pixmap)
-	decoration->texture = DecorScreen::get (screen)->getTexture (pixmap);
+	decoration->texture = ds->getTexture (pixmap);
     else
 	decoration->texture = NULL;
 
@@ -582,18 +651,39 @@ Decoration::create (Window id,
     decoration->refCount = 1;
     decoration->type = type;
 
+    decoration->property.swap (property);
+    decoration->hash = hash;
+
+    ds->decorations.insert (std::make_pair (hash, decoration));
+    ds->decorationsCreated++;
+
     return decoration;
 }
 
 void
 Decoration::release (Decoration *decoration)
 {
+    DecorScreen                                         *ds;
+    std::multimap<unsigned int, Decoration *>::iterator it;
+
     decoration->refCount--;
     if (decoration->refCount)
 	return;
 
+    ds = DecorScreen::get (screen);
+
+    for (it = ds->decorations.lower_bound (decoration->hash);
+	 it != ds->decorations.end () && it->first == decoration->hash; it++)
+    {
+	if (it->second == decoration)
+	{
+	    ds->decorations.erase (it);
+	    break;
+	}
+    }
+
     if (decoration->texture)
-	DecorScreen::get (screen)->releaseTexture (decoration->texture);
+	ds->releaseTexture (decoration->texture);
 
     delete [] decoration->quad;
     delete decoration;
@@ -604,6 +694,9 @@ DecorWindow::updateDecoration ()
 {
     Decoration *decoration;
 
+    if (resizeGrab)
+	resizeRebuilds++;
+
     bindFailed = false;
     decoration = Decoration::create (window->id (), dScreen->winDecorAtom);
 
@@ -996,6 +1089,9 @@ DecorWindow::update (bool allowDecoration)
 void
 DecorWindow::updateFrame ()
 {
+    if (resizeGrab)
+	resizeFrames++;
+
     if (!wd || !(window->border ().left || window->border ().right ||
 		 window->border ().top || window->border ().bottom) ||
         (wd->decor->type == WINDOW_DECORATION_TYPE_PIXMAP && outputFrame) ||
@@ -1555,22 +1651,24 @@ DecorScreen::handleEvent (XEvent *event)
 		if (frames.find (de->drawable) != frames.end ())
 		    frames[de->drawable]->cWindow->damageOutputExtents ();
 
-		foreach (DecorTexture *t, textures)
+		std::map<Pixmap, DecorTexture *>::iterator it =
+		    textures.find (de->drawable);
+
+		if (it != textures.end ())
 		{
-		    if (t->pixmap == de->drawable)
+		    DecorTexture *t = it->second;
+
+		    foreach (CompWindow *w, screen->windows ())
 		    {
-			foreach (CompWindow *w, screen->windows ())
+			if (w->shaded () || w->mapNum ())
 			{
-			    if (w->shaded () || w->mapNum ())
-			    {
-				DECOR_WINDOW (w);
+			    DECOR_WINDOW (w);
 
-				if (dw->wd && dw->wd->decor->texture == t)
-				    dw->cWindow->damageOutputExtents ();
-			    }
+			    if (dw->wd && dw->wd->decor->texture == t)
+				dw->cWindow->damageOutputExtents ();
 			}
-			return;
 		    }
+		    return;
 		}
 	    }
 	    break;
@@ -1606,9 +1704,14 @@ DecorScreen::handleEvent (XEvent *event)
 		if (w)
 		{
 		    DECOR_WINDOW (w);
-		    dw->updateDecoration ();
 
-		    dw->update (true);
+		    if (!dw->deferWork (DECOR_DEFER_DECORATION |
+					DECOR_DEFER_UPDATE))
+		    {
+			dw->updateDecoration ();
+
+			dw->update (true);
+		    }
 		}
 	    }
 	    else if (event->xproperty.atom == Atoms::mwmHints)
@@ -1663,7 +1766,8 @@ DecorScreen::handleEvent (XEvent *event)
 	    if (w)
 	    {
 		DECOR_WINDOW (w);
-		if (!w->hasUnmapReference () && dw->decor)
+		if (!w->hasUnmapReference () && dw->decor &&
+		    !dw->deferWork (DECOR_DEFER_FRAME))
 		    dw->updateFrame ();
 	    }
 	    break;
@@ -1944,7 +2048,9 @@ DecorWindow::resizeNotify (int dx, int dy, int dwidth, int dheight)
        we never should call a wrapped function that's currently
        processed, we need the timer for the moment. updateWindowOutputExtents
        should be fixed so that it does not emit a resize notification. */
-    resizeUpdate.start (boost::bind (&DecorWindow::resizeTimeout, this), 0);
+    if (!deferWork (DECOR_DEFER_UPDATE))
+	resizeUpdate.start (boost::bind (&DecorWindow::resizeTimeout, this),
+			    0);
     updateDecorationScale ();
     updateReg = true;
 
@@ -1960,6 +2066,97 @@ DecorWindow::resizeNotify (int dx, int dy, int dwidth, int dheight)
     window->resizeNotify (dx, dy, dwidth, dheight);
 }
 
+/* While a window is resized interactively the decoration quads are
+   stretched to the new size in resizeNotify. Decorations published by
+   the decorator and frame window updates for intermediate sizes are
+   held back until the next frame, so that they happen at most once per
+   frame and once more when the grab ends. */
+bool
+DecorWindow::deferWork (unsigned int work)
+{
+    if (!resizeGrab || !dScreen->cmActive ||
+	!dScreen->optionGetResizeFrameUpdates ())
+	return false;
+
+    if (!deferredWork)
+	dScreen->deferred.push_back (this);
+
+    deferredWork |= work;
+
+    dScreen->cScreen->preparePaintSetEnabled (dScreen, true);
+
+    /* make sure there is a frame to do it in */
+    cWindow->damageOutputExtents ();
+
+    return true;
+}
+
+void
+DecorWindow::runDeferredWork ()
+{
+    unsigned int work = deferredWork;
+
+    deferredWork = 0;
+    dScreen->deferred.remove (this);
+
+    if (work & DECOR_DEFER_DECORATION)
+	updateDecoration ();
+
+    if (work & (DECOR_DEFER_DECORATION | DECOR_DEFER_UPDATE))
+	resizeTimeout ();
+
+    if ((work & DECOR_DEFER_FRAME) && !window->hasUnmapReference () && decor)
+	updateFrame ();
+}
+
+void
+DecorScreen::preparePaint (int msSinceLastPaint)
+{
+    std::list<DecorWindow *> windows (deferred);
+
+    cScreen->preparePaintSetEnabled (this, false);
+
+    foreach (DecorWindow *dw, windows)
+	dw->runDeferredWork ();
+
+    cScreen->preparePaint (msSinceLastPaint);
+}
+
+void
+DecorWindow::grabNotify (int	      x,
+			 int	      y,
+			 unsigned int state,
+			 unsigned int mask)
+{
+    if (mask & CompWindowGrabResizeMask)
+    {
+	resizeGrab     = true;
+	resizeRebuilds = 0;
+	resizeFrames   = 0;
+    }
+
+    window->grabNotify (x, y, state, mask);
+}
+
+void
+DecorWindow::ungrabNotify ()
+{
+    if (resizeGrab)
+    {
+	if (deferredWork)
+	    runDeferredWork ();
+
+	resizeGrab = false;
+
+	compLogMessage ("decoration", CompLogLevelDebug,
+			"resize of window 0x%lx: %u decoration rebuilds, "
+			"%u frame updates", window->id (),
+			resizeRebuilds, resizeFrames);
+    }
+
+    window->ungrabNotify ();
+}
+
 void
 DecorWindow::stateChangeNotify (unsigned int lastState)
 {
@@ -2010,6 +2207,9 @@ DecorScreen::DecorScreen (CompScreen *s) :
     PluginClassHandler<DecorScreen,CompScreen> (s),
     cScreen (CompositeScreen::get (s)),
     textures (),
+    decorations (),
+    decorationsCreated (0),
+    decorationsShared (0),
     dmWin (None),
     dmSupports (0),
     cmActive (false)
@@ -2060,6 +2260,7 @@ DecorScreen::DecorScreen (CompScreen *s) :
 	    windowDefault.input;
 
     windowDefault.refCount = 1;
+    windowDefault.hash     = 0;
 
     cmActive = (cScreen) ? cScreen->compositingActive () &&
                GLScreen::get (s) != NULL : false;
@@ -2074,6 +2275,9 @@ DecorScreen::DecorScreen (CompScreen *s) :
 			  0);
 
     ScreenInterface::setHandler (s);
+    if (cScreen)
+	CompositeScreenInterface::setHandler (cScreen, false);
+
     screen->updateSupportedWmHints ();
 }
 
@@ -2083,6 +2287,10 @@ DecorScreen::~DecorScreen ()
 	if (decor[i])
 	    Decoration::release (decor[i]);
 
+    compLogMessage ("decoration", CompLogLevelDebug,
+		    "%u decorations parsed, %u shared",
+		    decorationsCreated, decorationsShared);
+
     screen->addSupportedAtomsSetEnabled (this, false);
     screen->updateSupportedWmHints ();
 }
@@ -2102,7 +2310,11 @@ DecorWindow::DecorWindow (CompWindow *w) :
     updateReg (true),
     unshading (false),
     shading (false),
-    isSwitcher (false)
+    isSwitcher (false),
+    resizeGrab (false),
+    deferredWork (0),
+    resizeRebuilds (0),
+    resizeFrames (0)
 {
     WindowInterface::setHandler (window);
 
@@ -2139,6 +2351,9 @@ DecorWindow::DecorWindow (CompWindow *w) :
 
 DecorWindow::~DecorWindow ()
 {
+    if (deferredWork)
+	dScreen->deferred.remove (this);
+
     if (!window->destroyed ())
 	update (false);
 
@@ -23,6 +23,8 @@
  * Author: David Reveman <davidr@novell.com>
  */
 
+#include <list>
+
 #include <boost/shared_ptr.hpp>
 #include <core/core.h>
 #include <core/pluginclasshandler.h>
@@ -48,6 +50,11 @@ struct Vector {
 #define DECOR_ACTIVE 2
 #define DECOR_NUM    3
 
+/* work held back during a resize grab until the next frame */
+#define DECOR_DEFER_DECORATION (1 << 0)
+#define DECOR_DEFER_UPDATE     (1 << 1)
+#define DECOR_DEFER_FRAME      (1 << 2)
+
 class DecorTexture {
 
     public:
@@ -83,6 +90,11 @@ class Decoration {
 	decor_quad_t              *quad;
 	int                       nQuad;
 	int                       type;
+
+	/* the property it was created from, windows with the same
+	   property share it */
+	std::vector<long>         property;
+	unsigned int              hash;
 };
 
 struct ScaledQuad {
@@ -107,6 +119,7 @@ class DecorWindow;
 
 class DecorScreen :
     public ScreenInterface,
+    public CompositeScreenInterface,
     public PluginClassHandler<DecorScreen,CompScreen>,
     public DecorOptions
 {
@@ -118,11 +131,16 @@ class DecorScreen :
 
 	void handleEvent (XEvent *event);
 	void matchPropertyChanged (CompWindow *);
+	void preparePaint (int);
 	void addSupportedAtoms (std::vector<Atom>&);
 
 	DecorTexture * getTexture (Pixmap);
 	void releaseTexture (DecorTexture *);
 
+	Decoration * findDecoration (unsigned int hash,
+				     const long   *prop,
+				     unsigned long n);
+
 	void checkForDm (bool);
 	bool decoratorStartTimeout ();
 
@@ -132,7 +150,13 @@ class DecorScreen :
 
 	CompositeScreen *cScreen;
 
-	std::list<DecorTexture *> textures;
+	std::map<Pixmap, DecorTexture *> textures;
+
+	/* decorations by the hash of their property */
+	std::multimap<unsigned int, Decoration *> decorations;
+
+	unsigned int decorationsCreated;
+	unsigned int decorationsShared;
 
 	Atom supportingDmCheckAtom;
 	Atom winDecorAtom;
@@ -157,6 +181,9 @@ class DecorScreen :
 
 	std::map<Window, DecorWindow *> frames;
 
+	/* windows being resized with deferred work */
+	std::list<DecorWindow *> deferred;
+
 	CompTimer decoratorStart;
 };
 
@@ -175,6 +202,8 @@ class DecorWindow :
 	void moveNotify (int, int, bool);
 	void stateChangeNotify (unsigned int);
 	void updateFrameRegion (CompRegion &region);
+	void grabNotify (int, int, unsigned int, unsigned int);
+	void ungrabNotify ();
 
 	bool damageRect (bool, const CompRect &);
 
@@ -205,6 +234,9 @@ class DecorWindow :
 
 	bool resizeTimeout ();
 
+	bool deferWork (unsigned int);
+	void runDeferredWork ();
+
 	void updateSwitcher ();
 
     public:
@@ -240,6 +272,13 @@ class DecorWindow :
 	bool	  unshading;
 	bool	  shading;
 	bool	  isSwitcher;
+
+	/* while a resize grab is active the decoration is stretched and
+	   rebuilt at most once per frame */
+	bool	     resizeGrab;
+	unsigned int deferredWork;
+	unsigned int resizeRebuilds;
+	unsigned int resizeFrames;
 };
 
 class DecorPluginVTable :
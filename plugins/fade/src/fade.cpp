@@ -92,10 +92,11 @@ FadeScreen::handleEvent (XEvent *event)
 void
 FadeScreen::preparePaint (int msSinceLastPaint)
 {
-    int          steps = MAX (12, (msSinceLastPaint * OPAQUE) / fadeTime);
     unsigned int mode = optionGetFadeMode ();
 
-    foreach (CompWindow *w, screen->windows ())
+    steps = MAX (12, (msSinceLastPaint * OPAQUE) / fadeTime);
+
+    foreach (CompWindow *w, animatingWindows.windows ())
 	FadeWindow::get (w)->paintStep (mode, msSinceLastPaint, steps);
 
     cScreen->preparePaint (msSinceLastPaint);
@@ -192,6 +193,7 @@ FadeWindow::glPaint (const GLWindowPaintAttrib& attrib,
 	saturation == attrib.saturation &&
 	!fScreen->displayModals)
     {
+	fScreen->animatingWindows.remove (window);
 	return gWindow->glPaint (attrib, transform, region, mask);
     }
 
@@ -238,8 +240,28 @@ FadeWindow::glPaint (const GLWindowPaintAttrib& attrib,
 	}
     }
 
+    /* dimmed windows stay out of the set once they reached their
+       target, they don't get steps in constant time mode */
+    if (!steps                           &&
+	opacity    == fAttrib.opacity    &&
+	brightness == fAttrib.brightness &&
+	saturation == fAttrib.saturation)
+    {
+	fScreen->animatingWindows.remove (window);
+    }
+    /* windows only get steps while they are in the set, a window that
+       starts to fade gets this frame's step right away */
+    else if (!fScreen->animatingWindows.contains (window))
+    {
+	fScreen->animatingWindows.add (window);
+
+	if (mode == FadeOptions::FadeModeConstantSpeed)
+	    steps = fScreen->steps;
+    }
+
     if (steps)
     {
+	bool  animating = false;
 	GLint newOpacity = OPAQUE;
 	GLint newBrightness = BRIGHT;
 	GLint newSaturation = COLOR;
@@ -296,12 +318,16 @@ FadeWindow::glPaint (const GLWindowPaintAttrib& attrib,
 		newSaturation != fAttrib.saturation)
 	    {
 		cWindow->addDamage ();
+		animating = true;
 	    }
 	}
 	else
 	{
 	    opacity = 0;
 	}
+
+	if (!animating)
+	    fScreen->animatingWindows.remove (window);
     }
 
     fAttrib.opacity    = opacity;
@@ -314,6 +340,7 @@ FadeWindow::glPaint (const GLWindowPaintAttrib& attrib,
 FadeScreen::FadeScreen (CompScreen *s) :
     PluginClassHandler<FadeScreen, CompScreen> (s),
     displayModals (0),
+    steps (12),
     cScreen (CompositeScreen::get (s))
 {
     fadeTime = 1000.0f / optionGetFadeSpeed ();
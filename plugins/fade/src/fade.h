@@ -46,6 +46,10 @@ class FadeScreen :
 
 	int displayModals;
 	int fadeTime;
+	int steps;
+
+	/* windows that are not painted with their target attributes */
+	CompositeWindowSet animatingWindows;
 
 	CompositeScreen *cScreen;
 };
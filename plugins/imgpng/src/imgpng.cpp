@@ -32,11 +32,15 @@ PngScreen::PngScreen (CompScreen *screen) :
 {
     ScreenInterface::setHandler (screen, true);
 
+    decoder = screen->registerImageDecoder (
+	".png", boost::bind (&PngScreen::decodePng, this, _1, _2, _3, _4));
+
     screen->updateDefaultIcon ();
 }
 
 PngScreen::~PngScreen ()
 {
+    screen->unregisterImageDecoder (decoder);
     screen->updateDefaultIcon ();
 }
 
@@ -321,6 +325,27 @@ PngScreen::imageToFile (CompString &path,
     return status;
 }
 
+/* runs on the image loading thread of core, readPng only touches the
+   file and the data it returns */
+bool
+PngScreen::decodePng (const CompString &file,
+		      const CompSize   &request,
+		      CompSize         &size,
+		      void             *&data)
+{
+    bool          status = false;
+    std::ifstream stream;
+
+    stream.open (file.c_str ());
+    if (stream.is_open ())
+    {
+	status = readPng (stream, size, data);
+	stream.close ();
+    }
+
+    return status;
+}
+
 bool
 PngScreen::fileToImage (CompString &name,
 			CompSize   &size,
@@ -53,11 +53,16 @@ class PngScreen :
     private:
 	CompString fileNameWithExtension (CompString &path);
 
+	bool decodePng (const CompString &file, const CompSize &request,
+			CompSize &size, void *&data);
+
 	bool readPngData (png_struct *png, png_info *info,
 			  void *&data, CompSize &size);
 	bool readPng (std::ifstream &file, CompSize &size, void *& data);
 	bool writePng (unsigned char *buffer, std::ofstream &file,
 		       CompSize &size, int stride);
+
+	CompImageDecoderHandle decoder;
 };
 
 class PngPluginVTable :
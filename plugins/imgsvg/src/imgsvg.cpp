@@ -68,14 +68,140 @@ svgSet (CompAction         *action,
 
 
 SvgScreen::SvgScreen (CompScreen *screen) :
-    PluginClassHandler<SvgScreen, CompScreen> (screen)
+    PluginClassHandler<SvgScreen, CompScreen> (screen),
+    rasterBytes (0),
+    rastersRendered (0),
+    rastersReused (0)
 {
     optionSetSetInitiate (svgSet);
     ScreenInterface::setHandler (screen, true);
+
+    decoder = screen->registerImageDecoder (
+	".svg", boost::bind (&SvgScreen::decodeSvg, this, _1, _2, _3, _4));
 }
 
 SvgScreen::~SvgScreen ()
 {
+    compLogMessage ("svg", CompLogLevelDebug,
+		    "%u overlays rendered, %u reused from the cache",
+		    rastersRendered, rastersReused);
+
+    foreach (Raster *r, rasters)
+    {
+	r->textures.clear ();
+	XFreePixmap (screen->dpy (), r->pixmap);
+	delete r;
+    }
+
+    screen->unregisterImageDecoder (decoder);
+}
+
+/* Returns a raster with the given data and depth and a size equal to
+   the given one or, if nearest is set, the closest one that can be
+   scaled to it. The raster is in use until releaseRaster. */
+SvgScreen::Raster *
+SvgScreen::findRaster (const CompString &data,
+		       unsigned int     depth,
+		       const CompSize   &size,
+		       bool             nearest)
+{
+    std::list<Raster *>::iterator it, best = rasters.end ();
+    int                           bestDistance = 0;
+
+    for (it = rasters.begin (); it != rasters.end (); it++)
+    {
+	Raster *r = *it;
+	float  sx, sy;
+	int    distance;
+
+	if (r->depth != depth || r->data != data)
+	    continue;
+
+	distance = abs (r->size.width () - size.width ()) +
+		   abs (r->size.height () - size.height ());
+
+	if (distance == 0)
+	{
+	    best = it;
+	    break;
+	}
+
+	if (!nearest)
+	    continue;
+
+	sx = (float) r->size.width () / size.width ();
+	sy = (float) r->size.height () / size.height ();
+
+	if (sx > SVG_MAX_SCALE || sx * SVG_MAX_SCALE < 1.0f ||
+	    sy > SVG_MAX_SCALE || sy * SVG_MAX_SCALE < 1.0f)
+	    continue;
+
+	if (best == rasters.end () || distance < bestDistance)
+	{
+	    best = it;
+	    bestDistance = distance;
+	}
+    }
+
+    if (best == rasters.end ())
+	return NULL;
+
+    rasters.splice (rasters.begin (), rasters, best);
+    rasters.front ()->users++;
+    rastersReused++;
+
+    return rasters.front ();
+}
+
+void
+SvgScreen::addRaster (Raster *raster)
+{
+    raster->users = 1;
+
+    rasters.push_front (raster);
+    rasterBytes += raster->size.width () * raster->size.height () * 4;
+    rastersRendered++;
+
+    trimRasters ();
+}
+
+void
+SvgScreen::releaseRaster (Raster *raster)
+{
+    raster->users--;
+
+    trimRasters ();
+}
+
+/* drops the least recently used rasters that are not in use until the
+   cache fits into its size */
+void
+SvgScreen::trimRasters ()
+{
+    size_t                                maxBytes;
+    std::list<Raster *>::reverse_iterator it = rasters.rbegin ();
+
+    maxBytes = (size_t) optionGetCacheSize () * 1024 * 1024;
+
+    while (rasterBytes > maxBytes && it != rasters.rend ())
+    {
+	Raster *r = *it;
+
+	if (r->users)
+	{
+	    it++;
+	    continue;
+	}
+
+	rasterBytes -= r->size.width () * r->size.height () * 4;
+
+	r->textures.clear ();
+	XFreePixmap (screen->dpy (), r->pixmap);
+	delete r;
+
+	it = std::list<Raster *>::reverse_iterator (
+	    rasters.erase (--(it.base ())));
+    }
 }
 
 bool
@@ -91,7 +217,7 @@ SvgScreen::fileToImage (CompString &path,
     if (len < 4 || fileName.substr (len - 4, 4) != ".svg")
 	fileName += ".svg";
 
-    status = readSvgToImage (fileName.c_str (), size, data);
+    status = readSvgToImage (fileName.c_str (), CompSize (), size, data);
 
     if (status)
     {
@@ -131,10 +257,22 @@ SvgScreen::handleCompizEvent (const char         *plugin,
     }
 }
 
+/* runs on the image loading thread of core */
+bool
+SvgScreen::decodeSvg (const CompString &file,
+		      const CompSize   &request,
+		      CompSize         &size,
+		      void             *&data)
+{
+    return readSvgToImage (file.c_str (), request, size, data);
+}
+
+/* renders at the natural size of the image unless a size is requested */
 bool
-SvgScreen::readSvgToImage (const char *file,
-			   CompSize   &size,
-			   void       *&data)
+SvgScreen::readSvgToImage (const char     *file,
+			   const CompSize &request,
+			   CompSize       &size,
+			   void           *&data)
 {
     cairo_surface_t   *surface;
     std::ifstream     svgFile;
@@ -153,10 +291,12 @@ SvgScreen::readSvgToImage (const char *file,
 
     rsvg_handle_get_dimensions (svgHandle, &svgDimension);
 
-    size.setWidth (svgDimension.width);
-    size.setHeight (svgDimension.height);
+    if (request.width () > 0 && request.height () > 0)
+	size = request;
+    else
+	size = CompSize (svgDimension.width, svgDimension.height);
 
-    data = malloc (svgDimension.width * svgDimension.height * 4);
+    data = malloc (size.width () * size.height () * 4);
     if (!data)
     {
 	rsvg_handle_free (svgHandle);
@@ -165,9 +305,9 @@ SvgScreen::readSvgToImage (const char *file,
 
     surface = cairo_image_surface_create_for_data ((unsigned char *) data,
 						   CAIRO_FORMAT_ARGB32,
-						   svgDimension.width,
-						   svgDimension.height,
-						   svgDimension.width * 4);
+						   size.width (),
+						   size.height (),
+						   size.width () * 4);
     if (surface)
     {
 	cairo_t *cr;
@@ -178,6 +318,10 @@ SvgScreen::readSvgToImage (const char *file,
 	cairo_paint (cr);
 	cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
 
+	cairo_scale (cr,
+		     (double) size.width () / svgDimension.width,
+		     (double) size.height () / svgDimension.height);
+
 	rsvg_handle_render_cairo (svgHandle, cr);
 
 	cairo_destroy (cr);
@@ -196,10 +340,15 @@ SvgWindow::SvgWindow (CompWindow *window) :
     sScreen (SvgScreen::get (screen)),
     gScreen (GLScreen::get (screen)),
     window (window),
-    gWindow (GLWindow::get (window))
+    gWindow (GLWindow::get (window)),
+    settling (false)
 {
     if (gWindow)
 	GLWindowInterface::setHandler (gWindow, false);
+
+    settleTimer.setCallback (boost::bind (&SvgWindow::handleSettleTimeout,
+					  this));
+    settleTimer.setTimes (SVG_SETTLE_TIME, SVG_SETTLE_TIME * 1.2);
 }
 
 SvgWindow::~SvgWindow ()
@@ -210,11 +359,7 @@ SvgWindow::~SvgWindow ()
 	delete source;
     }
 
-    if (context)
-    {
-	finiTexture (context->texture[0]);
-	delete context;
-    }
+    finiContext ();
 }
 
 bool
@@ -364,11 +509,41 @@ SvgWindow::resizeNotify (int dx,
 			 int dheight)
 {
     if (source)
+    {
+	/* scale cached renderings until the size settles */
+	if (sScreen->optionGetScaleDuringResize ())
+	{
+	    settling = true;
+	    settleTimer.start ();
+	}
+
 	updateSvgContext ();
+    }
 
     window->resizeNotify (dx, dy, dwidth, dheight);
 }
 
+bool
+SvgWindow::handleSettleTimeout ()
+{
+    settling = false;
+
+    if (source && context)
+    {
+	CompSize size (window->geometry ().width (),
+		       window->geometry ().height ());
+
+	if (size.width ()  != context->texture[0].size.width () ||
+	    size.height () != context->texture[0].size.height ())
+	{
+	    updateSvgContext ();
+	    CompositeWindow::get (window)->addDamage ();
+	}
+    }
+
+    return false;
+}
+
 void
 SvgWindow::updateSvgMatrix ()
 {
@@ -429,6 +604,10 @@ SvgWindow::updateSvgContext ()
 	context = new SvgContext;
 	if (!context)
 	    return;
+
+	context->raster             = NULL;
+	context->texture[0].pixmap = None;
+	context->texture[0].cr     = NULL;
     }
 
     initTexture (source, context->texture[1], context->size);
@@ -453,24 +632,101 @@ SvgWindow::updateSvgContext ()
     x2 = MIN (x2, wSize.width ());
     y2 = MIN (y2, wSize.height ());
 
-    if (!initTexture (source, context->texture[0], wSize))
+    if (!updateRaster (wSize))
     {
-	delete context;
-	context = NULL;
+	finiContext ();
     }
     else
     {
-	renderSvg (source, context->texture[0], wSize, 0.0f, 0.0f, 1.0f, 1.0f);
-
 	initTexture (source, context->texture[1], CompSize ());
 
-	context->box += CompRect (x1, y1, x2 - x1, y2 - y1);
+	context->box = CompRect (x1, y1, x2 - x1, y2 - y1);
 	context->box.translate (window->geometry ().x (), window->geometry ().y ());
 
 	updateSvgMatrix ();
     }
 }
 
+/* Points texture[0] of the context at a rendering of the source for
+   size, from the cache if there is one. While the size is settling a
+   cached rendering of a similar size is used, or a new one is rendered
+   at a size rounded up to SVG_BUCKET_SIZE, and GL scales it. */
+bool
+SvgWindow::updateRaster (CompSize size)
+{
+    SvgScreen::Raster *raster;
+    SvgTexture        texture;
+    CompSize          renderSize = size;
+
+    if (!size.width () || !size.height ())
+    {
+	if (context->raster)
+	    sScreen->releaseRaster (context->raster);
+
+	context->raster = NULL;
+
+	return initTexture (source, context->texture[0], size);
+    }
+
+    raster = sScreen->findRaster (source->data, window->depth (), size,
+				  settling);
+
+    if (!raster)
+    {
+	if (settling)
+	{
+	    renderSize.setWidth ((size.width () + SVG_BUCKET_SIZE - 1) /
+				 SVG_BUCKET_SIZE * SVG_BUCKET_SIZE);
+	    renderSize.setHeight ((size.height () + SVG_BUCKET_SIZE - 1) /
+				  SVG_BUCKET_SIZE * SVG_BUCKET_SIZE);
+	}
+
+	if (!initTexture (source, texture, renderSize))
+	    return false;
+
+	renderSvg (source, texture, renderSize, 0.0f, 0.0f, 1.0f, 1.0f);
+	cairo_destroy (texture.cr);
+
+	raster = new SvgScreen::Raster;
+	raster->data     = source->data;
+	raster->depth    = window->depth ();
+	raster->size     = renderSize;
+	raster->pixmap   = texture.pixmap;
+	raster->textures = texture.textures;
+
+	sScreen->addRaster (raster);
+    }
+
+    if (context->raster)
+	sScreen->releaseRaster (context->raster);
+
+    context->raster = raster;
+
+    /* the raster owns the pixmap */
+    context->texture[0].textures = raster->textures;
+    context->texture[0].size     = raster->size;
+    context->texture[0].pixmap   = None;
+    context->texture[0].cr       = NULL;
+
+    return true;
+}
+
+void
+SvgWindow::finiContext ()
+{
+    if (!context)
+	return;
+
+    finiTexture (context->texture[0]);
+    finiTexture (context->texture[1]);
+
+    if (context->raster)
+	sScreen->releaseRaster (context->raster);
+
+    delete context;
+    context = NULL;
+}
+
 void
 SvgWindow::renderSvg (SvgSource  *source,
 		      SvgTexture &texture,
@@ -589,7 +845,8 @@ SvgWindow::setSvg (CompString    &data,
 	source->p1 = p[0];
 	source->p2 = p[1];
 
-	source->svg = svg;
+	source->svg  = svg;
+	source->data = data;
 
 	gWindow->glDrawSetEnabled (this, true);
 	rsvg_handle_get_dimensions (svg, &source->dimension);
@@ -607,12 +864,7 @@ SvgWindow::setSvg (CompString    &data,
 	    source = NULL;
 	}
 
-	if (context)
-	{
-	    finiTexture (context->texture[0]);
-	    delete context;
-	    context = NULL;
-	}
+	finiContext ();
 
 	gWindow->glDrawSetEnabled (this, false);
     }
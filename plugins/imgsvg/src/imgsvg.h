@@ -44,6 +44,15 @@
 
 #include "imgsvg_options.h"
 
+/* while a window is resized overlays are rendered at sizes rounded up
+   to SVG_BUCKET_SIZE, and cached renderings are scaled by up to
+   SVG_MAX_SCALE in either direction */
+#define SVG_BUCKET_SIZE 64
+#define SVG_MAX_SCALE   1.5f
+
+/* time without a resize after which the size counts as settled */
+#define SVG_SETTLE_TIME 250
+
 #define SVG_SCREEN(s) SvgScreen *ss = SvgScreen::get (s)
 #define SVG_WINDOW(w) SvgWindow *sw = SvgWindow::get (w)
 
@@ -61,10 +70,40 @@ class SvgScreen :
 	void handleCompizEvent (const char *plugin, const char *event,
 				CompOption::Vector &options);
 
+	/* A rendered window overlay, shared by all windows that show the
+	   same svg data at the same size and depth */
+	struct Raster {
+	    CompString      data;
+	    unsigned int    depth;
+	    CompSize        size;
+	    Pixmap          pixmap;
+	    GLTexture::List textures;
+	    int             users;
+	};
+
+	Raster * findRaster (const CompString &data, unsigned int depth,
+			     const CompSize &size, bool nearest);
+	void addRaster (Raster *raster);
+	void releaseRaster (Raster *raster);
+
 	CompRect zoom;
 
     private:
-	bool readSvgToImage (const char *file, CompSize &size, void *& data);
+	void trimRasters ();
+
+	/* most recently used first */
+	std::list<Raster *> rasters;
+	size_t              rasterBytes;
+
+	unsigned int rastersRendered;
+	unsigned int rastersReused;
+
+	bool readSvgToImage (const char *file, const CompSize &request,
+			     CompSize &size, void *& data);
+	bool decodeSvg (const CompString &file, const CompSize &request,
+			CompSize &size, void *&data);
+
+	CompImageDecoderHandle decoder;
 };
 
 class SvgWindow :
@@ -81,6 +120,8 @@ class SvgWindow :
 	void moveNotify (int dx, int dy, bool immediate);
 	void resizeNotify (int dx, int dy, int dwidth, int dheight);
 
+	bool handleSettleTimeout ();
+
 	void setSvg (CompString &data, decor_point_t p[2]);
 
     private:
@@ -90,6 +131,7 @@ class SvgWindow :
 
 	    RsvgHandle	      *svg;
 	    RsvgDimensionData dimension;
+	    CompString        data;
 	} SvgSource;
 
 	typedef struct {
@@ -101,11 +143,12 @@ class SvgWindow :
 	} SvgTexture;
 
 	typedef struct {
-	    SvgSource  *source;
-	    CompRegion box;
-	    SvgTexture texture[2];
-	    CompRect   rect;
-	    CompSize   size;
+	    SvgSource         *source;
+	    CompRegion        box;
+	    SvgTexture        texture[2];
+	    CompRect          rect;
+	    CompSize          size;
+	    SvgScreen::Raster *raster;
 	} SvgContext;
 
 	SvgSource  *source;
@@ -117,8 +160,13 @@ class SvgWindow :
 	CompWindow *window;
 	GLWindow   *gWindow;
 
+	CompTimer settleTimer;
+	bool      settling;
+
 	void updateSvgMatrix ();
 	void updateSvgContext ();
+	bool updateRaster (CompSize size);
+	void finiContext ();
 
 	void renderSvg (SvgSource *source, SvgTexture &texture, CompSize size,
 			float x1, float y1, float x2, float y2);
@@ -485,17 +485,9 @@ moveHandleMotionEvent (CompScreen *s,
 
 	    if (ms->optionGetLazyPositioning () &&
 	        MoveScreen::get (screen)->hasCompositing)
-	    {
-		/* FIXME: This form of lazy positioning is broken and should
-		   be replaced asap. Current code exists just to avoid a
-		   major performance regression in the 0.5.2 release. */
-		w->serverGeometry ().setX (w->geometry ().x ());
-		w->serverGeometry ().setY (w->geometry ().y ());
-	    }
+		w->deferSyncPosition ();
 	    else
-	    {
 		w->syncPosition ();
-	    }
 
 	    ms->x -= dx;
 	    ms->y -= dy;
@@ -35,7 +35,7 @@
 #include <opengl/texture.h>
 #include <opengl/fragment.h>
 
-#define COMPIZ_OPENGL_ABI 3
+#define COMPIZ_OPENGL_ABI 5
 
 #include <core/pluginclasshandler.h>
 
@@ -159,6 +159,20 @@ namespace GL {
 						GLint  level);
     typedef void (*GLGenerateMipmapProc) (GLenum target);
 
+    typedef void (*GLGenBuffersProc) (GLsizei n,
+				      GLuint  *buffers);
+    typedef void (*GLDeleteBuffersProc) (GLsizei n,
+					 GLuint  *buffers);
+    typedef void (*GLBindBufferProc) (GLenum target,
+				      GLuint buffer);
+    typedef void (*GLBufferDataProc) (GLenum	   target,
+				      GLsizeiptrARB size,
+				      const GLvoid  *data,
+				      GLenum	   usage);
+    typedef GLvoid * (*GLMapBufferProc) (GLenum target,
+					 GLenum access);
+    typedef GLboolean (*GLUnmapBufferProc) (GLenum target);
+
     extern GLXBindTexImageProc      bindTexImage;
     extern GLXReleaseTexImageProc   releaseTexImage;
     extern GLXQueryDrawableProc     queryDrawable;
@@ -189,6 +203,13 @@ namespace GL {
     extern GLFramebufferTexture2DProc   framebufferTexture2D;
     extern GLGenerateMipmapProc         generateMipmap;
 
+    extern GLGenBuffersProc    genBuffers;
+    extern GLDeleteBuffersProc deleteBuffers;
+    extern GLBindBufferProc    bindBuffer;
+    extern GLBufferDataProc    bufferData;
+    extern GLMapBufferProc     mapBuffer;
+    extern GLUnmapBufferProc   unmapBuffer;
+
     extern bool  textureFromPixmap;
     extern bool  textureRectangle;
     extern bool  textureNonPowerOfTwo;
@@ -198,6 +219,7 @@ namespace GL {
     extern bool  textureCompression;
     extern GLint maxTextureSize;
     extern bool  fbo;
+    extern bool  pixelBufferObject;
     extern bool  fragmentProgram;
     extern GLint maxTextureUnits;
 
@@ -398,6 +420,8 @@ class GLScreen :
 	WRAPABLE_HND (4, GLScreenInterface, void, glDisableOutputClipping);
 
 	friend class GLTexture;
+	friend class GLWindow;
+	friend class PrivateGLWindow;
 
     private:
 	PrivateGLScreen *priv;
@@ -567,6 +591,21 @@ class GLWindow :
 
 	GLTexture *getIcon (int width, int height);
 
+	/**
+	 * Sets the scale the window is drawn at by the following glDraw
+	 * calls. Below the thumbnail threshold glDraw samples a cached,
+	 * scaled down copy of the window contents instead of the window
+	 * textures. Set it back to 1.0 after drawing.
+	 */
+	void setThumbnailScale (float scale);
+
+	/**
+	 * Returns the cached copy glDraw draws instead of the window
+	 * textures at the current thumbnail scale, or NULL if it draws
+	 * the window textures
+	 */
+	GLTexture *thumbnail ();
+
 	WRAPABLE_HND (0, GLWindowInterface, bool, glPaint,
 		      const GLWindowPaintAttrib &, const GLMatrix &,
 		      const CompRegion &, unsigned int);
@@ -37,6 +37,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
 
 #define COMP_FUNCTION_TYPE_ARB 0
 #define COMP_FUNCTION_TYPE_NUM 1
@@ -217,6 +219,22 @@ namespace GLFragment {
 	return NULL;
     }
 
+    static unsigned int
+    signatureHash (const FunctionId *signature,
+		   unsigned int     nSignature)
+    {
+	unsigned int hash = 2166136261u;
+
+	/* FNV-1a over the function ids */
+	for (unsigned int i = 0; i < nSignature; i++)
+	{
+	    hash ^= signature[i];
+	    hash *= 16777619u;
+	}
+
+	return hash;
+    }
+
     static Program *
     findFragmentProgram (GLScreen     *s,
 			 FunctionId   *signature,
@@ -224,8 +242,16 @@ namespace GLFragment {
     {
 	unsigned int i;
 
-	foreach (Program *p, s->fragmentStorage ()->programs)
+	std::pair<Storage::ProgramMap::iterator,
+		  Storage::ProgramMap::iterator> range =
+	    s->fragmentStorage ()->programs.equal_range
+		(signatureHash (signature, nSignature));
+
+	for (Storage::ProgramMap::iterator it = range.first;
+	     it != range.second; it++)
 	{
+	    Program *p = it->second;
+
 	    if (p->signature.size () != nSignature)
 		continue;
 
@@ -239,6 +265,32 @@ namespace GLFragment {
 	return NULL;
     }
 
+    static GLuint
+    compileFragmentProgram (const CompString &source)
+    {
+	GLuint  name = 0;
+	GLint   errorPos;
+	GLenum  errorType;
+
+	glGetError ();
+
+	(*GL::genPrograms) (1, &name);
+	(*GL::bindProgram) (GL_FRAGMENT_PROGRAM_ARB, name);
+	(*GL::programString) (GL_FRAGMENT_PROGRAM_ARB,
+			      GL_PROGRAM_FORMAT_ASCII_ARB,
+			      source.size (), source.c_str ());
+
+	glGetIntegerv (GL_PROGRAM_ERROR_POSITION_ARB, &errorPos);
+	errorType = glGetError ();
+	if (errorType != GL_NO_ERROR || errorPos != -1)
+	{
+	    (*GL::deletePrograms) (1, &name);
+	    name = 0;
+	}
+
+	return name;
+    }
+
     static unsigned int
     functionMaskToType (int mask)
     {
@@ -523,11 +575,10 @@ namespace GLFragment {
 			  PrivateAttrib *attrib)
     {
 	Program	                *program;
+	Storage                 *storage = s->fragmentStorage ();
 	std::vector<Function *> functionList (1);
 	int                     mask = COMP_FUNCTION_MASK;
 	int                     type;
-	GLint                   errorPos;
-	GLenum			errorType;
 	CompString fetchData;
 	bool       indices[MAX_FRAGMENT_FUNCTIONS];
 	int        i;
@@ -580,26 +631,31 @@ namespace GLFragment {
 
 	program->type = GL_FRAGMENT_PROGRAM_ARB;
 
-	glGetError ();
-
-	(*GL::genPrograms) (1, &program->name);
-	(*GL::bindProgram) (GL_FRAGMENT_PROGRAM_ARB, program->name);
-	(*GL::programString) (GL_FRAGMENT_PROGRAM_ARB,
-			      GL_PROGRAM_FORMAT_ASCII_ARB,
-			      fetchData.size (), fetchData.c_str ());
+	/* the expensive part is the compile in the driver, so reuse a
+	   program compiled from the cache at startup when we have one */
+	std::map<CompString, GLuint>::iterator pc =
+	    storage->precompiled.find (fetchData);
+	if (pc != storage->precompiled.end ())
+	{
+	    program->name = pc->second;
+	    storage->precompiled.erase (pc);
+	}
+	else
+	{
+	    program->name = compileFragmentProgram (fetchData);
+	}
 
-	glGetIntegerv (GL_PROGRAM_ERROR_POSITION_ARB, &errorPos);
-	errorType = glGetError ();
-	if (errorType != GL_NO_ERROR || errorPos != -1)
+	if (!program->name)
 	{
 	    compLogMessage ("opengl", CompLogLevelError,
 			    "failed to load fragment program");
 
-	    (*GL::deletePrograms) (1, &program->name);
-
-	    program->name = 0;
 	    program->type = 0;
 	}
+	else if (!storage->cacheFile.empty ())
+	{
+	    storage->usedSources.insert (fetchData);
+	}
 
 	return program;
     }
@@ -621,7 +677,10 @@ namespace GLFragment {
 	    program = buildFragmentProgram (s, attrib);
 	    if (program)
 	    {
-		s->fragmentStorage ()->programs.push_back (program);
+		s->fragmentStorage ()->programs.insert
+		    (std::make_pair (signatureHash (attrib->function,
+						    attrib->nFunction),
+				     program));
 	    }
 	}
 
@@ -1042,33 +1101,30 @@ namespace GLFragment {
 	if (!function)
 	    return;
 
-	std::vector<Program *>::iterator it;
+	Storage::ProgramMap           &programs = s->fragmentStorage ()->programs;
+	Storage::ProgramMap::iterator it = programs.begin ();
 
-	do {
+	while (it != programs.end ())
+	{
 	    program = NULL;
 
-	    it = s->fragmentStorage ()->programs.begin ();
-
-	    for (; it != s->fragmentStorage ()->programs.end (); it++)
-	    {
-		foreach (FunctionId i, (*it)->signature)
-		    if (i == id)
-		    {
-			program = (*it);
-			break;
-		    }
-
-		if (program)
+	    foreach (FunctionId i, it->second->signature)
+		if (i == id)
+		{
+		    program = it->second;
 		    break;
-	    }
+		}
 
 	    if (program)
 	    {
 		delete program;
-		s->fragmentStorage ()->programs.erase (it);
+		programs.erase (it++);
 	    }
-
-	} while (program);
+	    else
+	    {
+		it++;
+	    }
+	}
 
 	std::vector<Function *>::iterator fi =
 	    std::find (s->fragmentStorage ()->functions.begin (),
@@ -1123,7 +1179,11 @@ namespace GLFragment {
     Storage::Storage () :
 	lastFunctionId (1),
 	functions (0),
-	programs (0)
+	programs (),
+	precompiled (),
+	usedSources (),
+	cacheFile (),
+	cacheDriver ()
     {
 	for (int i = 0; i < 64; i++)
 	{
@@ -1134,12 +1194,134 @@ namespace GLFragment {
 
     Storage::~Storage ()
     {
-	foreach (Program *p, programs)
-	    delete p;
+	saveProgramCache ();
+
+	foreach (ProgramMap::value_type &p, programs)
+	    delete p.second;
 	programs.clear ();
+
+	freeUnusedPrograms ();
+
 	foreach (Function *f, functions)
 	    delete f;
 	functions.clear ();
     }
 
+
+    /* The cache file holds the driver string on the first line, followed
+       by the source of one fragment program per line */
+    void
+    Storage::loadProgramCache (const CompString &file,
+			       const CompString &driver)
+    {
+	FILE *fp;
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+
+	cacheFile   = file;
+	cacheDriver = driver;
+
+	fp = fopen (file.c_str (), "r");
+	if (!fp)
+	    return;
+
+	/* programs compiled by a different driver may not be valid */
+	len = getline (&line, &size, fp);
+	if (len > 0 && line[len - 1] == '\n')
+	    line[--len] = '\0';
+
+	if (len > 0 && driver == line)
+	{
+	    while ((len = getline (&line, &size, fp)) > 0)
+	    {
+		GLuint name;
+
+		if (line[len - 1] == '\n')
+		    line[--len] = '\0';
+
+		CompString source (line, len);
+
+		if (source.empty () || precompiled.count (source))
+		    continue;
+
+		/* only programs that get used are saved again, so that
+		   programs that are not needed anymore drop out */
+		name = compileFragmentProgram (source);
+		if (name)
+		    precompiled[source] = name;
+	    }
+
+	    (*GL::bindProgram) (GL_FRAGMENT_PROGRAM_ARB, 0);
+
+	    compLogMessage ("opengl", CompLogLevelDebug,
+			    "precompiled %d cached fragment programs",
+			    (int) precompiled.size ());
+	}
+
+	free (line);
+	fclose (fp);
+    }
+
+    /* Precompiled programs that nothing asked for by the time startup
+       is done are unlikely to be needed, they get compiled on demand
+       if they are */
+    void
+    Storage::freeUnusedPrograms ()
+    {
+	if (precompiled.empty ())
+	    return;
+
+	compLogMessage ("opengl", CompLogLevelDebug,
+			"freeing %d unused precompiled fragment programs",
+			(int) precompiled.size ());
+
+	for (std::map<CompString, GLuint>::iterator it = precompiled.begin ();
+	     it != precompiled.end (); it++)
+	    (*GL::deletePrograms) (1, &it->second);
+	precompiled.clear ();
+    }
+
+    void
+    Storage::saveProgramCache ()
+    {
+	CompString tmpFile;
+	FILE       *fp;
+	bool       status;
+
+	if (cacheFile.empty () || usedSources.empty ())
+	    return;
+
+	/* write a new file and rename it over the old one, so that a
+	   crash or a second instance never leaves a truncated cache */
+	tmpFile = cacheFile + ".tmp";
+
+	fp = fopen (tmpFile.c_str (), "w");
+	if (!fp)
+	{
+	    compLogMessage ("opengl", CompLogLevelWarn,
+			    "Could not write fragment program cache %s",
+			    tmpFile.c_str ());
+	    return;
+	}
+
+	fprintf (fp, "%s\n", cacheDriver.c_str ());
+
+	foreach (const CompString &source, usedSources)
+	    if (source.find ('\n') == CompString::npos)
+		fprintf (fp, "%s\n", source.c_str ());
+
+	status = !ferror (fp);
+	if (fclose (fp))
+	    status = false;
+
+	if (!status || rename (tmpFile.c_str (), cacheFile.c_str ()))
+	{
+	    compLogMessage ("opengl", CompLogLevelWarn,
+			    "Could not write fragment program cache %s",
+			    cacheFile.c_str ());
+	    unlink (tmpFile.c_str ());
+	}
+    }
+
 };
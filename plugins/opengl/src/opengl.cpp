@@ -69,6 +69,27 @@ PrivateGLScreen::setOption (const CompString  &name,
     return rv;
 }
 
+bool
+PrivateGLScreen::setOptionForPlugin (const char        *plugin,
+				     const char        *name,
+				     CompOption::Value &v)
+{
+    bool status = screen->setOptionForPlugin (plugin, name, v);
+
+    if (status && strcmp (plugin, "composite") == 0)
+	updateBypassOptions ();
+
+    return status;
+}
+
+void
+PrivateGLScreen::updateBypassOptions ()
+{
+    unredirectFS =
+	cScreen->getOption ("unredirect_fullscreen_windows")->value ().b ();
+    unredirectDelay = cScreen->getOption ("unredirect_delay")->value ().i ();
+}
+
 class OpenglPluginVTable :
     public CompPlugin::VTableForScreenAndWindow<GLScreen, GLWindow>
 {
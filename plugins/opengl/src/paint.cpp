@@ -203,18 +203,18 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
     CompWindow    *w;
     GLWindow      *gw;
     int		  count, windowMask, odMask;
-    CompWindow	  *fullscreenWindow = NULL;
-    bool          status, unredirectFS;
+    bool          status;
     bool          withOffset = false;
     GLMatrix      vTransform;
     CompPoint     offXY;
 
+    CompOutput::vector  &outputs = screen->outputDevs ();
+    std::vector<Window> candidates;
+    std::vector<bool>   covered;
+
     CompWindowList                   pl;
     CompWindowList::reverse_iterator rit;
 
-    unredirectFS = CompositeScreen::get (screen)->
-	getOption ("unredirect_fullscreen_windows")->value ().b ();
-
     if (mask & PAINT_SCREEN_TRANSFORMED_MASK)
     {
 	windowMask     = PAINT_WINDOW_ON_TRANSFORMED_SCREEN_MASK;
@@ -228,6 +228,14 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
 
     pl = cScreen->getWindowPaintList ();
 
+    /* nothing can be unredirected on a transformed screen */
+    if (count == 0 && unredirectFS &&
+	!(mask & PAINT_SCREEN_NO_OCCLUSION_DETECTION_MASK))
+    {
+	candidates.resize (outputs.size (), None);
+	covered.resize (outputs.size (), false);
+    }
+
     if (!(mask & PAINT_SCREEN_NO_OCCLUSION_DETECTION_MASK))
     {
 	/* detect occlusions */
@@ -283,21 +291,34 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
 		}
 		else
 		    tmpRegion -= w->region ();
+	    }
 
-		/* unredirect top most fullscreen windows. */
-		if (count == 0 && unredirectFS)
+	    /* unredirect the top most window of an output if it covers
+	       exactly that output or the whole screen */
+	    if (!candidates.empty ())
+	    {
+		bool fullscreen = status && !withOffset &&
+				  w->region () == screen->region ();
+
+		for (unsigned int i = 0; i < outputs.size (); i++)
+		    if (covered[i])
+			fullscreen = false;
+
+		for (unsigned int i = 0; i < outputs.size (); i++)
 		{
-		    if (w->region () == screen->region () &&
-			tmpRegion.isEmpty ())
-		    {
-			fullscreenWindow = w;
-		    }
-		    else
-		    {
-			foreach (CompOutput &o, screen->outputDevs ())
-			    if (w->region () == CompRegion (o))
-				fullscreenWindow = w;
-		    }
+		    if (covered[i])
+			continue;
+
+		    if (fullscreen ||
+			(status && !withOffset &&
+			 w->region () == CompRegion (outputs[i])))
+			candidates[i] = w->id ();
+
+		    /* transformed windows can be painted anywhere */
+		    if (gw->lastMask () & PAINT_WINDOW_TRANSFORMED_MASK ||
+			withOffset ||
+			w->region ().intersects (outputs[i]))
+			covered[i] = true;
 		}
 	    }
 
@@ -305,8 +326,7 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
 	}
     }
 
-    if (fullscreenWindow)
-	CompositeWindow::get (fullscreenWindow)->unredirect ();
+    updateBypass (candidates);
 
     if (!(mask & PAINT_SCREEN_NO_BACKGROUND_MASK))
 	paintBackground (tmpRegion, (mask & PAINT_SCREEN_TRANSFORMED_MASK));
@@ -317,7 +337,7 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
 	if (w->destroyed ())
 	    continue;
 
-	if (w == fullscreenWindow)
+	if (isBypassed (w))
 	    continue;
 
 	if (!w->shaded ())
@@ -351,6 +371,144 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
     }
 }
 
+GLBypassOutput::GLBypassOutput () :
+    window (None),
+    candidate (None),
+    backoff (0),
+    bypassTime (0)
+{
+    since.tv_sec  = 0;
+    since.tv_usec = 0;
+}
+
+/* An unredirected window is redirected as soon as anything else gets
+   painted on its output, as the other window would not be visible
+   otherwise. Only unredirection waits for the window to stay on top for
+   the configured delay, and that delay doubles every time a window had
+   to be redirected again shortly after, so that a fullscreen window
+   with tooltips or menus popping up over it settles on staying
+   redirected instead of flipping back and forth, which costs a pixmap
+   rebind and a full repaint every time. */
+void
+PrivateGLScreen::updateBypass (const std::vector<Window> &candidates)
+{
+    struct timeval now;
+    int            elapsed, delay, timeout = 0;
+
+    gettimeofday (&now, 0);
+    elapsed = TIMEVALDIFF (&now, &lastBypassUpdate);
+    lastBypassUpdate = now;
+
+    /* handle clock rollback */
+    if (elapsed < 0)
+	elapsed = 0;
+
+    for (unsigned int i = 0; i < bypass.size (); i++)
+    {
+	GLBypassOutput &b = bypass[i];
+	Window         candidate = candidates.empty () ? None : candidates[i];
+
+	if (b.window)
+	{
+	    CompWindow *w = screen->findWindow (b.window);
+
+	    if (!w || !w->isViewable () ||
+		CompositeWindow::get (w)->redirected ())
+	    {
+		endBypass (i);
+	    }
+	    else
+	    {
+		b.bypassTime += elapsed;
+
+		if (candidate != b.window)
+		{
+		    if (TIMEVALDIFF (&now, &b.since) < BYPASS_STABLE_TIME)
+			b.backoff = MIN (b.backoff + 1, MAX_BYPASS_BACKOFF);
+
+		    endBypass (i);
+		}
+		else if (TIMEVALDIFF (&now, &b.since) >= BYPASS_STABLE_TIME)
+		{
+		    b.backoff = 0;
+		}
+	    }
+	}
+
+	if (b.window || !candidate)
+	{
+	    b.candidate = None;
+	    continue;
+	}
+
+	if (candidate != b.candidate)
+	{
+	    b.candidate = candidate;
+	    b.since     = now;
+	}
+
+	delay = unredirectDelay << b.backoff;
+
+	if (TIMEVALDIFF (&now, &b.since) >= delay)
+	{
+	    CompWindow *w = screen->findWindow (candidate);
+
+	    if (w)
+	    {
+		CompositeWindow::get (w)->unredirect ();
+
+		b.window    = candidate;
+		b.candidate = None;
+		b.since     = now;
+	    }
+	}
+	else
+	{
+	    timeout = MAX (timeout, delay - TIMEVALDIFF (&now, &b.since));
+	}
+    }
+
+    /* make sure there is a repaint to re-evaluate things when the
+       delay expires even if nothing else gets damaged */
+    if (timeout > 0)
+	bypassTimer.start (timeout, timeout + 10);
+    else
+	bypassTimer.stop ();
+}
+
+void
+PrivateGLScreen::endBypass (unsigned int output)
+{
+    GLBypassOutput &b = bypass[output];
+
+    compLogMessage ("opengl", CompLogLevelDebug,
+		    "output %d: redirecting window 0x%x, %u ms unredirected "
+		    "in total", output, (int) b.window, b.bypassTime);
+
+    /* the window is redirected again when it is painted */
+    b.window = None;
+}
+
+bool
+PrivateGLScreen::isBypassed (CompWindow *w)
+{
+    foreach (GLBypassOutput &b, bypass)
+	if (b.window == w->id ())
+	    return true;
+
+    return false;
+}
+
+bool
+PrivateGLScreen::handleBypassTimeout ()
+{
+    for (unsigned int i = 0; i < bypass.size (); i++)
+	if (bypass[i].window || bypass[i].candidate)
+	    cScreen->damageRegion (CompRegion (screen->outputDevs ()[i]));
+
+    return false;
+}
+
 void
 GLScreen::glEnableOutputClipping (const GLMatrix   &transform,
 				  const CompRegion &region,
@@ -1181,8 +1339,25 @@ GLWindow::glDraw (const GLMatrix     &transform,
 	mask |= PAINT_WINDOW_BLEND_MASK;
 
     GLTexture::MatrixList ml (1);
+    GLTexture             *thumbnail = priv->updateThumbnail ();
+
+    if (thumbnail)
+    {
+	CompRect input (priv->window->inputRect ());
 
-    if (priv->textures.size () == 1)
+	/* map the input rect of the window to the whole thumbnail */
+	ml[0] = thumbnail->matrix ();
+	ml[0].xx *= (float) thumbnail->width ()  / input.width ();
+	ml[0].yy *= (float) thumbnail->height () / input.height ();
+	ml[0].x0 -= input.x () * ml[0].xx;
+	ml[0].y0 -= input.y () * ml[0].yy;
+
+	priv->geometry.reset ();
+	glAddGeometry (ml, priv->window->region (), reg);
+	if (priv->geometry.vCount)
+	    glDrawTexture (thumbnail, fragment, mask);
+    }
+    else if (priv->textures.size () == 1)
     {
 	ml[0] = priv->matrices[0];
 	priv->geometry.reset ();
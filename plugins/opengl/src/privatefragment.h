@@ -29,7 +29,12 @@
 #define _PRIVATEFRAGMENT_H
 
 #include <vector>
+#include <map>
+#include <set>
 
+#include <GL/gl.h>
+
+#include <core/core.h>
 #include <opengl/fragment.h>
 
 namespace GLFragment {
@@ -38,16 +43,32 @@ namespace GLFragment {
     class Program;
 
     class Storage {
+	public:
+	    /* programs keyed by the hash of their function signature */
+	    typedef std::multimap<unsigned int, Program *> ProgramMap;
+
 	public:
 	    Storage ();
 	    ~Storage ();
 
+	    void loadProgramCache (const CompString &file,
+				   const CompString &driver);
+	    void saveProgramCache ();
+	    void freeUnusedPrograms ();
+
 	public:
 	    int lastFunctionId;
 	    std::vector<Function *> functions;
-	    std::vector<Program *> programs;
+	    ProgramMap programs;
 
 	    FunctionId saturateFunction[2][64];
+
+	    /* programs compiled at startup from the on-disk cache,
+	       keyed by their source */
+	    std::map<CompString, GLuint> precompiled;
+	    std::set<CompString>         usedSources;
+	    CompString                   cacheFile;
+	    CompString                   cacheDriver;
     };
 };
 
@@ -38,6 +38,12 @@
 
 extern CompOutput *targetOutput;
 
+/* an unredirected window that is redirected again within this many ms
+   makes the next unredirection on its output wait twice as long, up to
+   MAX_BYPASS_BACKOFF times */
+#define BYPASS_STABLE_TIME 5000
+#define MAX_BYPASS_BACKOFF 4
+
 class GLIcon
 {
     public:
@@ -47,6 +53,21 @@ class GLIcon
 	GLTexture::List textures;
 };
 
+/* Fullscreen unredirection state of a single output */
+class GLBypassOutput
+{
+    public:
+	GLBypassOutput ();
+
+	Window         window;    /* window unredirected on this output */
+	Window         candidate; /* window waiting to be unredirected */
+	struct timeval since;     /* when the candidate showed up, or when
+				     the window was unredirected */
+	unsigned int   backoff;   /* unredirect delay is doubled this many
+				     times */
+	unsigned int   bypassTime;
+};
+
 class PrivateGLScreen :
     public ScreenInterface,
     public CompositeScreen::PaintHandler,
@@ -58,6 +79,12 @@ class PrivateGLScreen :
 
 	bool setOption (const CompString &name, CompOption::Value &value);
 
+	bool setOptionForPlugin (const char        *plugin,
+				 const char        *name,
+				 CompOption::Value &v);
+
+	void updateBypassOptions ();
+
 	void handleEvent (XEvent *event);
 
 	void outputChangeNotify ();
@@ -84,6 +111,14 @@ class PrivateGLScreen :
 
 	void updateView ();
 
+	void loadFragmentProgramCache ();
+	bool handleProgramCacheTimeout ();
+
+	void updateBypass (const std::vector<Window> &candidates);
+	void endBypass (unsigned int output);
+	bool isBypassed (CompWindow *w);
+	bool handleBypassTimeout ();
+
     public:
 
 	GLScreen        *gScreen;
@@ -101,6 +136,7 @@ class PrivateGLScreen :
 	CompPoint rasterPos;
 
 	GLFragment::Storage fragmentStorage;
+	CompTimer           programCacheTimer;
 
 	GLfloat projection[16];
 
@@ -121,6 +157,27 @@ class PrivateGLScreen :
 	bool hasCompositing;
 
 	GLIcon defaultIcon;
+
+	bool                        unredirectFS;
+	int                         unredirectDelay;
+	std::vector<GLBypassOutput> bypass;
+	struct timeval              lastBypassUpdate;
+	CompTimer                   bypassTimer;
+
+	bool handleThumbnailTimeout ();
+	bool handleThumbnailExpireTimeout ();
+
+	GLuint thumbnailFbo;
+
+	/* windows that have a thumbnail, and those whose thumbnail waits
+	   for the update interval to pass */
+	CompositeWindowSet thumbnailWindows;
+	CompositeWindowSet staleThumbnails;
+	CompTimer          thumbnailTimer;
+	CompTimer          thumbnailExpireTimer;
+
+	unsigned int thumbnailRenders;
+	unsigned int thumbnailDraws;
 };
 
 class PrivateGLWindow :
@@ -139,12 +196,18 @@ class PrivateGLWindow :
 	void setWindowMatrix ();
 	void updateWindowRegions ();
 
+	void damageTextures ();
+
+	GLTexture * updateThumbnail ();
+	bool renderThumbnail (int width, int height);
+
 	CompWindow      *window;
 	GLWindow        *gWindow;
 	CompositeWindow *cWindow;
 	GLScreen        *gScreen;
 
 	GLTexture::List       textures;
+	std::vector<TfpTexture *> tfpTextures;
 	GLTexture::MatrixList matrices;
 	CompRegion::Vector    regions;
 	bool                  updateReg;
@@ -166,6 +229,14 @@ class PrivateGLWindow :
 	GLWindow::Geometry geometry;
 
 	std::list<GLIcon> icons;
+
+	/* scaled down copy of the textures for plugins that draw the
+	   window small, see thumbnail.cpp */
+	GLTexture::List thumbnail;
+	float           thumbnailScale;
+	bool            thumbnailDamaged;
+	struct timeval  thumbnailTime;
+	struct timeval  thumbnailUsed;
 };
 
 
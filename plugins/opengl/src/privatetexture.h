@@ -28,8 +28,6 @@
 #ifndef _PRIVATETEXTURE_H
 #define _PRIVATETEXTURE_H
 
-#include <map>
-
 #include <GL/gl.h>
 #include <GL/glx.h>
 #include <opengl/texture.h>
@@ -68,6 +66,8 @@ class TfpTexture : public GLTexture {
 
 	void enable (Filter filter);
 
+	void damageNotify ();
+
 	static List bindPixmapToTexture (Pixmap pixmap,
 					 int width,
 					 int height,
@@ -76,10 +76,13 @@ class TfpTexture : public GLTexture {
     public:
 	GLXPixmap pixmap;
 	bool      damaged;
-	Damage    damage;
+	bool      windowOwned;
 	bool      updateMipMap;
-};
 
-extern std::map<Damage, TfpTexture*> boundPixmapTex;
+	/* set by GLWindow::bind while it binds the window pixmap */
+	static bool bindingWindow;
+
+	static unsigned int rebinds;
+};
 
 #endif
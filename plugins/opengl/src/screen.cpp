@@ -29,6 +29,8 @@
 
 #include <dlfcn.h>
 #include <math.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 
 namespace GL {
     GLXBindTexImageProc      bindTexImage = NULL;
@@ -61,6 +63,13 @@ namespace GL {
     GLFramebufferTexture2DProc   framebufferTexture2D = NULL;
     GLGenerateMipmapProc         generateMipmap = NULL;
 
+    GLGenBuffersProc    genBuffers = NULL;
+    GLDeleteBuffersProc deleteBuffers = NULL;
+    GLBindBufferProc    bindBuffer = NULL;
+    GLBufferDataProc    bufferData = NULL;
+    GLMapBufferProc     mapBuffer = NULL;
+    GLUnmapBufferProc   unmapBuffer = NULL;
+
     bool  textureFromPixmap = true;
     bool  textureRectangle = false;
     bool  textureNonPowerOfTwo = false;
@@ -70,6 +79,7 @@ namespace GL {
     bool  textureCompression = false;
     GLint maxTextureSize = 0;
     bool  fbo = false;
+    bool  pixelBufferObject = false;
     bool  fragmentProgram = false;
     GLint maxTextureUnits = 1;
 
@@ -359,6 +369,30 @@ GLScreen::GLScreen (CompScreen *s) :
 	    GL::fbo = true;
     }
 
+    if (strstr (glExtensions, "GL_ARB_pixel_buffer_object"))
+    {
+	GL::genBuffers = (GL::GLGenBuffersProc)
+	    getProcAddress ("glGenBuffersARB");
+	GL::deleteBuffers = (GL::GLDeleteBuffersProc)
+	    getProcAddress ("glDeleteBuffersARB");
+	GL::bindBuffer = (GL::GLBindBufferProc)
+	    getProcAddress ("glBindBufferARB");
+	GL::bufferData = (GL::GLBufferDataProc)
+	    getProcAddress ("glBufferDataARB");
+	GL::mapBuffer = (GL::GLMapBufferProc)
+	    getProcAddress ("glMapBufferARB");
+	GL::unmapBuffer = (GL::GLUnmapBufferProc)
+	    getProcAddress ("glUnmapBufferARB");
+
+	if (GL::genBuffers    &&
+	    GL::deleteBuffers &&
+	    GL::bindBuffer    &&
+	    GL::bufferData    &&
+	    GL::mapBuffer     &&
+	    GL::unmapBuffer)
+	    GL::pixelBufferObject = true;
+    }
+
     if (strstr (glExtensions, "GL_ARB_texture_compression"))
 	GL::textureCompression = true;
 
@@ -531,6 +565,8 @@ GLScreen::GLScreen (CompScreen *s) :
     if (GL::textureFromPixmap)
 	registerBindPixmap (TfpTexture::bindPixmapToTexture);
 
+    if (GL::fragmentProgram && priv->optionGetFragmentProgramCache ())
+	priv->loadFragmentProgramCache ();
 }
 
 GLScreen::~GLScreen ()
@@ -555,13 +591,94 @@ PrivateGLScreen::PrivateGLScreen (GLScreen   *gs) :
     outputRegion (),
     pendingCommands (false),
     bindPixmap (),
-    hasCompositing (false)
+    hasCompositing (false),
+    bypass (screen->outputDevs ().size ()),
+    thumbnailFbo (0),
+    thumbnailRenders (0),
+    thumbnailDraws (0)
 {
     ScreenInterface::setHandler (screen);
+
+    updateBypassOptions ();
+
+    gettimeofday (&lastBypassUpdate, 0);
+    bypassTimer.setCallback (boost::bind (&PrivateGLScreen::handleBypassTimeout,
+					  this));
+
+    thumbnailTimer.setCallback (
+	boost::bind (&PrivateGLScreen::handleThumbnailTimeout, this));
+    thumbnailExpireTimer.setCallback (
+	boost::bind (&PrivateGLScreen::handleThumbnailExpireTimeout, this));
 }
 
 PrivateGLScreen::~PrivateGLScreen ()
 {
+    compLogMessage ("opengl", CompLogLevelDebug,
+		    "texture from pixmap: %u rebinds",
+		    TfpTexture::rebinds);
+
+    for (unsigned int i = 0; i < bypass.size (); i++)
+	compLogMessage ("opengl", CompLogLevelDebug,
+			"output %d: %u ms with unredirected fullscreen window",
+			i, bypass[i].bypassTime);
+
+    compLogMessage ("opengl", CompLogLevelDebug,
+		    "thumbnails: %u drawn, %u rendered",
+		    thumbnailDraws, thumbnailRenders);
+
+    if (thumbnailFbo)
+	(*GL::deleteFramebuffers) (1, &thumbnailFbo);
+}
+
+#define HOMECOMPIZDIR ".compiz-1"
+#define FRAGMENT_CACHE_FILE "fragment-programs"
+
+/* time after startup that precompiled programs are kept around for */
+#define FRAGMENT_CACHE_STARTUP_TIME 30000
+
+void
+PrivateGLScreen::loadFragmentProgramCache ()
+{
+    char       *home = getenv ("HOME");
+    const char *vendor, *renderer, *version;
+    CompString path, driver;
+
+    if (!home)
+	return;
+
+    path  = home;
+    path += "/";
+    path += HOMECOMPIZDIR;
+    mkdir (path.c_str (), 0700);
+    path += "/opengl";
+    mkdir (path.c_str (), 0700);
+    path += "/";
+    path += FRAGMENT_CACHE_FILE;
+
+    vendor   = (const char *) glGetString (GL_VENDOR);
+    renderer = (const char *) glGetString (GL_RENDERER);
+    version  = (const char *) glGetString (GL_VERSION);
+
+    driver = compPrintf ("%s|%s|%s", vendor ? vendor : "",
+			 renderer ? renderer : "", version ? version : "");
+
+    fragmentStorage.loadProgramCache (path, driver);
+
+    if (!fragmentStorage.precompiled.empty ())
+    {
+	programCacheTimer.setCallback (
+	    boost::bind (&PrivateGLScreen::handleProgramCacheTimeout, this));
+	programCacheTimer.start (FRAGMENT_CACHE_STARTUP_TIME,
+				 FRAGMENT_CACHE_STARTUP_TIME + 5000);
+    }
+}
+
+bool
+PrivateGLScreen::handleProgramCacheTimeout ()
+{
+    fragmentStorage.freeUnusedPrograms ();
+
+    return false;
 }
 
 GLushort defaultColor[4] = { 0xffff, 0xffff, 0xffff, 0xffff };
@@ -616,12 +733,11 @@ PrivateGLScreen::handleEvent (XEvent *event)
 	    {
 		XDamageNotifyEvent *de = (XDamageNotifyEvent *) event;
 
-		std::map<Damage, TfpTexture*>::iterator it =
-		    boundPixmapTex.find (de->damage);
-		if (it != boundPixmapTex.end ())
-		{
-		    it->second->damaged = true;
-		}
+		/* damage events come in bursts for the same window, so
+		   this is mostly served from the last found window cache */
+		w = screen->findWindow (de->drawable);
+		if (w)
+		    GLWindow::get (w)->priv->damageTextures ();
 	    }
 	    break;
     }
@@ -715,6 +831,11 @@ PrivateGLScreen::outputChangeNotify ()
 {
     screen->outputChangeNotify ();
 
+    /* unredirected windows get redirected again as soon as they are
+       painted, so the per output state can simply start over */
+    bypass.clear ();
+    bypass.resize (screen->outputDevs ().size ());
+
     updateView ();
 }
 
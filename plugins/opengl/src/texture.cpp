@@ -38,7 +38,9 @@
 #include <privatetexture.h>
 #include "privates.h"
 
-std::map<Damage, TfpTexture*> boundPixmapTex;
+bool TfpTexture::bindingWindow = false;
+
+unsigned int TfpTexture::rebinds = 0;
 
 static GLTexture::Matrix _identity_matrix = {
     1.0f, 0.0f,
@@ -418,8 +420,8 @@ GLTexture::bindPixmapToTexture (Pixmap pixmap,
 
 TfpTexture::TfpTexture () :
     pixmap (0),
-    damaged (true),
-    damage (None),
+    damaged (false),
+    windowOwned (false),
     updateMipMap (true)
 {
 }
@@ -438,12 +440,17 @@ TfpTexture::~TfpTexture ()
 	glDisable (target ());
 
 	GL::destroyPixmap (screen->dpy (), pixmap);
-
-	boundPixmapTex.erase (damage);
-	XDamageDestroy (screen->dpy (), damage);
     }
 }
 
+/* Nothing is rebound until the texture is actually enabled, so
+   occluded or offscreen windows never pay for it */
+void
+TfpTexture::damageNotify ()
+{
+    damaged = true;
+}
+
 GLTexture::List
 TfpTexture::bindPixmapToTexture (Pixmap pixmap,
 				 int    width,
@@ -570,6 +577,7 @@ TfpTexture::bindPixmapToTexture (Pixmap pixmap,
     tex->setData (texTarget, matrix, mipmap);
     tex->setGeometry (0, 0, width, height);
     tex->pixmap = glxPixmap;
+    tex->windowOwned = bindingWindow;
 
     rv[0] = tex;
 
@@ -583,10 +591,6 @@ TfpTexture::bindPixmapToTexture (Pixmap pixmap,
 
     glBindTexture (texTarget, 0);
 
-    tex->damage = XDamageCreate (screen->dpy (), pixmap,
-			         XDamageReportRawRectangles);
-    boundPixmapTex[tex->damage] = tex;
-
     return rv;
 }
 
@@ -596,10 +600,16 @@ TfpTexture::enable (GLTexture::Filter filter)
     glEnable (target ());
     glBindTexture (target (), name ());
 
+    /* only windows report when the contents of their pixmap change,
+       other pixmaps are rebound whenever they are used */
+    if (!windowOwned)
+	damaged = true;
+
     if (damaged && pixmap)
     {
 	(*GL::releaseTexImage) (screen->dpy (), pixmap, GLX_FRONT_LEFT_EXT);
 	(*GL::bindTexImage) (screen->dpy (), pixmap, GLX_FRONT_LEFT_EXT, NULL);
+	rebinds++;
     }
 
     GLTexture::enable (filter);
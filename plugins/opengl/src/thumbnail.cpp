@@ -0,0 +1,295 @@
+/*
+ * Copyright © 2008 Dennis Kasprzyk
+ * Copyright © 2007 Novell, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Dennis Kasprzyk not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Dennis Kasprzyk makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * DENNIS KASPRZYK DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL DENNIS KASPRZYK BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Authors: Dennis Kasprzyk <onestone@compiz-fusion.org>
+ *          David Reveman <davidr@novell.com>
+ */
+
+#include <math.h>
+
+#include "privates.h"
+
+/* thumbnails that were not drawn for this long are dropped */
+#define THUMBNAIL_EXPIRE_TIME 5000
+
+/* a thumbnail is kept while the window is drawn at between half and
+   all of its size, so that scale animations only need a new one every
+   now and then, and new ones are rounded up to this many pixels */
+#define THUMBNAIL_SIZE_STEP 16
+
+void
+GLWindow::setThumbnailScale (float scale)
+{
+    priv->thumbnailScale = scale;
+}
+
+GLTexture *
+GLWindow::thumbnail ()
+{
+    if (priv->thumbnail.empty () ||
+	priv->thumbnailScale >=
+	priv->gScreen->priv->optionGetThumbnailThreshold ())
+	return NULL;
+
+    return priv->thumbnail[0];
+}
+
+bool
+PrivateGLWindow::renderThumbnail (int width,
+				  int height)
+{
+    PrivateGLScreen *ps = gScreen->priv;
+    CompRect        input (window->inputRect ());
+    GLenum          target, status;
+
+    if (thumbnail.empty () ||
+	thumbnail[0]->width () != width || thumbnail[0]->height () != height)
+    {
+	thumbnail = GLTexture::imageDataToTexture (NULL,
+						   CompSize (width, height),
+						   GL_BGRA, GL_UNSIGNED_BYTE);
+	if (thumbnail.empty ())
+	    return false;
+
+	/* the texture may have been given a compressed format, which
+	   can't be rendered to, and it is only ever drawn small */
+	target = thumbnail[0]->target ();
+
+	glBindTexture (target, thumbnail[0]->name ());
+	glTexImage2D (target, 0, GL_RGBA, width, height, 0,
+		      GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture (target, 0);
+
+	thumbnail[0]->setMipmap (false);
+	thumbnail[0]->setFilter (GL_LINEAR);
+    }
+
+    target = thumbnail[0]->target ();
+
+    if (!ps->thumbnailFbo)
+	(*GL::genFramebuffers) (1, &ps->thumbnailFbo);
+
+    (*GL::bindFramebuffer) (GL_FRAMEBUFFER_EXT, ps->thumbnailFbo);
+    (*GL::framebufferTexture2D) (GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+				 target, thumbnail[0]->name (), 0);
+
+    status = (*GL::checkFramebufferStatus) (GL_FRAMEBUFFER_EXT);
+    if (status != GL_FRAMEBUFFER_COMPLETE_EXT)
+    {
+	compLogMessage ("opengl", CompLogLevelWarn,
+			"Thumbnail framebuffer incomplete: 0x%x", status);
+
+	(*GL::bindFramebuffer) (GL_FRAMEBUFFER_EXT, 0);
+	return false;
+    }
+
+    glPushAttrib (GL_VIEWPORT_BIT | GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT |
+		  GL_PIXEL_MODE_BIT);
+
+    glDrawBuffer (GL_COLOR_ATTACHMENT0_EXT);
+    glReadBuffer (GL_COLOR_ATTACHMENT0_EXT);
+
+    glDisable (GL_CLIP_PLANE0);
+    glDisable (GL_CLIP_PLANE1);
+    glDisable (GL_CLIP_PLANE2);
+    glDisable (GL_CLIP_PLANE3);
+    glDisable (GL_SCISSOR_TEST);
+    glDisable (GL_CULL_FACE);
+    glDisable (GL_BLEND);
+
+    /* the top of the window goes to the first row, like it does for
+       textures made from images */
+    glViewport (0, 0, width, height);
+    glMatrixMode (GL_PROJECTION);
+    glPushMatrix ();
+    glLoadIdentity ();
+    glOrtho (input.x1 (), input.x2 (), input.y1 (), input.y2 (), -1.0, 1.0);
+    glMatrixMode (GL_MODELVIEW);
+    glPushMatrix ();
+    glLoadIdentity ();
+
+    glClearColor (0.0f, 0.0f, 0.0f, 0.0f);
+    glClear (GL_COLOR_BUFFER_BIT);
+
+    /* straight copy of the window textures, the thumbnail is drawn
+       through glDraw later so plugins get to change it then */
+    for (unsigned int i = 0; i < textures.size (); i++)
+    {
+	GLTexture         *t = textures[i];
+	GLTexture::Matrix &m = matrices[i];
+	int               x1 = input.x () + t->x1 ();
+	int               y1 = input.y () + t->y1 ();
+	int               x2 = input.x () + t->x2 ();
+	int               y2 = input.y () + t->y2 ();
+
+	t->enable (GLTexture::Good);
+
+	glBegin (GL_QUADS);
+	glTexCoord2f (COMP_TEX_COORD_X (m, x1), COMP_TEX_COORD_Y (m, y1));
+	glVertex2i (x1, y1);
+	glTexCoord2f (COMP_TEX_COORD_X (m, x1), COMP_TEX_COORD_Y (m, y2));
+	glVertex2i (x1, y2);
+	glTexCoord2f (COMP_TEX_COORD_X (m, x2), COMP_TEX_COORD_Y (m, y2));
+	glVertex2i (x2, y2);
+	glTexCoord2f (COMP_TEX_COORD_X (m, x2), COMP_TEX_COORD_Y (m, y1));
+	glVertex2i (x2, y1);
+	glEnd ();
+
+	t->disable ();
+    }
+
+    glMatrixMode (GL_PROJECTION);
+    glPopMatrix ();
+    glMatrixMode (GL_MODELVIEW);
+    glPopMatrix ();
+
+    (*GL::bindFramebuffer) (GL_FRAMEBUFFER_EXT, 0);
+
+    glPopAttrib ();
+
+    ps->thumbnailRenders++;
+
+    return true;
+}
+
+GLTexture *
+PrivateGLWindow::updateThumbnail ()
+{
+    PrivateGLScreen *ps = gScreen->priv;
+    CompRect        input (window->inputRect ());
+    struct timeval  now;
+    int             width, height, interval;
+    bool            resized = false;
+
+    if (!GL::fbo || thumbnailScale >= ps->optionGetThumbnailThreshold ())
+	return NULL;
+
+    if (input.isEmpty ())
+	return NULL;
+
+    width  = MAX (1, ceilf (input.width ()  * thumbnailScale));
+    height = MAX (1, ceilf (input.height () * thumbnailScale));
+
+    if (thumbnail.empty ()                     ||
+	thumbnail[0]->width ()  < width        ||
+	thumbnail[0]->height () < height       ||
+	thumbnail[0]->width ()  > 2 * width    ||
+	thumbnail[0]->height () > 2 * height)
+    {
+	width  = (width  + THUMBNAIL_SIZE_STEP - 1) & ~(THUMBNAIL_SIZE_STEP - 1);
+	height = (height + THUMBNAIL_SIZE_STEP - 1) & ~(THUMBNAIL_SIZE_STEP - 1);
+
+	width  = MIN (width, input.width ());
+	height = MIN (height, input.height ());
+
+	resized = true;
+    }
+    else
+    {
+	width  = thumbnail[0]->width ();
+	height = thumbnail[0]->height ();
+    }
+
+    gettimeofday (&now, 0);
+
+    if (resized || thumbnailDamaged)
+    {
+	interval = ps->optionGetThumbnailUpdateInterval ();
+
+	/* a window that keeps changing gets a new thumbnail once per
+	   interval, the timer makes sure the last change shows up */
+	if (resized || TIMEVALDIFF (&now, &thumbnailTime) >= interval ||
+	    TIMEVALDIFF (&now, &thumbnailTime) < 0)
+	{
+	    if (!renderThumbnail (width, height))
+	    {
+		thumbnail.clear ();
+		ps->thumbnailWindows.remove (window);
+
+		return NULL;
+	    }
+
+	    thumbnailTime    = now;
+	    thumbnailDamaged = false;
+	}
+	else if (!ps->staleThumbnails.contains (window))
+	{
+	    int timeout = interval - TIMEVALDIFF (&now, &thumbnailTime);
+
+	    ps->staleThumbnails.add (window);
+
+	    if (!ps->thumbnailTimer.active ())
+		ps->thumbnailTimer.start (timeout, timeout + 10);
+	}
+    }
+
+    if (!ps->thumbnailWindows.contains (window))
+    {
+	ps->thumbnailWindows.add (window);
+
+	if (!ps->thumbnailExpireTimer.active ())
+	    ps->thumbnailExpireTimer.start (THUMBNAIL_EXPIRE_TIME / 2,
+					    THUMBNAIL_EXPIRE_TIME / 2 + 100);
+    }
+
+    thumbnailUsed = now;
+    ps->thumbnailDraws++;
+
+    return thumbnail[0];
+}
+
+bool
+PrivateGLScreen::handleThumbnailTimeout ()
+{
+    /* the damage gets the windows painted again, which updates their
+       thumbnails */
+    foreach (CompWindow *w, staleThumbnails.windows ())
+	CompositeWindow::get (w)->addDamage ();
+
+    staleThumbnails.clear ();
+
+    return false;
+}
+
+bool
+PrivateGLScreen::handleThumbnailExpireTimeout ()
+{
+    struct timeval now;
+
+    gettimeofday (&now, 0);
+
+    foreach (CompWindow *w, thumbnailWindows.windows ())
+    {
+	PrivateGLWindow *gw = GLWindow::get (w)->priv;
+	int             unused = TIMEVALDIFF (&now, &gw->thumbnailUsed);
+
+	if (unused >= THUMBNAIL_EXPIRE_TIME || unused < 0)
+	{
+	    gw->thumbnail.clear ();
+	    thumbnailWindows.remove (w);
+	    staleThumbnails.remove (w);
+	}
+    }
+
+    return !thumbnailWindows.empty ();
+}
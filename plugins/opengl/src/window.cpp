@@ -53,18 +53,25 @@ PrivateGLWindow::PrivateGLWindow (CompWindow *w,
     cWindow (CompositeWindow::get (w)),
     gScreen (GLScreen::get (screen)),
     textures (),
+    tfpTextures (),
     regions (),
     updateReg (true),
     clip (),
     bindFailed (false),
     geometry (),
-    icons ()
+    icons (),
+    thumbnail (),
+    thumbnailScale (1.0f),
+    thumbnailDamaged (true)
 {
     paint.xScale	= 1.0f;
     paint.yScale	= 1.0f;
     paint.xTranslate	= 0.0f;
     paint.yTranslate	= 0.0f;
 
+    thumbnailTime.tv_sec  = thumbnailTime.tv_usec = 0;
+    thumbnailUsed.tv_sec  = thumbnailUsed.tv_usec = 0;
+
     WindowInterface::setHandler (w);
     CompositeWindowInterface::setHandler (cWindow);
 }
@@ -95,11 +102,16 @@ GLWindow::bind ()
     if ((!priv->cWindow->pixmap () && !priv->cWindow->bind ()))
 	return false;
 
+    /* The window damage already tells us when the pixmap contents
+       change, so the textures don't need a damage object of their own */
+    TfpTexture::bindingWindow = true;
     priv->textures =
 	GLTexture::bindPixmapToTexture (priv->cWindow->pixmap (),
 					priv->cWindow->size ().width (),
 					priv->cWindow->size ().height (),
 					priv->window->depth ());
+    TfpTexture::bindingWindow = false;
+
     if (priv->textures.empty ())
     {
 	compLogMessage ("opengl", CompLogLevelInfo,
@@ -107,8 +119,18 @@ GLWindow::bind ()
 			"texture\n", (int) priv->window->id ());
     }
 
+    priv->tfpTextures.clear ();
+    foreach (GLTexture *t, priv->textures)
+    {
+	TfpTexture *tfp = dynamic_cast<TfpTexture *> (t);
+
+	if (tfp)
+	    priv->tfpTextures.push_back (tfp);
+    }
+
     priv->setWindowMatrix ();
     priv->updateReg = true;
+    priv->thumbnailDamaged = true;
 
     return true;
 }
@@ -116,6 +138,7 @@ GLWindow::bind ()
 void
 GLWindow::release ()
 {
+    priv->tfpTextures.clear ();
     priv->textures.clear ();
 
     if (priv->cWindow->pixmap ())
@@ -182,6 +205,7 @@ PrivateGLWindow::resizeNotify (int dx, int dy, int dwidth, int dheight)
     window->resizeNotify (dx, dy, dwidth, dheight);
     setWindowMatrix ();
     updateReg = true;
+    thumbnailDamaged = true;
     if (!window->hasUnmapReference ())
 	gWindow->release ();
 }
@@ -357,6 +381,15 @@ PrivateGLWindow::updateWindowRegions ()
     updateReg = false;
 }
 
+void
+PrivateGLWindow::damageTextures ()
+{
+    foreach (TfpTexture *tfp, tfpTextures)
+	tfp->damageNotify ();
+
+    thumbnailDamaged = true;
+}
+
 unsigned int
 GLWindow::lastMask () const
 {
@@ -0,0 +1,474 @@
+/*
+ * Copyright (C) 2001 Havoc Pennington
+ * Copyright (C) 2002, 2003 Red Hat, Inc.
+ * Copyright (C) 2003 Rob Adams
+ * Copyright (C) 2005 Novell, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+
+#include "cascade.h"
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+/* space between top-left corners of cascades */
+#define CASCADE_INTERVAL 50
+
+namespace {
+
+/* ties are broken by stacking order so that windows added later go
+   after the ones with the same edges */
+struct CompareTopmost {
+    const std::vector<PlaceCascadeWindow> &w;
+
+    CompareTopmost (const std::vector<PlaceCascadeWindow> &w) : w (w) {}
+
+    bool operator () (int a, int b) const
+    {
+	if (w[a].y1 != w[b].y1)
+	    return w[a].y1 < w[b].y1;
+	if (w[a].x1 != w[b].x1)
+	    return w[a].x1 < w[b].x1;
+	return a < b;
+    }
+};
+
+struct CompareLeftmost {
+    const std::vector<PlaceCascadeWindow> &w;
+
+    CompareLeftmost (const std::vector<PlaceCascadeWindow> &w) : w (w) {}
+
+    bool operator () (int a, int b) const
+    {
+	if (w[a].x1 != w[b].x1)
+	    return w[a].x1 < w[b].x1;
+	if (w[a].y1 != w[b].y1)
+	    return w[a].y1 < w[b].y1;
+	return a < b;
+    }
+};
+
+/* windows whose left edge is right of a value */
+struct CompareLeftEdge {
+    const std::vector<PlaceCascadeWindow> &w;
+
+    CompareLeftEdge (const std::vector<PlaceCascadeWindow> &w) : w (w) {}
+
+    bool operator () (int x, int b) const
+    {
+	return x < w[b].x1;
+    }
+};
+
+struct CompareRightmost {
+    const std::vector<PlaceCascadeWindow> &w;
+
+    CompareRightmost (const std::vector<PlaceCascadeWindow> &w) : w (w) {}
+
+    bool operator () (int a, int b) const
+    {
+	if (w[a].x2 != w[b].x2)
+	    return w[a].x2 < w[b].x2;
+	return a < b;
+    }
+};
+
+struct CompareBottommost {
+    const std::vector<PlaceCascadeWindow> &w;
+
+    CompareBottommost (const std::vector<PlaceCascadeWindow> &w) : w (w) {}
+
+    bool operator () (int a, int b) const
+    {
+	if (w[a].y2 != w[b].y2)
+	    return w[a].y2 < w[b].y2;
+	return a < b;
+    }
+};
+
+struct CompareDistance {
+    const std::vector<int> &d;
+
+    CompareDistance (const std::vector<int> &d) : d (d) {}
+
+    bool operator () (int a, int b) const
+    {
+	if (d[a] != d[b])
+	    return d[a] < d[b];
+	return a < b;
+    }
+};
+
+template <typename Compare>
+void
+insertSorted (std::vector<int> &list,
+	      int              i,
+	      Compare          compare)
+{
+    list.insert (std::upper_bound (list.begin (), list.end (), i, compare), i);
+}
+
+bool
+sameWindow (const PlaceCascadeWindow &a,
+	    const PlaceCascadeWindow &b)
+{
+    return a.x1 == b.x1 && a.y1 == b.y1 && a.x2 == b.x2 && a.y2 == b.y2 &&
+	   a.x == b.x && a.y == b.y && a.obstacle == b.obstacle;
+}
+
+}
+
+void
+PlaceCascadeIndex::update (const std::vector<PlaceCascadeWindow> &newWindows)
+{
+    unsigned int n = windows.size ();
+    bool         keep = newWindows.size () >= n;
+
+    for (unsigned int i = 0; keep && i < n; i++)
+	keep = sameWindow (windows[i], newWindows[i]);
+
+    if (!keep)
+    {
+	windows.clear ();
+	distance.clear ();
+	top.clear ();
+	left.clear ();
+	right.clear ();
+	bottom.clear ();
+	corner.clear ();
+
+	n = 0;
+    }
+
+    for (unsigned int i = n; i < newWindows.size (); i++)
+    {
+	const PlaceCascadeWindow &w = newWindows[i];
+
+	windows.push_back (w);
+
+	/* probably there's a fast good-enough-guess we could use here. */
+	distance.push_back (sqrt (w.x1 * w.x1 + w.y1 * w.y1));
+
+	insert (i);
+    }
+}
+
+void
+PlaceCascadeIndex::insert (int i)
+{
+    insertSorted (top, i, CompareTopmost (windows));
+    insertSorted (left, i, CompareLeftmost (windows));
+    insertSorted (right, i, CompareRightmost (windows));
+    insertSorted (bottom, i, CompareBottommost (windows));
+    insertSorted (corner, i, CompareDistance (distance));
+}
+
+/* counts an obstacle in or out for the spots with ys[y1] to ys[y2 - 1] */
+void
+PlaceCascadeIndex::add (int y1,
+			int y2,
+			int delta)
+{
+    unsigned int n = ys.size ();
+
+    for (unsigned int j = y1 + 1; j <= n; j += j & -j)
+	tree[j] += delta;
+    for (unsigned int j = y2 + 1; j <= n; j += j & -j)
+	tree[j] -= delta;
+}
+
+bool
+PlaceCascadeIndex::covered (int y) const
+{
+    int count = 0;
+
+    for (unsigned int j = y + 1; j > 0; j -= j & -j)
+	count += tree[j];
+
+    return count > 0;
+}
+
+/* A width by height frame at x, y overlaps a window if x is in
+   [x1 - width + 1, x2) and y in [y1 - height + 1, y2). The spots below
+   the windows come in the order of their left edges and those to the
+   right in the order of their right edges, so sweeping over all of them
+   from left to right while counting the obstacles whose x range covers
+   the current x for every spot y needs no sorting, and every spot is
+   tested in O(log n) instead of against every window. */
+bool
+PlaceCascadeIndex::firstFit (int areaX,
+			     int areaY,
+			     int areaRight,
+			     int areaBottom,
+			     int width,
+			     int height,
+			     int *x,
+			     int *y)
+{
+    unsigned int n = windows.size ();
+    unsigned int b = 0, r = 0, s = 0, e = 0;
+    int          centerX, centerY, centerRow, best = -1;
+    bool         centerDone = false;
+
+    /* The point here is to tile a window such that "extra" space is
+       equal on either side (i.e. so a full screen of windows tiled
+       this way would center the windows as a group) */
+    centerX = areaX + ((areaRight - areaX) % (width + 1)) / 2;
+    centerY = areaY + ((areaBottom - areaY) % (height + 1)) / 3;
+
+    rows.resize (n);
+
+    /* the spots below windows are at their bottom edges, those to the
+       right at their top edges */
+    ys.clear ();
+    for (unsigned int i = 0, j = 0; i < n || j < n;)
+    {
+	bool fromBottom;
+	int  v;
+
+	fromBottom = j == n ||
+		     (i < n && windows[bottom[i]].y2 < windows[top[j]].y1);
+	v = fromBottom ? windows[bottom[i]].y2 : windows[top[j]].y1;
+
+	if (ys.empty () || ys.back () != v)
+	    ys.push_back (v);
+
+	if (fromBottom)
+	    rows[bottom[i++]].bottom = ys.size () - 1;
+	else
+	    rows[top[j++]].top = ys.size () - 1;
+    }
+
+    centerRow = std::lower_bound (ys.begin (), ys.end (), centerY) -
+		ys.begin ();
+
+    if (centerRow == (int) ys.size () || ys[centerRow] != centerY)
+    {
+	ys.insert (ys.begin () + centerRow, centerY);
+
+	for (unsigned int i = 0; i < n; i++)
+	{
+	    if (rows[i].top >= centerRow)
+		rows[i].top++;
+	    if (rows[i].bottom >= centerRow)
+		rows[i].bottom++;
+	}
+    }
+
+    /* a frame overlaps a window from height - 1 pixels above its top
+       edge on */
+    for (unsigned int i = 0, k = 0; i < n; i++)
+    {
+	while (k < ys.size () && ys[k] < windows[top[i]].y1 - height + 1)
+	    k++;
+
+	rows[top[i]].reach       = k;
+	rows[top[i]].belowOrder  = 1 + i;
+	rows[left[i]].rightOrder = 1 + n + i;
+    }
+
+    tree.assign (ys.size () + 1, 0);
+
+    for (;;)
+    {
+	int spotX = 0, spotRow = 0, order = 0;
+
+	/* next spot from the left: below a window, to the right of one
+	   or the center */
+	if (b < n && (r == n || windows[left[b]].x1 <= windows[right[r]].x2))
+	{
+	    spotX   = windows[left[b]].x1;
+	    spotRow = rows[left[b]].bottom;
+	    order   = rows[left[b]].belowOrder;
+	}
+	else if (r < n)
+	{
+	    spotX   = windows[right[r]].x2;
+	    spotRow = rows[right[r]].top;
+	    order   = rows[right[r]].rightOrder;
+	}
+	else if (centerDone)
+	{
+	    break;
+	}
+
+	if (!centerDone && (b + r == 2 * n || centerX < spotX))
+	{
+	    spotX      = centerX;
+	    spotRow    = centerRow;
+	    order      = 0;
+	    centerDone = true;
+	}
+	else if (order <= (int) n)
+	{
+	    b++;
+	}
+	else
+	{
+	    r++;
+	}
+
+	if (width <= 0 || height <= 0)
+	    continue;
+
+	/* obstacles whose x range starts at or before the spot */
+	for (; s < n && windows[left[s]].x1 - width + 1 <= spotX; s++)
+	{
+	    const PlaceCascadeWindow &w = windows[left[s]];
+
+	    if (w.obstacle && w.x1 < w.x2 && w.y1 < w.y2)
+		add (rows[left[s]].reach, rows[left[s]].bottom, 1);
+	}
+
+	/* and those whose x range ends at or before it */
+	for (; e < n && windows[right[e]].x2 <= spotX; e++)
+	{
+	    const PlaceCascadeWindow &w = windows[right[e]];
+
+	    if (w.obstacle && w.x1 < w.x2 && w.y1 < w.y2)
+		add (rows[right[e]].reach, rows[right[e]].bottom, -1);
+	}
+
+	if (best >= 0 && order >= best)
+	    continue;
+
+	if (spotX < areaX || spotX + width > areaRight ||
+	    ys[spotRow] < areaY || ys[spotRow] + height > areaBottom)
+	    continue;
+
+	if (covered (spotRow))
+	    continue;
+
+	best = order;
+	*x   = spotX;
+	*y   = ys[spotRow];
+
+	if (best == 0)
+	    break;
+    }
+
+    return best >= 0;
+}
+
+/* The window nearly at the cascade point that comes first in the
+   order of the corners after the one at position after, or -1. Only
+   the windows whose left edge is within the threshold are looked at,
+   they are next to each other in the left edge list. */
+int
+PlaceCascadeIndex::inTheWay (int cascadeX,
+			     int cascadeY,
+			     int xThreshold,
+			     int yThreshold,
+			     int after)
+{
+    std::vector<int>::iterator it;
+    int                        first = -1;
+
+    it = std::upper_bound (left.begin (), left.end (),
+			   cascadeX - xThreshold,
+			   CompareLeftEdge (windows));
+
+    for (; it != left.end () && windows[*it].x1 < cascadeX + xThreshold; it++)
+    {
+	int position = cornerPosition[*it];
+
+	if (position <= after || (first >= 0 && position >= first))
+	    continue;
+
+	if (abs (windows[*it].y1 - cascadeY) < yThreshold)
+	    first = position;
+    }
+
+    return first;
+}
+
+void
+PlaceCascadeIndex::next (int areaX,
+			 int areaY,
+			 int areaRight,
+			 int areaBottom,
+			 int width,
+			 int height,
+			 int xThreshold,
+			 int yThreshold,
+			 int *x,
+			 int *y)
+{
+    int cascadeX, cascadeY;
+    int cascadeStage = 0;
+    int position = -1;
+
+    /* This is a "fuzzy" cascade algorithm. For each window in the
+       list, we find where we'd cascade a new window after it. If a
+       window is already nearly at that position, we move on. */
+
+    cornerPosition.resize (corner.size ());
+    for (unsigned int i = 0; i < corner.size (); i++)
+	cornerPosition[corner[i]] = i;
+
+    cascadeX = MAX (0, areaX);
+    cascadeY = MAX (0, areaY);
+
+    for (;;)
+    {
+	position = inTheWay (cascadeX, cascadeY, xThreshold, yThreshold,
+			     position);
+	if (position < 0)
+	    break;
+
+	const PlaceCascadeWindow &w = windows[corner[position]];
+
+	/* This window is "in the way", move to next cascade point. The
+	   new window frame should go at the origin of the client window
+	   we're stacking above. */
+	cascadeX = w.x;
+	cascadeY = w.y;
+
+	/* If we go off the screen, start over with a new cascade */
+	if (cascadeX + width > areaRight || cascadeY + height > areaBottom)
+	{
+	    cascadeX = MAX (0, areaX);
+	    cascadeY = MAX (0, areaY);
+
+	    cascadeStage += 1;
+	    cascadeX += CASCADE_INTERVAL * cascadeStage;
+
+	    /* start over with a new cascade translated to the right,
+	       unless we are out of space; like it always has, the
+	       restart goes on with the second window */
+	    if (cascadeX + width < areaRight)
+	    {
+		position = 0;
+		continue;
+	    }
+
+	    /* All out of space, this cascade_x won't work */
+	    cascadeX = MAX (0, areaX);
+	    break;
+	}
+    }
+
+    *x = cascadeX;
+    *y = cascadeY;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2001 Havoc Pennington
+ * Copyright (C) 2002, 2003 Red Hat, Inc.
+ * Copyright (C) 2003 Rob Adams
+ * Copyright (C) 2005 Novell, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _PLACE_CASCADE_H
+#define _PLACE_CASCADE_H
+
+#include <vector>
+
+/*
+ * Cascade placement without the window list of compiz, so that it can
+ * be built and measured on its own (see bench/place-bench.cpp).
+ */
+
+/* A window to place around, x2 and y2 are exclusive */
+struct PlaceCascadeWindow {
+    int  x1, y1, x2, y2; /* frame extents */
+    int  x, y;           /* position of the client window */
+    bool obstacle;       /* whether the new window may not overlap it,
+			    only true for normal, utility, toolbar and
+			    menu windows */
+};
+
+/*
+ * The windows sorted by each of their edges and by the distance of
+ * their top left corner from the origin. The lists are kept from one
+ * placement to the next and only the windows that were added since
+ * are inserted, as long as the windows before them did not change,
+ * so that a burst of new windows each placed after the ones before
+ * does not sort the screen over and over. With them all spots next to
+ * the windows are tested against the obstacles in one sweep.
+ */
+class PlaceCascadeIndex {
+    public:
+	/* Brings the lists up to date, call it before the functions
+	   below */
+	void update (const std::vector<PlaceCascadeWindow> &windows);
+
+	/* Tries to fit a width by height frame into the area, first
+	   tiled in its center, then below each window from top to
+	   bottom and then to the right of each window from left to
+	   right, with the frame aligned to the left or top edge of the
+	   window. Returns false if the frame overlaps an obstacle or
+	   leaves the area at every spot. */
+	bool firstFit (int areaX,
+		       int areaY,
+		       int areaRight,
+		       int areaBottom,
+		       int width,
+		       int height,
+		       int *x,
+		       int *y);
+
+	/* Finds the first cascade position that no frame is nearly at
+	   for a window of width by height, starting a new cascade
+	   further to the right whenever one leaves the area. Returns
+	   the position of the frame. */
+	void next (int areaX,
+		   int areaY,
+		   int areaRight,
+		   int areaBottom,
+		   int width,
+		   int height,
+		   int xThreshold,
+		   int yThreshold,
+		   int *x,
+		   int *y);
+
+    private:
+	void insert (int i);
+	void add (int y1, int y2, int delta);
+	bool covered (int y) const;
+	int inTheWay (int cascadeX,
+		      int cascadeY,
+		      int xThreshold,
+		      int yThreshold,
+		      int after);
+
+	std::vector<PlaceCascadeWindow> windows;
+	std::vector<int>                distance;
+
+	std::vector<int> top;    /* by top, then left edge */
+	std::vector<int> left;   /* by left, then top edge */
+	std::vector<int> right;  /* by right edge */
+	std::vector<int> bottom; /* by bottom edge */
+	std::vector<int> corner; /* by distance from the origin */
+
+	/* per window, the order in which firstFit tries the spots
+	   beside it and where its edges are in ys */
+	struct Row {
+	    int belowOrder, rightOrder;
+	    int top, bottom;
+	    int reach; /* first y a frame there overlaps the window at */
+	};
+
+	/* scratch space of firstFit: the y of every spot, where they
+	   are for each window and a Fenwick tree counting the obstacles
+	   the frame overlaps at each of them */
+	std::vector<int> ys;
+	std::vector<Row> rows;
+	std::vector<int> tree;
+
+	/* scratch space of next: where each window is in corner */
+	std::vector<int> cornerPosition;
+};
+
+#endif
@@ -392,53 +392,6 @@ PlaceScreen::handleEvent (XEvent *event)
     screen->handleEvent (event);
 }
 
-/* sort functions */
-
-static bool
-compareLeftmost (CompWindow *a,
-		 CompWindow *b)
-{
-    int ax, bx;
-
-    ax = a->serverX () - a->border ().left;
-    bx = b->serverX () - b->border ().left;
-
-    return (ax <= bx);
-}
-
-static bool
-compareTopmost (CompWindow *a,
-		CompWindow *b)
-{
-    int ay, by;
-
-    ay = a->serverY () - a->border ().top;
-    by = b->serverY () - b->border ().top;
-
-    return (ay <= by);
-}
-
-static bool
-compareNorthWestCorner (CompWindow *a,
-			CompWindow *b)
-{
-    int fromOriginA;
-    int fromOriginB;
-    int ax, ay, bx, by;
-
-    ax = a->serverX () - a->border ().left;
-    ay = a->serverY () - a->border ().top;
-
-    bx = b->serverX () - b->border ().left;
-    by = b->serverY () - b->border ().top;
-
-    /* probably there's a fast good-enough-guess we could use here. */
-    fromOriginA = sqrt (ax * ax + ay * ay);
-    fromOriginB = sqrt (bx * bx + by * by);
-
-    return (fromOriginA <= fromOriginB);
-}
-
 PlaceWindow::PlaceWindow (CompWindow *w) :
     PluginClassHandler<PlaceWindow, CompWindow> (w),
     mSavedOriginal (false),
@@ -818,11 +771,16 @@ PlaceWindow::doPlacement (CompPoint &pos)
 	constrainToWorkarea (workArea, pos);
 }
 
+/* arbitrary-ish threshold, honors user attempts to manually cascade */
+#define CASCADE_FUZZ 15
+
 void
 PlaceWindow::placeCascade (const CompRect &workArea,
 			   CompPoint      &pos)
 {
-    CompWindowList windows;
+    std::vector<PlaceCascadeWindow> windows;
+    CompRect                        rect = window->serverBorderRect ();
+    int                             x, y;
 
     /* Find windows that matter (not minimized, on same workspace
      * as placed window, may be shaded - if shaded we pretend it isn't
@@ -830,6 +788,9 @@ PlaceWindow::placeCascade (const CompRect &workArea,
      */
     foreach (CompWindow *w, screen->windows ())
     {
+	PlaceCascadeWindow cw;
+	CompRect           outer;
+
 	if (!windowIsPlaceRelevant (w))
 	    continue;
 
@@ -843,16 +804,51 @@ PlaceWindow::placeCascade (const CompRect &workArea,
 	    w->serverY () + w->serverGeometry ().height () <= workArea.y ())
 	    continue;
 
-	windows.push_back (w);
+	outer = w->serverBorderRect ();
+
+	cw.x1 = outer.x1 ();
+	cw.y1 = outer.y1 ();
+	cw.x2 = outer.x2 ();
+	cw.y2 = outer.y2 ();
+	cw.x  = w->serverX ();
+	cw.y  = w->serverY ();
+
+	switch (w->type ()) {
+	case CompWindowTypeNormalMask:
+	case CompWindowTypeUtilMask:
+	case CompWindowTypeToolbarMask:
+	case CompWindowTypeMenuMask:
+	    cw.obstacle = true;
+	    break;
+	default:
+	    cw.obstacle = false;
+	    break;
+	}
+
+	windows.push_back (cw);
     }
 
-    if (!cascadeFindFirstFit (windows, workArea, pos))
+    ps->cascade.update (windows);
+
+    if (!ps->cascade.firstFit (workArea.x (), workArea.y (),
+			       workArea.right (), workArea.bottom (),
+			       rect.width (), rect.height (),
+			       &x, &y))
     {
 	/* if the window wasn't placed at the origin of screen,
 	 * cascade it onto the current screen
 	 */
-	cascadeFindNext (windows, workArea, pos);
+	ps->cascade.next (workArea.x (), workArea.y (),
+			  workArea.right (), workArea.bottom (),
+			  window->serverWidth (), window->serverHeight (),
+			  MAX (window->border ().left, CASCADE_FUZZ),
+			  MAX (window->border ().top, CASCADE_FUZZ),
+			  &x, &y);
     }
+
+    /* Convert coords to position of window, not position of frame. */
+    pos.setX (x + window->border ().left);
+    pos.setY (y + window->border ().top);
 }
 
 void
@@ -899,455 +895,46 @@ PlaceWindow::placePointer (const CompRect &workArea,
 	placeCentered (workArea, pos);
 }
 
-
-/* overlap types */
-#define NONE    0
-#define H_WRONG -1
-#define W_WRONG -2
-
 void
 PlaceWindow::placeSmart (const CompRect &workArea,
 			 CompPoint      &pos)
 {
-    /*
-     * SmartPlacement by Cristian Tibirna (tibirna@kde.org)
-     * adapted for kwm (16-19jan98) and for kwin (16Nov1999) using (with
-     * permission) ideas from fvwm, authored by
-     * Anthony Martin (amartin@engr.csulb.edu).
-     * Xinerama supported added by Balaji Ramani (balaji@yablibli.com)
-     * with ideas from xfce.
-     * adapted for Compiz by Bellegarde Cedric (gnumdk(at)gmail.com)
-     */
-    int overlap, minOverlap = 0;
-    int xOptimal, yOptimal;
-    int possible;
-
-    /* temp coords */
-    int cxl, cxr, cyt, cyb;
-    /* temp coords */
-    int xl,  xr,  yt,  yb;
-    /* temp holder */
-    int basket;
-    /* CT lame flag. Don't like it. What else would do? */
-    bool firstPass = true;
-
-    /* get the maximum allowed windows space */
-    int xTmp = workArea.x ();
-    int yTmp = workArea.y ();
-
-    /* client gabarit */
-    int cw = window->serverWidth () - 1;
-    int ch = window->serverHeight () - 1;
-
-    xOptimal = xTmp;
-    yOptimal = yTmp;
-
-    /* loop over possible positions */
-    do
-    {
-	/* test if enough room in x and y directions */
-	if (yTmp + ch > workArea.bottom () && ch < workArea.height ())
-	    overlap = H_WRONG; /* this throws the algorithm to an exit */
-	else if (xTmp + cw > workArea.right ())
-	    overlap = W_WRONG;
-	else
-	{
-	    overlap = NONE; /* initialize */
-
-	    cxl = xTmp;
-	    cxr = xTmp + cw;
-	    cyt = yTmp;
-	    cyb = yTmp + ch;
-
-	    foreach (CompWindow *w, screen->windows ())
-	    {
-		if (!windowIsPlaceRelevant (w))
-		    continue;
-
-		xl = w->serverX () - w->border ().left;
-		yt = w->serverY () - w->border ().top;
-		xr = w->serverX () + w->serverWidth () +
-		     w->border ().right +
-		     w->serverGeometry ().border () * 2;
-		yb = w->serverY () + w->serverHeight () +
-		     w->border ().bottom +
-		     w->serverGeometry ().border () * 2;
-
-		/* if windows overlap, calc the overall overlapping */
-		if (cxl < xr && cxr > xl && cyt < yb && cyb > yt)
-		{
-		    xl = MAX (cxl, xl);
-		    xr = MIN (cxr, xr);
-		    yt = MAX (cyt, yt);
-		    yb = MIN (cyb, yb);
-
-		    if (w->state () & CompWindowStateAboveMask)
-			overlap += 16 * (xr - xl) * (yb - yt);
-		    else if (w->state () & CompWindowStateBelowMask)
-			overlap += 0;
-		    else
-			overlap += (xr - xl) * (yb - yt);
-		}
-	    }
-	}
-
-	/* CT first time we get no overlap we stop */
-	if (overlap == NONE)
-	{
-	    xOptimal = xTmp;
-	    yOptimal = yTmp;
-	    break;
-	}
-
-	if (firstPass)
-	{
-	    firstPass  = false;
-	    minOverlap = overlap;
-	}
-	/* CT save the best position and the minimum overlap up to now */
-	else if (overlap >= NONE && overlap < minOverlap)
-	{
-	    minOverlap = overlap;
-	    xOptimal = xTmp;
-	    yOptimal = yTmp;
-	}
-
-	/* really need to loop? test if there's any overlap */
-	if (overlap > NONE)
-	{
-	    possible = workArea.right ();
-
-	    if (possible - cw > xTmp)
-		possible -= cw;
-
-	    /* compare to the position of each client on the same desk */
-	    foreach (CompWindow *w, screen->windows ())
-	    {
-		if (!windowIsPlaceRelevant (w))
-		    continue;
-
-		xl = w->serverX () - w->border ().left;
-		yt = w->serverY () - w->border ().top;
-		xr = w->serverX () + w->serverWidth () +
-		     w->border ().right +
-		     w->serverGeometry ().border () * 2;
-		yb = w->serverY () + w->serverHeight () +
-		     w->border ().bottom +
-		     w->serverGeometry ().border () * 2;
-
-		/* if not enough room above or under the current
-		 * client determine the first non-overlapped x position
-		 */
-		if (yTmp < yb && yt < ch + yTmp)
-		{
-		    if (xr > xTmp && possible > xr)
-			possible = xr;
-
-		    basket = xl - cw;
-		    if (basket > xTmp && possible > basket)
-			possible = basket;
-		}
-	    }
-	    xTmp = possible;
-	}
-	/* else ==> not enough x dimension (overlap was wrong on horizontal) */
-	else if (overlap == W_WRONG)
-	{
-	    xTmp     = workArea.x ();
-	    possible = workArea.bottom ();
-
-	    if (possible - ch > yTmp)
-		possible -= ch;
-
-	    /* test the position of each window on the desk */
-	    foreach (CompWindow *w, screen->windows ())
-	    {
-		if (!windowIsPlaceRelevant (w))
-		    continue;
-
-		xl = w->serverX () - w->border ().left;
-		yt = w->serverY () - w->border ().top;
-		xr = w->serverX () + w->serverWidth () +
-		     w->border ().right +
-		     w->serverGeometry ().border () * 2;
-		yb = w->serverY () + w->serverHeight () +
-		     w->border ().bottom +
-		     w->serverGeometry ().border () * 2;
-
-		/* if not enough room to the left or right of the current
-		 * client determine the first non-overlapped y position
-		 */
-		if (yb > yTmp && possible > yb)
-		    possible = yb;
-
-		basket = yt - ch;
-		if (basket > yTmp && possible > basket)
-		    possible = basket;
-	    }
-	    yTmp = possible;
-	}
-    }
-    while (overlap != NONE && overlap != H_WRONG && yTmp < workArea.bottom ());
-
-    if (ch >= workArea.height ())
-	yOptimal = workArea.y ();
-
-    pos.setX (xOptimal + window->border ().left);
-    pos.setY (yOptimal + window->border ().top);
-}
-
-static void
-centerTileRectInArea (CompRect       &rect,
-		      const CompRect &workArea)
-{
-    int fluff;
-
-    /* The point here is to tile a window such that "extra"
-     * space is equal on either side (i.e. so a full screen
-     * of windows tiled this way would center the windows
-     * as a group)
-     */
-
-    fluff  = (workArea.width () % (rect.width () + 1)) / 2;
-    rect.setX (workArea.x () + fluff);
-
-    fluff  = (workArea.height () % (rect.height () + 1)) / 3;
-    rect.setY (workArea.y () + fluff);
-}
-
-static bool
-rectOverlapsWindow (const CompRect       &rect,
-		    const CompWindowList &windows)
-{
-    CompRect dest;
-
-    foreach (CompWindow *other, windows)
-    {
-	CompRect intersect;
-
-	switch (other->type ()) {
-	case CompWindowTypeDockMask:
-	case CompWindowTypeSplashMask:
-	case CompWindowTypeDesktopMask:
-	case CompWindowTypeDialogMask:
-	case CompWindowTypeModalDialogMask:
-	case CompWindowTypeFullscreenMask:
-	case CompWindowTypeUnknownMask:
-	    break;
-	case CompWindowTypeNormalMask:
-	case CompWindowTypeUtilMask:
-	case CompWindowTypeToolbarMask:
-	case CompWindowTypeMenuMask:
-	    intersect = rect & other->serverBorderRect ();
-	    if (!intersect.isEmpty ())
-		return true;
-	    break;
-	}
-    }
-
-    return false;
-}
-
-/* Find the leftmost, then topmost, empty area on the workspace
- * that can contain the new window.
- *
- * Cool feature to have: if we can't fit the current window size,
- * try shrinking the window (within geometry constraints). But
- * beware windows such as Emacs with no sane minimum size, we
- * don't want to create a 1x1 Emacs.
- */
-bool
-PlaceWindow::cascadeFindFirstFit (const CompWindowList &windows,
-				  const CompRect       &workArea,
-				  CompPoint            &pos)
-{
-    /* This algorithm is limited - it just brute-force tries
-     * to fit the window in a small number of locations that are aligned
-     * with existing windows. It tries to place the window on
-     * the bottom of each existing window, and then to the right
-     * of each existing window, aligned with the left/top of the
-     * existing window in each of those cases.
-     */
-    bool           retval = false;
-    CompWindowList belowSorted, rightSorted;
-    CompRect       rect;
-
-    /* Below each window */
-    belowSorted = windows;
-    belowSorted.sort (compareLeftmost);
-    belowSorted.sort (compareTopmost);
-
-    /* To the right of each window */
-    rightSorted = windows;
-    rightSorted.sort (compareTopmost);
-    rightSorted.sort (compareLeftmost);
-
-    rect = window->serverBorderRect ();
-    centerTileRectInArea (rect, workArea);
-
-    if (workArea.contains (rect) && !rectOverlapsWindow (rect, windows))
-    {
-	pos.setX (rect.x () + window->border ().left);
-	pos.setY (rect.y () + window->border ().top);
-	retval = true;
-    }
-
-    if (!retval)
-    {
-	/* try below each window */
-	foreach (CompWindow *w, belowSorted)
-	{
-	    CompRect outerRect;
-
-	    if (retval)
-		break;
-
-	    outerRect = w->serverBorderRect ();
-
-	    rect.setX (outerRect.x ());
-	    rect.setY (outerRect.bottom ());
-
-	    if (workArea.contains (rect) &&
-		!rectOverlapsWindow (rect, belowSorted))
-	    {
-		pos.setX (rect.x () + window->border ().left);
-		pos.setY (rect.y () + window->border ().top);
-		retval = true;
-	    }
-	}
-    }
-
-    if (!retval)
-    {
-	/* try to the right of each window */
-	foreach (CompWindow *w, rightSorted)
-	{
-	    CompRect outerRect;
-
-	    if (retval)
-		break;
-
-	    outerRect = w->serverBorderRect ();
-
-	    rect.setX (outerRect.right ());
-	    rect.setY (outerRect.y ());
-
-	    if (workArea.contains (rect) &&
-		!rectOverlapsWindow (rect, rightSorted))
-	    {
-		pos.setX (rect.x () + w->border ().left);
-		pos.setY (rect.y () + w->border ().top);
-		retval = true;
-	    }
-	}
-    }
-
-    return retval;
-}
-
-void
-PlaceWindow::cascadeFindNext (const CompWindowList &windows,
-			      const CompRect       &workArea,
-			      CompPoint            &pos)
-{
-    CompWindowList           sorted;
-    CompWindowList::iterator iter;
-    int                      cascadeX, cascadeY;
-    int                      xThreshold, yThreshold;
-    int                      winWidth, winHeight;
-    int                      cascadeStage;
-
-    sorted = windows;
-    sorted.sort (compareNorthWestCorner);
-
-    /* This is a "fuzzy" cascade algorithm.
-     * For each window in the list, we find where we'd cascade a
-     * new window after it. If a window is already nearly at that
-     * position, we move on.
-     */
-
-    /* arbitrary-ish threshold, honors user attempts to
-     * manually cascade.
-     */
-#define CASCADE_FUZZ 15
-
-    xThreshold = MAX (window->border ().left, CASCADE_FUZZ);
-    yThreshold = MAX (window->border ().top, CASCADE_FUZZ);
-
-    /* Find furthest-SE origin of all workspaces.
-     * cascade_x, cascade_y are the target position
-     * of NW corner of window frame.
-     */
-
-    cascadeX = MAX (0, workArea.x ());
-    cascadeY = MAX (0, workArea.y ());
-
-    /* Find first cascade position that's not used. */
+    std::vector<PlaceSmartWindow> windows;
+    int                           x, y;
 
-    winWidth  = window->serverWidth ();
-    winHeight = window->serverHeight ();
-
-    cascadeStage = 0;
-    for (iter = sorted.begin (); iter != sorted.end (); iter++)
+    foreach (CompWindow *w, screen->windows ())
     {
-	CompWindow *w = *iter;
-	int        wx, wy;
-
-	/* we want frame position, not window position */
-	wx = w->serverX () - w->border ().left;
-	wy = w->serverY () - w->border ().top;
-
-	if (abs (wx - cascadeX) < xThreshold &&
-	    abs (wy - cascadeY) < yThreshold)
-	{
-	    /* This window is "in the way", move to next cascade
-	     * point. The new window frame should go at the origin
-	     * of the client window we're stacking above.
-	     */
-	    wx = cascadeX = w->serverX ();
-	    wy = cascadeY = w->serverY ();
-
-	    /* If we go off the screen, start over with a new cascade */
-	    if ((cascadeX + winWidth > workArea.right ()) ||
-		(cascadeY + winHeight > workArea.bottom ()))
-	    {
-		cascadeX = MAX (0, workArea.x ());
-		cascadeY = MAX (0, workArea.y ());
+	PlaceSmartWindow sw;
 
-#define CASCADE_INTERVAL 50 /* space between top-left corners of cascades */
-
-		cascadeStage += 1;
-		cascadeX += CASCADE_INTERVAL * cascadeStage;
+	if (!windowIsPlaceRelevant (w))
+	    continue;
 
-		/* start over with a new cascade translated to the right,
-		 * unless we are out of space
-		 */
-		if (cascadeX + winWidth < workArea.right ())
-		{
-		    iter = sorted.begin ();
-		    continue;
-		}
-		else
-		{
-		    /* All out of space, this cascade_x won't work */
-		    cascadeX = MAX (0, workArea.x ());
-		    break;
-		}
-	    }
-	}
+	sw.x1 = w->serverX () - w->border ().left;
+	sw.y1 = w->serverY () - w->border ().top;
+	sw.x2 = w->serverX () + w->serverWidth () +
+		w->border ().right +
+		w->serverGeometry ().border () * 2;
+	sw.y2 = w->serverY () + w->serverHeight () +
+		w->border ().bottom +
+		w->serverGeometry ().border () * 2;
+
+	if (w->state () & CompWindowStateAboveMask)
+	    sw.weight = 16;
+	else if (w->state () & CompWindowStateBelowMask)
+	    sw.weight = 0;
 	else
-	{
-	    /* Keep searching for a further-down-the-diagonal window. */
-	}
+	    sw.weight = 1;
+
+	windows.push_back (sw);
     }
 
-    /* cascade_x and cascade_y will match the last window in the list
-     * that was "in the way" (in the approximate cascade diagonal)
-     */
+    placeSmartFit (ps->occupancy, windows, workArea.x (), workArea.y (),
+		   workArea.right (), workArea.bottom (),
+		   window->serverWidth () - 1, window->serverHeight () - 1,
+		   &x, &y);
 
-    /* Convert coords to position of window, not position of frame. */
-    pos.setX (cascadeX + window->border ().left);
-    pos.setY (cascadeY + window->border ().top);
+    pos.setX (x + window->border ().left);
+    pos.setY (y + window->border ().top);
 }
 
 bool
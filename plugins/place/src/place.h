@@ -30,6 +30,8 @@
 #include <core/pluginclasshandler.h>
 
 #include "place_options.h"
+#include "smart.h"
+#include "cascade.h"
 
 class PlaceScreen :
     public PluginClassHandler<PlaceScreen, CompScreen>,
@@ -52,6 +54,10 @@ class PlaceScreen :
 	CompTimer mResChangeFallbackHandle;
 	
 	Atom fullPlacementAtom;
+
+	/* scratch space of smart and cascade placement */
+	PlaceOccupancy    occupancy;
+	PlaceCascadeIndex cascade;
 };
 
 #define PLACE_SCREEN(s)						       \
@@ -109,13 +115,6 @@ class PlaceWindow :
 	void placePointer (const CompRect& workArea, CompPoint& pos);
 	void placeSmart (const CompRect& workArea, CompPoint& pos);
 
-	bool cascadeFindFirstFit (const CompWindowList& windows,
-				  const CompRect& workArea,
-				  CompPoint &pos);
-	void cascadeFindNext (const CompWindowList& windows,
-			      const CompRect& workArea,
-			      CompPoint &pos);
-
 	bool matchPosition (CompPoint &pos, bool& keepInWorkarea);
 	bool matchViewport (CompPoint &pos);
 
@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2001 Havoc Pennington
+ * Copyright (C) 2002, 2003 Red Hat, Inc.
+ * Copyright (C) 2003 Rob Adams
+ * Copyright (C) 2005 Novell, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/*
+ * SmartPlacement by Cristian Tibirna (tibirna@kde.org)
+ * adapted for kwm (16-19jan98) and for kwin (16Nov1999) using (with
+ * permission) ideas from fvwm, authored by
+ * Anthony Martin (amartin@engr.csulb.edu).
+ * Xinerama supported added by Balaji Ramani (balaji@yablibli.com)
+ * with ideas from xfce.
+ * adapted for Compiz by Bellegarde Cedric (gnumdk(at)gmail.com)
+ */
+
+#include <algorithm>
+
+#include "smart.h"
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define NONE    0
+#define H_WRONG -1
+#define W_WRONG -2
+
+void
+PlaceOccupancy::update (const std::vector<PlaceSmartWindow> &windows)
+{
+    unsigned int nx, ny;
+
+    xs.clear ();
+    ys.clear ();
+
+    for (unsigned int i = 0; i < windows.size (); i++)
+    {
+	const PlaceSmartWindow &w = windows[i];
+
+	if (!w.weight || w.x1 >= w.x2 || w.y1 >= w.y2)
+	    continue;
+
+	xs.push_back (w.x1);
+	xs.push_back (w.x2);
+	ys.push_back (w.y1);
+	ys.push_back (w.y2);
+    }
+
+    std::sort (xs.begin (), xs.end ());
+    xs.erase (std::unique (xs.begin (), xs.end ()), xs.end ());
+    std::sort (ys.begin (), ys.end ());
+    ys.erase (std::unique (ys.begin (), ys.end ()), ys.end ());
+
+    nx = xs.size ();
+    ny = ys.size ();
+
+    if (!nx || !ny)
+	return;
+
+    /* cell of every coordinate between the first and the last edge,
+       an edge belongs to the cell right of or below it */
+    xCell.resize (xs[nx - 1] - xs[0] + 1);
+    for (unsigned int i = 0; i + 1 < nx; i++)
+	for (int x = xs[i]; x < xs[i + 1]; x++)
+	    xCell[x - xs[0]] = i;
+    xCell[xs[nx - 1] - xs[0]] = nx - 1;
+
+    yCell.resize (ys[ny - 1] - ys[0] + 1);
+    for (unsigned int j = 0; j + 1 < ny; j++)
+	for (int y = ys[j]; y < ys[j + 1]; y++)
+	    yCell[y - ys[0]] = j;
+    yCell[ys[ny - 1] - ys[0]] = ny - 1;
+
+    /* weights at the corners of the windows, summed up below */
+    density.assign (nx * ny, 0);
+    sums.resize (nx * ny);
+    above.resize (nx * ny);
+    left.resize (nx * ny);
+
+    for (unsigned int i = 0; i < windows.size (); i++)
+    {
+	const PlaceSmartWindow &w = windows[i];
+	unsigned int           x1, x2, y1, y2;
+
+	if (!w.weight || w.x1 >= w.x2 || w.y1 >= w.y2)
+	    continue;
+
+	x1 = xCell[w.x1 - xs[0]];
+	x2 = xCell[w.x2 - xs[0]];
+	y1 = yCell[w.y1 - ys[0]];
+	y2 = yCell[w.y2 - ys[0]];
+
+	density[x1 * ny + y1] += w.weight;
+	density[x2 * ny + y1] -= w.weight;
+	density[x1 * ny + y2] -= w.weight;
+	density[x2 * ny + y2] += w.weight;
+    }
+
+    /* one column at a time, the sums along a column depend on each
+       other, those across columns can be done in any order */
+    for (unsigned int i = 0; i < nx; i++)
+    {
+	int       *d = &density[i * ny];
+	int       *a = &above[i * ny];
+	int       *l = &left[i * ny];
+	long long *s = &sums[i * ny];
+
+	for (unsigned int j = 1; j < ny; j++)
+	    d[j] += d[j - 1];
+
+	if (i)
+	{
+	    const int       *pd = d - ny;
+	    const int       *pa = a - ny;
+	    const int       *pl = l - ny;
+	    const long long *ps = s - ny;
+	    int             width = xs[i] - xs[i - 1];
+
+	    for (unsigned int j = 0; j < ny; j++)
+	    {
+		d[j] += pd[j];
+		l[j]  = pl[j] + pd[j] * width;
+		s[j]  = ps[j] + (long long) pa[j] * width;
+	    }
+	}
+	else
+	{
+	    for (unsigned int j = 0; j < ny; j++)
+	    {
+		l[j] = 0;
+		s[j] = 0;
+	    }
+	}
+
+	a[0] = 0;
+	for (unsigned int j = 1; j < ny; j++)
+	    a[j] = a[j - 1] + d[j - 1] * (ys[j] - ys[j - 1]);
+    }
+}
+
+long long
+PlaceOccupancy::integral (int x,
+			  int y) const
+{
+    unsigned int i, j, k;
+
+    if (xs.empty () || x <= xs[0] || y <= ys[0])
+	return 0;
+
+    /* the cell the point is in, past the last edge the density is 0 */
+    i = xCell[MIN (x, xs.back ()) - xs[0]];
+    j = yCell[MIN (y, ys.back ()) - ys[0]];
+    k = i * ys.size () + j;
+
+    x -= xs[i];
+    y -= ys[j];
+
+    return sums[k] + (long long) above[k] * x + (long long) left[k] * y +
+	   (long long) density[k] * x * y;
+}
+
+long long
+PlaceOccupancy::overlap (int x1,
+			 int y1,
+			 int x2,
+			 int y2) const
+{
+    return integral (x2, y2) - integral (x1, y2) -
+	   integral (x2, y1) + integral (x1, y1);
+}
+
+void
+placeSmartFit (PlaceOccupancy                      &occupancy,
+	       const std::vector<PlaceSmartWindow> &windows,
+	       int                                 areaX,
+	       int                                 areaY,
+	       int                                 areaRight,
+	       int                                 areaBottom,
+	       int                                 cw,
+	       int                                 ch,
+	       int                                 *x,
+	       int                                 *y)
+{
+    std::vector<PlaceSmartWindow> clipped;
+    std::vector<int>              yCandidates, xCandidates;
+    long long                     overlap, minOverlap = 0;
+    int                           xOptimal, yOptimal;
+    int                           possible, row;
+    /* CT lame flag. Don't like it. What else would do? */
+    bool                          firstPass = true;
+
+    /* get the maximum allowed windows space */
+    int xTmp = areaX;
+    int yTmp = areaY;
+
+    xOptimal = xTmp;
+    yOptimal = yTmp;
+
+    /* candidates never leave the work area, except at the bottom for
+       windows that are taller than it, so neither does the table */
+    for (unsigned int i = 0; i < windows.size (); i++)
+    {
+	PlaceSmartWindow w = windows[i];
+
+	w.x1 = MAX (w.x1, areaX);
+	w.x2 = MIN (w.x2, areaRight);
+	w.y1 = MAX (w.y1, areaY);
+	w.y2 = MIN (w.y2, areaBottom + ch);
+
+	clipped.push_back (w);
+    }
+
+    occupancy.update (clipped);
+
+    /* positions a new row can start at, the bottom of a window or
+       right above its top */
+    for (unsigned int i = 0; i < windows.size (); i++)
+    {
+	yCandidates.push_back (windows[i].y2);
+	yCandidates.push_back (windows[i].y1 - ch);
+    }
+
+    std::sort (yCandidates.begin (), yCandidates.end ());
+
+    /* row the x candidates were collected for */
+    row = yTmp - 1;
+
+    /* loop over possible positions */
+    do
+    {
+	/* test if enough room in x and y directions */
+	if (yTmp + ch > areaBottom && ch < areaBottom - areaY)
+	    overlap = H_WRONG; /* this throws the algorithm to an exit */
+	else if (xTmp + cw > areaRight)
+	    overlap = W_WRONG;
+	else
+	    overlap = occupancy.overlap (xTmp, yTmp, xTmp + cw, yTmp + ch);
+
+	/* CT first time we get no overlap we stop */
+	if (overlap == NONE)
+	{
+	    xOptimal = xTmp;
+	    yOptimal = yTmp;
+	    break;
+	}
+
+	if (firstPass)
+	{
+	    firstPass  = false;
+	    minOverlap = overlap;
+	}
+	/* CT save the best position and the minimum overlap up to now */
+	else if (overlap >= NONE && overlap < minOverlap)
+	{
+	    minOverlap = overlap;
+	    xOptimal = xTmp;
+	    yOptimal = yTmp;
+	}
+
+	/* really need to loop? test if there's any overlap */
+	if (overlap > NONE)
+	{
+	    std::vector<int>::iterator it;
+
+	    /* positions in this row are next to the windows that are
+	       in the way of it, right of them or right before them */
+	    if (row != yTmp)
+	    {
+		row = yTmp;
+		xCandidates.clear ();
+
+		for (unsigned int i = 0; i < windows.size (); i++)
+		{
+		    if (yTmp < windows[i].y2 && windows[i].y1 < ch + yTmp)
+		    {
+			xCandidates.push_back (windows[i].x2);
+			xCandidates.push_back (windows[i].x1 - cw);
+		    }
+		}
+
+		std::sort (xCandidates.begin (), xCandidates.end ());
+	    }
+
+	    possible = areaRight;
+
+	    if (possible - cw > xTmp)
+		possible -= cw;
+
+	    it = std::upper_bound (xCandidates.begin (), xCandidates.end (),
+				   xTmp);
+	    if (it != xCandidates.end () && *it < possible)
+		possible = *it;
+
+	    xTmp = possible;
+	}
+	/* else ==> not enough x dimension (overlap was wrong on horizontal) */
+	else if (overlap == W_WRONG)
+	{
+	    std::vector<int>::iterator it;
+
+	    xTmp     = areaX;
+	    possible = areaBottom;
+
+	    if (possible - ch > yTmp)
+		possible -= ch;
+
+	    it = std::upper_bound (yCandidates.begin (), yCandidates.end (),
+				   yTmp);
+	    if (it != yCandidates.end () && *it < possible)
+		possible = *it;
+
+	    yTmp = possible;
+	}
+    }
+    while (overlap != NONE && overlap != H_WRONG && yTmp < areaBottom);
+
+    if (ch >= areaBottom - areaY)
+	yOptimal = areaY;
+
+    *x = xOptimal;
+    *y = yOptimal;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2001 Havoc Pennington
+ * Copyright (C) 2002, 2003 Red Hat, Inc.
+ * Copyright (C) 2003 Rob Adams
+ * Copyright (C) 2005 Novell, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _PLACE_SMART_H
+#define _PLACE_SMART_H
+
+#include <vector>
+
+/*
+ * Smart placement without the window list of compiz, so that it can be
+ * built and measured on its own (see bench/place-bench.cpp).
+ */
+
+/* Frame extents of a window to place around, x2 and y2 are exclusive */
+struct PlaceSmartWindow {
+    int x1, y1, x2, y2;
+    int weight; /* how much overlapping it costs per pixel, 16 for
+		   windows kept above, 0 for those kept below, 1 else */
+};
+
+/*
+ * Sum of the weights of the windows covering each point of the screen,
+ * integrated, so that the weighted overlap of any rectangle with the
+ * windows is a few lookups. The table only has a row and a column per
+ * window edge, in between it is interpolated.
+ */
+class PlaceOccupancy {
+    public:
+	/* Fills the table for the given windows, the storage is kept
+	   from one placement to the next */
+	void update (const std::vector<PlaceSmartWindow> &windows);
+
+	/* Sum of weight times area of intersection with each window */
+	long long overlap (int x1, int y1, int x2, int y2) const;
+
+    private:
+	long long integral (int x, int y) const;
+
+	std::vector<int>          xs, ys;
+	std::vector<unsigned int> xCell, yCell;
+
+	/* per grid point, column major: the integral up to the point,
+	   the density of the cell it is the top left corner of, and the
+	   integrals of that cell's column above and row to the left */
+	std::vector<long long> sums;
+	std::vector<int>       density;
+	std::vector<int>       above;
+	std::vector<int>       left;
+};
+
+/*
+ * Finds the spot for a window of cw + 1 by ch + 1 pixels in the work
+ * area where it overlaps the other windows the least, trying the
+ * corners along the edges of other windows from top left to bottom
+ * right like the SmartPlacement of kwin does. occupancy is scratch
+ * space.
+ */
+void
+placeSmartFit (PlaceOccupancy                      &occupancy,
+	       const std::vector<PlaceSmartWindow> &windows,
+	       int                                 areaX,
+	       int                                 areaY,
+	       int                                 areaRight,
+	       int                                 areaBottom,
+	       int                                 cw,
+	       int                                 ch,
+	       int                                 *x,
+	       int                                 *y);
+
+#endif
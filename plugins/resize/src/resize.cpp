@@ -176,6 +176,14 @@ ResizeScreen::updateWindowProperty ()
 void
 ResizeScreen::finishResizing ()
 {
+    if (syncRequests || syncTimeouts)
+	compLogMessage ("resize", CompLogLevelDebug,
+			"window 0x%lx: %u sizes acknowledged in %.1f ms on "
+			"average and %.1f ms at most, %u timed out", w->id (),
+			syncRequests,
+			syncRequests ? syncTotalTime / syncRequests : 0.0,
+			syncMaxTime, syncTimeouts);
+
     w->ungrabNotify ();
 
     resizeInformationAtom.deleteProperty (w->id ());
@@ -384,6 +392,13 @@ resizeInitiate (CompAction         *action,
 	rs->w	 = w;
 	rs->mask = mask;
 
+	rs->sizePending   = false;
+	rs->syncPending   = false;
+	rs->syncRequests  = 0;
+	rs->syncTimeouts  = 0;
+	rs->syncTotalTime = 0.0;
+	rs->syncMaxTime   = 0.0;
+
 	rs->savedGeometry.x	 = server.x ();
 	rs->savedGeometry.y	 = server.y ();
 	rs->savedGeometry.width  = server.width ();
@@ -582,6 +597,19 @@ resizeTerminate (CompAction         *action,
 
 		mask = CWX | CWY | CWWidth | CWHeight;
 	    }
+	    else if (rs->sizePending)
+	    {
+		/* the last size was still waiting for the client or
+		   the next frame */
+		xwc.x      = rs->geometry.x;
+		xwc.y      = rs->geometry.y;
+		xwc.width  = rs->geometry.width;
+		xwc.height = rs->geometry.height;
+
+		mask = CWX | CWY | CWWidth | CWHeight;
+	    }
+
+	    rs->sizePending = false;
 	}
 	else
 	{
@@ -659,12 +687,41 @@ resizeTerminate (CompAction         *action,
 }
 
 
+/* Sizes are sent to the client one at a time, the next one only after
+   the client acknowledged the previous one through its sync counter,
+   and always the latest size of the pointer. When compositing they are
+   sent from preparePaint, at most once per frame. */
 void
 ResizeScreen::updateWindowSize ()
+{
+    sizePending = true;
+
+    if (cScreen && cScreen->compositingActive ())
+    {
+	cScreen->preparePaintSetEnabled (this, true);
+	cScreen->damagePending ();
+    }
+    else
+    {
+	sendWindowSize ();
+    }
+}
+
+void
+ResizeScreen::sendWindowSize ()
 {
     if (w->syncWait ())
 	return;
 
+    sizePending = false;
+
+    /* core stopped waiting for a client that did not answer */
+    if (syncPending)
+    {
+	syncPending = false;
+	syncTimeouts++;
+    }
+
     if (w->serverGeometry ().width ()  != geometry.width ||
 	w->serverGeometry ().height () != geometry.height)
     {
@@ -677,10 +734,52 @@ ResizeScreen::updateWindowSize ()
 
 	w->sendSyncRequest ();
 
+	if (w->syncWait ())
+	{
+	    syncPending = true;
+	    gettimeofday (&syncRequestTime, 0);
+	}
+
 	w->configureXWindow (CWX | CWY | CWWidth | CWHeight, &xwc);
     }
 }
 
+void
+ResizeScreen::syncAcknowledged ()
+{
+    if (syncPending)
+    {
+	struct timeval now;
+	double	       time;
+
+	gettimeofday (&now, 0);
+
+	time = (now.tv_sec - syncRequestTime.tv_sec) * 1000.0 +
+	       (now.tv_usec - syncRequestTime.tv_usec) / 1000.0;
+
+	syncPending = false;
+
+	syncRequests++;
+	syncTotalTime += time;
+	syncMaxTime    = MAX (syncMaxTime, time);
+    }
+
+    if (sizePending)
+	updateWindowSize ();
+}
+
+void
+ResizeScreen::preparePaint (int msSinceLastPaint)
+{
+    if (w && sizePending && !w->syncWait ())
+	sendWindowSize ();
+
+    if (!w || !sizePending)
+	cScreen->preparePaintSetEnabled (this, false);
+
+    cScreen->preparePaint (msSinceLastPaint);
+}
+
 void
 ResizeScreen::handleKeyEvent (KeyCode keycode)
 {
@@ -1462,7 +1561,7 @@ ResizeScreen::handleEvent (XEvent *event)
 	    sa = (XSyncAlarmNotifyEvent *) event;
 
 	    if (w->syncAlarm () == sa->alarm)
-		updateWindowSize ();
+		syncAcknowledged ();
 	}
     }
 }
@@ -1704,7 +1803,13 @@ ResizeScreen::ResizeScreen (CompScreen *s) :
     releaseButton (0),
     isConstrained (false),
     offWorkAreaConstrained (true),
-    grabWindowWorkArea (NULL)
+    grabWindowWorkArea (NULL),
+    sizePending (false),
+    syncPending (false),
+    syncRequests (0),
+    syncTimeouts (0),
+    syncTotalTime (0.0),
+    syncMaxTime (0.0)
 {
     CompOption::Vector atomTemplate;
     Display *dpy = s->dpy ();
@@ -1765,6 +1870,9 @@ ResizeScreen::ResizeScreen (CompScreen *s) :
 
     if (gScreen)
 	GLScreenInterface::setHandler (gScreen, false);
+
+    if (cScreen)
+	CompositeScreenInterface::setHandler (cScreen, false);
 }
 
 ResizeScreen::~ResizeScreen ()
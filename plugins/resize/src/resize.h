@@ -26,6 +26,8 @@
 #ifndef _RESIZE_H
 #define _RESIZE_H
 
+#include <sys/time.h>
+
 #include <core/core.h>
 #include <core/pluginclasshandler.h>
 #include <core/propertywriter.h>
@@ -64,6 +66,7 @@ struct _ResizeKeys {
 class ResizeScreen :
     public PluginClassHandler<ResizeScreen,CompScreen>,
     public GLScreenInterface,
+    public CompositeScreenInterface,
     public ScreenInterface,
     public ResizeOptions
 {
@@ -82,6 +85,10 @@ class ResizeScreen :
 	void finishResizing ();
 
 	void updateWindowSize ();
+	void sendWindowSize ();
+	void syncAcknowledged ();
+
+	void preparePaint (int);
 
 	bool glPaintOutput (const GLScreenPaintAttrib &,
 			    const GLMatrix &, const CompRegion &, CompOutput *,
@@ -149,6 +156,18 @@ class ResizeScreen :
 
 	bool		 offWorkAreaConstrained;
 	CompRect   *grabWindowWorkArea;
+
+	/* a size that waits for the next frame or for the client to
+	   acknowledge the previous one */
+	bool	       sizePending;
+	bool	       syncPending;
+	struct timeval syncRequestTime;
+
+	/* round trips of the current resize */
+	unsigned int syncRequests;
+	unsigned int syncTimeouts;
+	double	     syncTotalTime;
+	double	     syncMaxTime;
 };
 
 class ResizeWindow :
@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2005 Novell, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Novell, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Novell, Inc. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * NOVELL, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL NOVELL, INC. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Author: David Reveman <davidr@novell.com>
+ */
+
+#include <float.h>
+
+#include "assignment.h"
+
+void
+scaleAssignMinCost (const std::vector<float> &cost,
+		    int                      rows,
+		    int                      cols,
+		    std::vector<int>         &assignment)
+{
+    /* row and column potentials and the row matched to each column,
+       index 0 is a virtual column that holds the row being added */
+    std::vector<double> u (rows + 1, 0.0), v (cols + 1, 0.0);
+    std::vector<double> minv (cols + 1);
+    std::vector<int>    match (cols + 1, 0), way (cols + 1, 0);
+    std::vector<bool>   used (cols + 1);
+
+    for (int i = 1; i <= rows; i++)
+    {
+	int j0 = 0;
+
+	match[0] = i;
+	minv.assign (cols + 1, DBL_MAX);
+	used.assign (cols + 1, false);
+
+	/* grow a tree of tight edges until it reaches a free column */
+	do
+	{
+	    const float *c;
+	    double      delta = DBL_MAX;
+	    int         i0 = match[j0], j1 = 0;
+
+	    used[j0] = true;
+	    c = &cost[(i0 - 1) * cols];
+
+	    for (int j = 1; j <= cols; j++)
+	    {
+		if (used[j])
+		    continue;
+
+		double reduced = c[j - 1] - u[i0] - v[j];
+
+		if (reduced < minv[j])
+		{
+		    minv[j] = reduced;
+		    way[j]  = j0;
+		}
+
+		if (minv[j] < delta)
+		{
+		    delta = minv[j];
+		    j1    = j;
+		}
+	    }
+
+	    for (int j = 0; j <= cols; j++)
+	    {
+		if (used[j])
+		{
+		    u[match[j]] += delta;
+		    v[j]        -= delta;
+		}
+		else
+		{
+		    minv[j] -= delta;
+		}
+	    }
+
+	    j0 = j1;
+	} while (match[j0]);
+
+	/* flip the augmenting path */
+	do
+	{
+	    int j1 = way[j0];
+
+	    match[j0] = match[j1];
+	    j0 = j1;
+	} while (j0);
+    }
+
+    assignment.assign (rows, -1);
+
+    for (int j = 1; j <= cols; j++)
+	if (match[j])
+	    assignment[match[j] - 1] = j - 1;
+}
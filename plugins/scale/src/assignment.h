@@ -0,0 +1,44 @@
+/*
+ * Copyright © 2005 Novell, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Novell, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Novell, Inc. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * NOVELL, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL NOVELL, INC. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Author: David Reveman <davidr@novell.com>
+ */
+
+#ifndef _SCALE_ASSIGNMENT_H
+#define _SCALE_ASSIGNMENT_H
+
+#include <vector>
+
+/*
+ * Assigns each of rows items to a different one of cols places so
+ * that the sum of the costs of the chosen pairs is as small as
+ * possible, using the Hungarian method in O(rows² × cols). cost holds
+ * rows × cols values in row major order and rows must not be larger
+ * than cols. On return assignment[row] is the column chosen for row.
+ */
+void
+scaleAssignMinCost (const std::vector<float> &cost,
+		    int                      rows,
+		    int                      cols,
+		    std::vector<int>         &assignment);
+
+#endif
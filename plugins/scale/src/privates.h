@@ -62,7 +62,7 @@ class PrivateScaleScreen :
 	void layoutSlots ();
 	void findBestSlots ();
 	bool fillInWindows ();
-	bool layoutThumbs ();
+	bool layoutThumbs (bool keepCells = false);
 
 	SlotArea::vector getSlotAreas ();
 
@@ -124,11 +124,17 @@ class PrivateScaleScreen :
 	ScaleScreen::State state;
 	int                moreAdjust;
 
+	/* windows that have not reached their slot yet */
+	CompositeWindowSet animatingWindows;
+
 	Cursor cursor;
 
 	std::vector<ScaleSlot> slots;
 	int                  nSlots;
 
+	/* slot geometry before it was fitted to its window */
+	std::vector<CompRect> cells;
+
 	ScaleScreen::WindowList windows;
 
 	GLushort opacity;
@@ -174,6 +180,9 @@ class PrivateScaleWindow :
 	int sid;
 	int distance;
 
+	/* grid cell of the last layout, kept while scale is active */
+	CompRect cell;
+
 	GLfloat xVelocity, yVelocity, scaleVelocity;
 	GLfloat scale;
 	GLfloat tx, ty;
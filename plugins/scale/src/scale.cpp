@@ -35,6 +35,7 @@
 #include <core/atoms.h>
 #include <scale/scale.h>
 #include "privates.h"
+#include "assignment.h"
 
 #define EDGE_STATE (CompAction::StateInitEdge)
 
@@ -344,8 +345,10 @@ PrivateScaleWindow::glPaint (const GLWindowPaintAttrib& attrib,
 	    glPushMatrix ();
 	    glLoadMatrixf (wTransform.getMatrix ());
 
+	    gWindow->setThumbnailScale (scale);
 	    gWindow->glDraw (wTransform, fragment, region,
 			     mask | PAINT_WINDOW_TRANSFORMED_MASK);
+	    gWindow->setThumbnailScale (1.0f);
 
 	    glPopMatrix ();
 
@@ -396,6 +399,7 @@ PrivateScaleScreen::layoutSlotsForArea (const CompRect& workArea,
 	for (j = 0; j < n; j++)
 	{
 	    slots[this->nSlots].setGeometry (x, y, width, height);
+	    cells[this->nSlots] = slots[this->nSlots];
 
 	    slots[this->nSlots].filled = false;
 
@@ -514,43 +518,87 @@ PrivateScaleScreen::layoutSlots ()
 void
 PrivateScaleScreen::findBestSlots ()
 {
-    CompWindow *w;
-    int        i, d, d0 = 0;
-    float      sx, sy, cx, cy;
+    std::vector<ScaleWindow *> pending;
+    std::vector<int>           freeSlots, assignment;
+    std::vector<float>         cost;
+    std::vector<bool>          taken (nSlots, false);
+    CompWindow                 *w;
+    float                      sx, sy, cx, cy;
 
     foreach (ScaleWindow *sw, windows)
     {
-	w = sw->priv->window;
-
 	if (sw->priv->slot)
 	    continue;
 
-	sw->priv->sid      = 0;
-	sw->priv->distance = MAXSHORT;
-
-	for (i = 0; i < nSlots; i++)
+	/* a window keeps its cell if the new layout still has it, so
+	   that only the rows that changed move around */
+	if (!sw->priv->cell.isEmpty ())
 	{
-	    if (!slots[i].filled)
-	    {
-		sx = (slots[i].x2 () + slots[i].x1 ()) / 2;
-		sy = (slots[i].y2 () + slots[i].y1 ()) / 2;
+	    int i;
 
-		cx = w->serverX () + w->width () / 2;
-		cy = w->serverY () + w->height () / 2;
+	    for (i = 0; i < nSlots; i++)
+		if (!taken[i] && !slots[i].filled && cells[i] == sw->priv->cell)
+		    break;
 
-		cx -= sx;
-		cy -= sy;
+	    if (i < nSlots)
+	    {
+		taken[i] = true;
 
-		d = sqrt (cx * cx + cy * cy);
-		if (d0 + d < sw->priv->distance)
-		{
-		    sw->priv->sid      = i;
-		    sw->priv->distance = d0 + d;
-		}
+		sw->priv->sid      = i;
+		sw->priv->distance = 0;
+		continue;
 	    }
 	}
 
-	d0 += sw->priv->distance;
+	pending.push_back (sw);
+    }
+
+    if (pending.empty ())
+	return;
+
+    for (int i = 0; i < nSlots; i++)
+	if (!taken[i] && !slots[i].filled)
+	    freeSlots.push_back (i);
+
+    /* match the remaining windows to the free slots with the smallest
+       total distance between window and slot centers */
+    cost.resize (pending.size () * freeSlots.size ());
+
+    for (unsigned int i = 0; i < pending.size (); i++)
+    {
+	w = pending[i]->priv->window;
+
+	cx = w->serverX () + w->width () / 2;
+	cy = w->serverY () + w->height () / 2;
+
+	for (unsigned int j = 0; j < freeSlots.size (); j++)
+	{
+	    ScaleSlot &slot = slots[freeSlots[j]];
+
+	    sx = (slot.x2 () + slot.x1 ()) / 2;
+	    sy = (slot.y2 () + slot.y1 ()) / 2;
+
+	    cost[i * freeSlots.size () + j] =
+		sqrt ((cx - sx) * (cx - sx) + (cy - sy) * (cy - sy));
+	}
+    }
+
+    if (pending.size () > freeSlots.size ())
+    {
+	/* can't happen with the stock layout, fall back to the first
+	   free slots and let fillInWindows sort it out */
+	compLogMessage ("scale", CompLogLevelWarn,
+			"%d windows for %d free slots",
+			(int) pending.size (), (int) freeSlots.size ());
+	pending.resize (freeSlots.size ());
+    }
+
+    scaleAssignMinCost (cost, pending.size (), freeSlots.size (), assignment);
+
+    for (unsigned int i = 0; i < pending.size (); i++)
+    {
+	pending[i]->priv->sid      = freeSlots[assignment[i]];
+	pending[i]->priv->distance = cost[i * freeSlots.size () + assignment[i]];
     }
 }
 
@@ -571,6 +619,7 @@ PrivateScaleScreen::fillInWindows ()
 		return true;
 
 	    sw->priv->slot = &slots[sw->priv->sid];
+	    sw->priv->cell = cells[sw->priv->sid];
 
 	    /* Auxilary items reparented into windows are clickable so we want to care about
 	     * them when calculating the slot size */
@@ -598,6 +647,7 @@ PrivateScaleScreen::fillInWindows ()
 	    sw->priv->lastThumbOpacity = 0.0f;
 
 	    sw->priv->adjust = true;
+	    animatingWindows.add (sw->window);
 	}
     }
 
@@ -659,7 +709,7 @@ ScaleScreen::getWindows () const
 }
 
 bool
-PrivateScaleScreen::layoutThumbs ()
+PrivateScaleScreen::layoutThumbs (bool keepCells)
 {
     windows.clear ();
 
@@ -669,10 +719,16 @@ PrivateScaleScreen::layoutThumbs ()
 	SCALE_WINDOW (w);
 
 	if (sw->priv->slot)
+	{
 	    sw->priv->adjust = true;
+	    animatingWindows.add (w);
+	}
 
 	sw->priv->slot = NULL;
 
+	if (!keepCells)
+	    sw->priv->cell = CompRect ();
+
 	if (!sw->priv->isScaleWin ())
 	    continue;
 
@@ -683,6 +739,7 @@ PrivateScaleScreen::layoutThumbs ()
 	return false;
 
     slots.resize (windows.size ());
+    cells.resize (windows.size ());
 
     return ScaleScreen::get (screen)->layoutSlotsAndAssignWindows ();
 }
@@ -784,24 +841,22 @@ PrivateScaleScreen::preparePaint (int msSinceLastPaint)
 
 	while (steps--)
 	{
-	    moreAdjust = 0;
-
-	    foreach (CompWindow *w, screen->windows ())
+	    foreach (CompWindow *w, animatingWindows.windows ())
 	    {
 		SCALE_WINDOW (w);
 
-		if (sw->priv->adjust)
-		{
-		    sw->priv->adjust = sw->priv->adjustScaleVelocity ();
+		sw->priv->adjust = sw->priv->adjustScaleVelocity ();
 
-		    moreAdjust |= sw->priv->adjust;
+		sw->priv->tx += sw->priv->xVelocity * chunk;
+		sw->priv->ty += sw->priv->yVelocity * chunk;
+		sw->priv->scale += sw->priv->scaleVelocity * chunk;
 
-		    sw->priv->tx += sw->priv->xVelocity * chunk;
-		    sw->priv->ty += sw->priv->yVelocity * chunk;
-		    sw->priv->scale += sw->priv->scaleVelocity * chunk;
-		}
+		if (!sw->priv->adjust)
+		    animatingWindows.remove (w);
 	    }
 
+	    moreAdjust = !animatingWindows.empty ();
+
 	    if (!moreAdjust)
 		break;
 	}
@@ -942,6 +997,7 @@ PrivateScaleScreen::scaleTerminate (CompAction         *action,
 	    {
 		sw->priv->slot   = NULL;
 		sw->priv->adjust = true;
+		ss->priv->animatingWindows.add (w);
 	    }
 	}
 
@@ -1178,6 +1234,7 @@ ScaleWindow::setSlot (const ScaleSlot &newSlot)
     SCALE_SCREEN (screen);
 
     priv->adjust = true;
+    ss->priv->animatingWindows.add (window);
 
     if (!priv->slot)
 	priv->slot = new ScaleSlot ();
@@ -1225,6 +1282,7 @@ ScaleWindow::setCurrentPosition (const ScalePosition &newPos)
     priv->cWindow->addDamage ();
 
     priv->adjust = true;
+    ss->priv->animatingWindows.add (window);
 }
 
 const Window &
@@ -1364,7 +1422,7 @@ PrivateScaleScreen::windowRemove (CompWindow *w)
     {
 	if (lw->priv->window == w)
 	{
-	    if (layoutThumbs ())
+	    if (layoutThumbs (true))
 	    {
 		state = ScaleScreen::Out;
 		cScreen->damageScreen ();
@@ -1604,7 +1662,7 @@ PrivateScaleWindow::damageRect (bool            initial,
     {
 	if (spScreen->grab && isScaleWin ())
 	{
-	    if (spScreen->layoutThumbs ())
+	    if (spScreen->layoutThumbs (true))
 	    {
 		spScreen->state = ScaleScreen::Out;
 		spScreen->cScreen->damageScreen ();
@@ -106,39 +106,90 @@ ShotScreen::terminate (CompAction            *action,
     return false;
 }
 
-static int
-shotFilter (const struct dirent *d)
+/* Reads the selected area of the frame just painted. With pixel buffer
+   objects the read completes while the next frame is painted and the
+   pixels are fetched after it, otherwise they are read right away. The
+   image file is named and written by the writer thread. */
+void
+ShotScreen::capture (int x,
+		     int y,
+		     int width,
+		     int height)
 {
-    int number;
+    CompString dir (optionGetDirectory ());
+
+    if (dir.length () == 0)
+    {
+	// If dir is empty, use user's desktop directory instead
+	dir = getXDGUserDir (XDGUserDirDesktop);
+    }
 
-    if (sscanf (d->d_name, "screenshot%d.png", &number))
+    if (GL::pixelBufferObject)
     {
-	int nDigits = 0;
+	(*GL::genBuffers) (1, &mReadback);
+	(*GL::bindBuffer) (GL_PIXEL_PACK_BUFFER_ARB, mReadback);
+	(*GL::bufferData) (GL_PIXEL_PACK_BUFFER_ARB, width * height * 4,
+			   NULL, GL_STREAM_READ_ARB);
 
-	for (; number > 0; number /= 10)
-	    nDigits++;
+	glReadPixels (x, ::screen->height () - y - height, width, height,
+		      GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid *) 0);
 
-	// Make sure there are no trailing characters in the name
-	if ((int) strlen (d->d_name) == 14 + nDigits)
-	    return 1;
+	(*GL::bindBuffer) (GL_PIXEL_PACK_BUFFER_ARB, 0);
+
+	mReadbackWidth  = width;
+	mReadbackHeight = height;
+	mReadbackDir    = dir;
+
+	/* make sure there is a next frame */
+	cScreen->damagePending ();
     }
+    else
+    {
+	GLubyte *buffer;
+
+	buffer = (GLubyte *) malloc (sizeof (GLubyte) * width * height * 4);
+	if (!buffer)
+	    return;
 
-    return 0;
+	glReadPixels (x, ::screen->height () - y - height, width, height,
+		      GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid *) buffer);
+
+	mWriter.write (dir, optionGetLaunchApp (), buffer, width, height);
+    }
 }
 
-static int
-shotSort (const void *_a,
-	  const void *_b)
+void
+ShotScreen::finishReadback ()
 {
-    struct dirent **a = (struct dirent **) _a;
-    struct dirent **b = (struct dirent **) _b;
-    int		  al = strlen ((*a)->d_name);
-    int		  bl = strlen ((*b)->d_name);
+    GLubyte *data, *buffer;
+    int     size = mReadbackWidth * mReadbackHeight * 4;
+
+    (*GL::bindBuffer) (GL_PIXEL_PACK_BUFFER_ARB, mReadback);
+
+    data = (GLubyte *) (*GL::mapBuffer) (GL_PIXEL_PACK_BUFFER_ARB,
+					 GL_READ_ONLY_ARB);
+    if (data)
+    {
+	buffer = (GLubyte *) malloc (size);
+	if (buffer)
+	{
+	    memcpy (buffer, data, size);
+	    mWriter.write (mReadbackDir, optionGetLaunchApp (), buffer,
+			   mReadbackWidth, mReadbackHeight);
+	}
 
-    if (al == bl)
-	return strcoll ((*a)->d_name, (*b)->d_name);
+	(*GL::unmapBuffer) (GL_PIXEL_PACK_BUFFER_ARB);
+    }
     else
-	return al - bl;
+    {
+	compLogMessage ("screenshot", CompLogLevelError,
+			"failed to read screenshot image");
+    }
+
+    (*GL::bindBuffer) (GL_PIXEL_PACK_BUFFER_ARB, 0);
+    (*GL::deleteBuffers) (1, &mReadback);
+
+    mReadback = 0;
 }
 
 void
@@ -147,6 +198,9 @@ ShotScreen::paint (CompOutput::ptrList &outputs,
 {
     cScreen->paint (outputs, mask);
 
+    if (mReadback)
+	finishReadback ();
+
     if (mGrab)
     {
 	int x1, x2, y1, y2;
@@ -158,77 +212,16 @@ ShotScreen::paint (CompOutput::ptrList &outputs,
 
 	if (!mGrabIndex)
 	{
-	    int w = x2 - x1;
-	    int h = y2 - y1;
-
-	    if (w && h)
-	    {
-		GLubyte *buffer;
-		CompString dir (optionGetDirectory ());
-
-		if (dir.length () == 0)
-		{
-		    // If dir is empty, use user's desktop directory instead
-		    dir = getXDGUserDir (XDGUserDirDesktop);
-		}
-
-		buffer = (GLubyte *)malloc (sizeof (GLubyte) * w * h * 4);
-		if (buffer)
-		{
-		    struct dirent **namelist;
-		    int		  n;
-
-		    glReadPixels (x1, ::screen->height () - y2, w, h,
-				  GL_RGBA, GL_UNSIGNED_BYTE,
-				  (GLvoid *) buffer);
-
-		    n = scandir (dir.c_str (), &namelist, shotFilter, shotSort);
-		    if (n >= 0)
-		    {
-			char name[256];
-			int  number = 0;
-
-			if (n > 0)
-			    sscanf (namelist[n - 1]->d_name,
-				    "screenshot%d.png",
-				    &number);
-
-			number++;
-
-			if (n)
-			    free (namelist);
-
-			sprintf (name, "screenshot%d.png", number);
-
-			CompString app (optionGetLaunchApp ());
-			CompString path (dir + "/" + name);
-			CompSize imageSize (w, h);
-
-			if (!::screen->writeImageToFile (path, "png",
-							 imageSize, buffer))
-			{
-			    compLogMessage ("screenshot", CompLogLevelError,
-					    "failed to write screenshot image");
-			}
-			else if (app.length () > 0)
-			{
-			    ::screen->runCommand (app + " " + path);
-			}
-		    }
-		    else
-		    {
-			perror (dir.c_str ());
-		    }
-
-		    free (buffer);
-		}
-	    }
-
-	    // Disable screen capture
-	    cScreen->paintSetEnabled (this, false);
+	    if (x2 - x1 && y2 - y1)
+		capture (x1, y1, x2 - x1, y2 - y1);
+
 	    mGrab = false;
 	}
     }
+
+    // Disable screen capture
+    if (!mGrab && !mReadback)
+	cScreen->paintSetEnabled (this, false);
 }
 
 bool
@@ -339,7 +332,10 @@ ShotScreen::ShotScreen (CompScreen *screen) :
     cScreen (CompositeScreen::get (screen)),
     gScreen (GLScreen::get (screen)),
     mGrabIndex (0),
-    mGrab (false)
+    mGrab (false),
+    mReadback (0),
+    mReadbackWidth (0),
+    mReadbackHeight (0)
 {
     optionSetInitiateButtonInitiate (boost::bind (&ShotScreen::initiate, this,
     						  _1, _2, _3));
@@ -351,6 +347,12 @@ ShotScreen::ShotScreen (CompScreen *screen) :
     GLScreenInterface::setHandler (gScreen, false);
 }
 
+ShotScreen::~ShotScreen ()
+{
+    if (mReadback)
+	finishReadback ();
+}
+
 bool
 ShotPluginVTable::init ()
 {
@@ -25,7 +25,6 @@
 
 #include <stdlib.h>
 #include <string.h>
-#include <dirent.h>
 
 #include "screenshot_options.h"
 
@@ -36,6 +35,8 @@
 #include <composite/composite.h>
 #include <opengl/opengl.h>
 
+#include "writer.h"
+
 class ShotScreen :
     public ScreenInterface,
     public CompositeScreenInterface,
@@ -45,6 +46,7 @@ class ShotScreen :
 {
     public:
 	ShotScreen (CompScreen *screen);
+	~ShotScreen ();
 
 	bool initiate (CompAction            *action,
 		       CompAction::State     state,
@@ -64,6 +66,9 @@ class ShotScreen :
 	void paint (CompOutput::ptrList &outputs,
 		    unsigned int        mask);
 
+	void capture (int x, int y, int width, int height);
+	void finishReadback ();
+
 	CompositeScreen *cScreen;
 	GLScreen        *gScreen;
 
@@ -71,6 +76,15 @@ class ShotScreen :
 	Bool                   mGrab;
 
 	int  mX1, mY1, mX2, mY2;
+
+	/* pixel buffer a capture is read into, mapped on the next
+	   frame */
+	GLuint     mReadback;
+	int        mReadbackWidth;
+	int        mReadbackHeight;
+	CompString mReadbackDir;
+
+	ShotWriter mWriter;
 };
 
 class ShotPluginVTable :
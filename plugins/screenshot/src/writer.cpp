@@ -0,0 +1,353 @@
+/*
+ * Copyright © 2005 Novell, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Novell, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Novell, Inc. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * NOVELL, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL NOVELL, INC. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Author: David Reveman <davidr@novell.com>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <poll.h>
+
+#include <png.h>
+
+#include "writer.h"
+
+static int
+shotFilter (const struct dirent *d)
+{
+    int number;
+
+    if (sscanf (d->d_name, "screenshot%d.png", &number))
+    {
+	int nDigits = 0;
+
+	for (; number > 0; number /= 10)
+	    nDigits++;
+
+	// Make sure there are no trailing characters in the name
+	if ((int) strlen (d->d_name) == 14 + nDigits)
+	    return 1;
+    }
+
+    return 0;
+}
+
+static int
+shotSort (const void *_a,
+	  const void *_b)
+{
+    struct dirent **a = (struct dirent **) _a;
+    struct dirent **b = (struct dirent **) _b;
+    int		  al = strlen ((*a)->d_name);
+    int		  bl = strlen ((*b)->d_name);
+
+    if (al == bl)
+	return strcoll ((*a)->d_name, (*b)->d_name);
+    else
+	return al - bl;
+}
+
+/* the same encoding the imgpng plugin uses, which is not safe to call
+   from another thread */
+static bool
+writePng (FILE          *file,
+	  unsigned char *buffer,
+	  int           width,
+	  int           height)
+{
+    png_struct	 *png;
+    png_info	 *info;
+    png_byte	 **rows;
+    png_color_16 white;
+
+    rows = new png_byte *[height];
+
+    for (int i = 0; i < height; i++)
+	rows[height - i - 1] = buffer + i * width * 4;
+
+    png = png_create_write_struct (PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png)
+    {
+	delete [] rows;
+	return false;
+    }
+
+    info = png_create_info_struct (png);
+    if (!info)
+    {
+	png_destroy_write_struct (&png, NULL);
+	delete [] rows;
+	return false;
+    }
+
+    if (setjmp (png_jmpbuf (png)))
+    {
+	png_destroy_write_struct (&png, &info);
+	delete [] rows;
+	return false;
+    }
+
+    png_init_io (png, file);
+
+    png_set_IHDR (png, info, width, height, 8,
+		  PNG_COLOR_TYPE_RGB_ALPHA,
+		  PNG_INTERLACE_NONE,
+		  PNG_COMPRESSION_TYPE_DEFAULT,
+		  PNG_FILTER_TYPE_DEFAULT);
+
+    white.red   = 0xff;
+    white.blue  = 0xff;
+    white.green = 0xff;
+
+    png_set_bKGD (png, info, &white);
+
+    png_write_info (png, info);
+    png_write_image (png, rows);
+    png_write_end (png, info);
+
+    png_destroy_write_struct (&png, &info);
+    delete [] rows;
+
+    return true;
+}
+
+ShotWriter::ShotWriter () :
+    running (false),
+    quit (false),
+    wakeUpHandle (0)
+{
+    pthread_mutex_init (&mutex, NULL);
+    pthread_cond_init (&cond, NULL);
+
+    wakeUp[0] = wakeUp[1] = -1;
+}
+
+ShotWriter::~ShotWriter ()
+{
+    if (running)
+    {
+	/* images already taken are still written */
+	pthread_mutex_lock (&mutex);
+	quit = true;
+	pthread_cond_signal (&cond);
+	pthread_mutex_unlock (&mutex);
+
+	pthread_join (thread, NULL);
+
+	screen->removeWatchFd (wakeUpHandle);
+	handleDone ();
+
+	close (wakeUp[0]);
+	close (wakeUp[1]);
+    }
+
+    pthread_cond_destroy (&cond);
+    pthread_mutex_destroy (&mutex);
+}
+
+bool
+ShotWriter::start ()
+{
+    sigset_t all, old;
+
+    if (pipe (wakeUp) < 0)
+	return false;
+
+    fcntl (wakeUp[0], F_SETFL, O_NONBLOCK);
+
+    /* signals are for the main thread only */
+    sigfillset (&all);
+    pthread_sigmask (SIG_BLOCK, &all, &old);
+
+    running = !pthread_create (&thread, NULL, threadFunc, this);
+
+    pthread_sigmask (SIG_SETMASK, &old, NULL);
+
+    if (!running)
+    {
+	close (wakeUp[0]);
+	close (wakeUp[1]);
+
+	wakeUp[0] = wakeUp[1] = -1;
+	return false;
+    }
+
+    wakeUpHandle = screen->addWatchFd (wakeUp[0], POLLIN,
+				       boost::bind (&ShotWriter::handleDone,
+						    this));
+
+    return true;
+}
+
+void
+ShotWriter::write (const CompString &dir,
+		   const CompString &app,
+		   unsigned char    *buffer,
+		   int              width,
+		   int              height)
+{
+    Job *job = new Job;
+
+    job->dir       = dir;
+    job->app       = app;
+    job->buffer    = buffer;
+    job->width     = width;
+    job->height    = height;
+    job->error     = 0;
+    job->status    = false;
+
+    if (!running && !start ())
+    {
+	/* write it here then */
+	run (job);
+
+	pthread_mutex_lock (&mutex);
+	done.push_back (job);
+	pthread_mutex_unlock (&mutex);
+
+	handleDone ();
+	return;
+    }
+
+    pthread_mutex_lock (&mutex);
+    queue.push_back (job);
+    pthread_cond_signal (&cond);
+    pthread_mutex_unlock (&mutex);
+}
+
+void
+ShotWriter::run (Job *job)
+{
+    struct dirent **namelist;
+    int		  n, number = 0;
+    char	  name[256];
+    FILE	  *file;
+
+    n = scandir (job->dir.c_str (), &namelist, shotFilter, shotSort);
+    if (n < 0)
+    {
+	job->error = errno;
+	return;
+    }
+
+    if (n > 0)
+	sscanf (namelist[n - 1]->d_name, "screenshot%d.png", &number);
+
+    for (int i = 0; i < n; i++)
+	free (namelist[i]);
+
+    if (n)
+	free (namelist);
+
+    snprintf (name, 256, "screenshot%d.png", number + 1);
+
+    job->path = job->dir + "/" + name;
+
+    file = fopen (job->path.c_str (), "wb");
+    if (file)
+    {
+	job->status = writePng (file, job->buffer, job->width, job->height);
+
+	if (fclose (file))
+	    job->status = false;
+    }
+
+    free (job->buffer);
+    job->buffer = NULL;
+}
+
+void *
+ShotWriter::threadFunc (void *closure)
+{
+    ShotWriter *w = (ShotWriter *) closure;
+
+    pthread_mutex_lock (&w->mutex);
+
+    for (;;)
+    {
+	while (!w->quit && w->queue.empty ())
+	    pthread_cond_wait (&w->cond, &w->mutex);
+
+	if (w->queue.empty ())
+	    break;
+
+	Job *job = w->queue.front ();
+	w->queue.pop_front ();
+
+	pthread_mutex_unlock (&w->mutex);
+	w->run (job);
+	pthread_mutex_lock (&w->mutex);
+
+	w->done.push_back (job);
+
+	if (::write (w->wakeUp[1], "w", 1) < 0)
+	    continue;
+    }
+
+    pthread_mutex_unlock (&w->mutex);
+
+    return NULL;
+}
+
+void
+ShotWriter::handleDone ()
+{
+    std::list<Job *> jobs;
+    char	     buf[64];
+
+    if (wakeUp[0] >= 0)
+	while (read (wakeUp[0], buf, sizeof (buf)) > 0);
+
+    pthread_mutex_lock (&mutex);
+    jobs.swap (done);
+    pthread_mutex_unlock (&mutex);
+
+    foreach (Job *job, jobs)
+    {
+	if (job->error)
+	{
+	    compLogMessage ("screenshot", CompLogLevelError,
+			    "%s: %s", job->dir.c_str (),
+			    strerror (job->error));
+	}
+	else if (!job->status)
+	{
+	    compLogMessage ("screenshot", CompLogLevelError,
+			    "failed to write screenshot image");
+	}
+	else if (job->app.length () > 0 && !quit)
+	{
+	    screen->runCommand (job->app + " " + job->path);
+	}
+
+	if (job->buffer)
+	    free (job->buffer);
+
+	delete job;
+    }
+}
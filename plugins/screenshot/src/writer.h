@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2005 Novell, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Novell, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Novell, Inc. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * NOVELL, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL NOVELL, INC. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Author: David Reveman <davidr@novell.com>
+ */
+
+#ifndef _SCREENSHOT_WRITER_H
+#define _SCREENSHOT_WRITER_H
+
+#include <pthread.h>
+
+#include <list>
+
+#include <core/core.h>
+
+/* Names and writes screenshot images on a thread of its own, one at a
+   time and in the order they were taken, and runs the launch
+   application for them on the main thread once they are written. */
+class ShotWriter {
+    public:
+	ShotWriter ();
+	~ShotWriter ();
+
+	/* Takes over buffer, width x height RGBA pixels with the bottom
+	   row first as glReadPixels returns them. */
+	void write (const CompString &dir,
+		    const CompString &app,
+		    unsigned char    *buffer,
+		    int              width,
+		    int              height);
+
+    private:
+	struct Job {
+	    CompString    dir;
+	    CompString    app;
+	    unsigned char *buffer;
+	    int           width;
+	    int           height;
+
+	    CompString    path;
+	    int           error;
+	    bool          status;
+	};
+
+	static void *threadFunc (void *closure);
+
+	bool start ();
+	void run (Job *job);
+	void handleDone ();
+
+	pthread_t       thread;
+	bool            running;
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+	bool            quit;
+
+	std::list<Job *> queue;
+	std::list<Job *> done;
+
+	/* wakes up the main thread when jobs are done */
+	int               wakeUp[2];
+	CompWatchFdHandle wakeUpHandle;
+};
+
+#endif
@@ -0,0 +1,372 @@
+/*
+ * Copyright © 2006 Novell, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Novell, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Novell, Inc. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * NOVELL, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL NOVELL, INC. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Author: David Reveman <davidr@novell.com>
+ */
+
+#include <string.h>
+#include <math.h>
+#include <signal.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "simulation.h"
+
+/* no point in more threads for a 256 row texture */
+#define MAX_WORKERS 3
+
+void
+waterStepRows (const float *cur,
+	       float       *next,
+	       int         width,
+	       int         y0,
+	       int         y1,
+	       float       dt,
+	       float       fade)
+{
+    int dWidth = width + 2;
+
+    for (int y = y0; y < y1; y++)
+    {
+	const float *c = cur + (y + 1) * dWidth;
+	const float *u = c - dWidth;
+	const float *d = c + dWidth;
+	float       *n = next + (y + 1) * dWidth;
+	int         j = 1;
+
+#ifdef __SSE2__
+	__m128 vDt   = _mm_set1_ps (dt);
+	__m128 vFade = _mm_set1_ps (fade);
+	__m128 vTwo  = _mm_set1_ps (2.0f);
+	__m128 vFour = _mm_set1_ps (4.0f);
+	__m128 vZero = _mm_setzero_ps ();
+	__m128 vOne  = _mm_set1_ps (1.0f);
+
+	for (; j + 4 <= width + 1; j += 4)
+	{
+	    __m128 vc = _mm_loadu_ps (c + j);
+	    __m128 accel, value;
+
+	    accel = _mm_add_ps (_mm_loadu_ps (u + j), _mm_loadu_ps (d + j));
+	    accel = _mm_add_ps (accel, _mm_loadu_ps (c + j - 1));
+	    accel = _mm_add_ps (accel, _mm_loadu_ps (c + j + 1));
+	    accel = _mm_mul_ps (vDt, _mm_sub_ps (accel,
+						 _mm_mul_ps (vFour, vc)));
+
+	    value = _mm_sub_ps (_mm_mul_ps (vTwo, vc), _mm_loadu_ps (n + j));
+	    value = _mm_mul_ps (_mm_add_ps (value, accel), vFade);
+	    value = _mm_max_ps (_mm_min_ps (value, vOne), vZero);
+
+	    _mm_storeu_ps (n + j, value);
+	}
+#endif
+
+	for (; j < width + 1; j++)
+	{
+	    float accel, value;
+
+	    accel = dt * (u[j] + d[j] + c[j - 1] + c[j + 1] - 4.0f * c[j]);
+	    value = (2.0f * c[j] - n[j] + accel) * fade;
+
+	    if (value < 0.0f)
+		value = 0.0f;
+	    else if (value > 1.0f)
+		value = 1.0f;
+
+	    n[j] = value;
+	}
+    }
+}
+
+bool
+waterBumpMapRows (const float   *cur,
+		  unsigned char *texture,
+		  int           width,
+		  int           y0,
+		  int           y1)
+{
+    int  dWidth = width + 2;
+    bool changed = false;
+
+    for (int y = y0; y < y1; y++)
+    {
+	/* texels line up with the height map including its left border,
+	   as they always have */
+	const float   *c = cur + (y + 1) * dWidth;
+	const float   *u = c - dWidth;
+	const float   *d = c + dWidth;
+	unsigned char *t = texture + y * width * 4;
+	int           j = 0;
+
+#ifdef __SSE2__
+	__m128  vBump  = _mm_set1_ps (1.5f);
+	__m128  vHalf  = _mm_set1_ps (0.5f);
+	__m128  vOne   = _mm_set1_ps (1.0f);
+	__m128  v255   = _mm_set1_ps (255.0f);
+	__m128i vDiff  = _mm_setzero_si128 ();
+
+	for (; j + 4 <= width; j += 4)
+	{
+	    __m128  v0, v1, inv;
+	    __m128i b0, b1, b2, b3, texel, old;
+
+	    v0 = _mm_mul_ps (_mm_sub_ps (_mm_loadu_ps (d + j),
+					 _mm_loadu_ps (u + j)), vBump);
+	    v1 = _mm_mul_ps (_mm_sub_ps (_mm_loadu_ps (c + j - 1),
+					 _mm_loadu_ps (c + j + 1)), vBump);
+
+	    inv = _mm_add_ps (_mm_add_ps (_mm_mul_ps (v0, v0),
+					  _mm_mul_ps (v1, v1)), vOne);
+	    inv = _mm_div_ps (vHalf, _mm_sqrt_ps (inv));
+
+	    v0 = _mm_add_ps (_mm_mul_ps (v0, inv), vHalf);
+	    v1 = _mm_add_ps (_mm_mul_ps (v1, inv), vHalf);
+
+	    b0 = _mm_cvttps_epi32 (_mm_mul_ps (_mm_add_ps (inv, vHalf), v255));
+	    b1 = _mm_cvttps_epi32 (_mm_mul_ps (v1, v255));
+	    b2 = _mm_cvttps_epi32 (_mm_mul_ps (v0, v255));
+	    b3 = _mm_cvttps_epi32 (_mm_mul_ps (_mm_loadu_ps (c + j), v255));
+
+	    texel = _mm_or_si128 (_mm_or_si128 (b0, _mm_slli_epi32 (b1, 8)),
+				  _mm_or_si128 (_mm_slli_epi32 (b2, 16),
+						_mm_slli_epi32 (b3, 24)));
+
+	    old   = _mm_loadu_si128 ((__m128i *) (t + j * 4));
+	    vDiff = _mm_or_si128 (vDiff, _mm_xor_si128 (old, texel));
+
+	    _mm_storeu_si128 ((__m128i *) (t + j * 4), texel);
+	}
+
+	if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (vDiff,
+					       _mm_setzero_si128 ())) != 0xffff)
+	    changed = true;
+#endif
+
+	for (; j < width; j++)
+	{
+	    unsigned char texel[4], *p = t + j * 4;
+	    float         v0, v1, inv;
+
+	    v0 = (d[j]     - u[j])     * 1.5f;
+	    v1 = (c[j - 1] - c[j + 1]) * 1.5f;
+
+	    /* 0.5 for scale */
+	    inv = 0.5f / sqrtf (v0 * v0 + v1 * v1 + 1.0f);
+
+	    /* add scale and bias to normal */
+	    v0 = v0 * inv + 0.5f;
+	    v1 = v1 * inv + 0.5f;
+
+	    /* store normal map in RGB components */
+	    texel[0] = (unsigned char) ((inv + 0.5f) * 255.0f);
+	    texel[1] = (unsigned char) (v1 * 255.0f);
+	    texel[2] = (unsigned char) (v0 * 255.0f);
+
+	    /* store height in A component */
+	    texel[3] = (unsigned char) (c[j] * 255.0f);
+
+	    if (memcmp (p, texel, 4))
+	    {
+		memcpy (p, texel, 4);
+		changed = true;
+	    }
+	}
+    }
+
+    return changed;
+}
+
+WaterWorkers::WaterWorkers () :
+    generation (0),
+    nextBand (0),
+    pending (0),
+    quit (false),
+    cur (NULL),
+    next (NULL),
+    texture (NULL),
+    width (0),
+    dt (0.0f),
+    fade (0.0f)
+{
+    long     nCpus = sysconf (_SC_NPROCESSORS_ONLN);
+    int      nThreads = nCpus > MAX_WORKERS ? MAX_WORKERS : nCpus - 1;
+    sigset_t all, old;
+
+    pthread_mutex_init (&mutex, NULL);
+    pthread_cond_init (&startCond, NULL);
+    pthread_cond_init (&doneCond, NULL);
+
+    /* signals are for the main thread only */
+    sigfillset (&all);
+    pthread_sigmask (SIG_BLOCK, &all, &old);
+
+    for (int i = 0; i < nThreads; i++)
+    {
+	pthread_t thread;
+
+	if (pthread_create (&thread, NULL, threadFunc, this))
+	    break;
+
+	threads.push_back (thread);
+    }
+
+    pthread_sigmask (SIG_SETMASK, &old, NULL);
+
+    bands.resize (threads.size () + 1);
+}
+
+WaterWorkers::~WaterWorkers ()
+{
+    pthread_mutex_lock (&mutex);
+    quit = true;
+    pthread_cond_broadcast (&startCond);
+    pthread_mutex_unlock (&mutex);
+
+    for (unsigned int i = 0; i < threads.size (); i++)
+	pthread_join (threads[i], NULL);
+
+    pthread_cond_destroy (&doneCond);
+    pthread_cond_destroy (&startCond);
+    pthread_mutex_destroy (&mutex);
+}
+
+void
+WaterWorkers::runBand (Band &band)
+{
+    waterStepRows (cur, next, width, band.y0, band.y1, dt, fade);
+
+    band.dirty0 = band.dirty1 = -1;
+
+    for (int y = band.y0; y < band.y1; y++)
+    {
+	if (waterBumpMapRows (cur, texture, width, y, y + 1))
+	{
+	    if (band.dirty0 < 0)
+		band.dirty0 = y;
+
+	    band.dirty1 = y;
+	}
+    }
+}
+
+void *
+WaterWorkers::threadFunc (void *closure)
+{
+    WaterWorkers *w = (WaterWorkers *) closure;
+    unsigned int seen = 0;
+
+    pthread_mutex_lock (&w->mutex);
+
+    for (;;)
+    {
+	while (!w->quit && w->generation == seen)
+	    pthread_cond_wait (&w->startCond, &w->mutex);
+
+	if (w->quit)
+	    break;
+
+	seen = w->generation;
+
+	while (w->nextBand < (int) w->bands.size ())
+	{
+	    Band &band = w->bands[w->nextBand++];
+
+	    pthread_mutex_unlock (&w->mutex);
+	    w->runBand (band);
+	    pthread_mutex_lock (&w->mutex);
+
+	    if (--w->pending == 0)
+		pthread_cond_signal (&w->doneCond);
+	}
+    }
+
+    pthread_mutex_unlock (&w->mutex);
+
+    return NULL;
+}
+
+void
+WaterWorkers::step (const float   *cur,
+		    float         *next,
+		    unsigned char *texture,
+		    int           width,
+		    int           height,
+		    float         dt,
+		    float         fade,
+		    int           *dirty0,
+		    int           *dirty1)
+{
+    int nBands = bands.size ();
+
+    pthread_mutex_lock (&mutex);
+
+    this->cur     = cur;
+    this->next    = next;
+    this->texture = texture;
+    this->width   = width;
+    this->dt      = dt;
+    this->fade    = fade;
+
+    for (int i = 0; i < nBands; i++)
+    {
+	bands[i].y0 = height * i / nBands;
+	bands[i].y1 = height * (i + 1) / nBands;
+    }
+
+    nextBand = 0;
+    pending  = nBands;
+    generation++;
+
+    pthread_cond_broadcast (&startCond);
+
+    while (nextBand < nBands)
+    {
+	Band &band = bands[nextBand++];
+
+	pthread_mutex_unlock (&mutex);
+	runBand (band);
+	pthread_mutex_lock (&mutex);
+
+	pending--;
+    }
+
+    while (pending)
+	pthread_cond_wait (&doneCond, &mutex);
+
+    pthread_mutex_unlock (&mutex);
+
+    *dirty0 = *dirty1 = -1;
+
+    for (int i = 0; i < nBands; i++)
+    {
+	if (bands[i].dirty0 < 0)
+	    continue;
+
+	if (*dirty0 < 0)
+	    *dirty0 = bands[i].dirty0;
+
+	*dirty1 = bands[i].dirty1;
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2006 Novell, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Novell, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Novell, Inc. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * NOVELL, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL NOVELL, INC. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Author: David Reveman <davidr@novell.com>
+ */
+
+#ifndef _WATER_SIMULATION_H
+#define _WATER_SIMULATION_H
+
+#include <pthread.h>
+
+#include <vector>
+
+/*
+ * Software version of the bump map program. Height maps are
+ * (width + 2) x (height + 2) floats with a one texel border, the
+ * texture is width x height BGRA texels. Rows are numbered without the
+ * border and both functions only touch the rows they are given, so
+ * that bands of rows can be processed in parallel. SSE2 is used when
+ * available.
+ */
+
+/* Computes rows [y0, y1) of the next height map from the current one
+   (cur) and the previous one (next), which is overwritten. The border
+   of next is not updated. */
+void
+waterStepRows (const float *cur,
+	       float       *next,
+	       int         width,
+	       int         y0,
+	       int         y1,
+	       float       dt,
+	       float       fade);
+
+/* Stores normals and heights of rows [y0, y1) of the height map in the
+   texture. Returns true if any texel differs from what the texture
+   held before. */
+bool
+waterBumpMapRows (const float   *cur,
+		  unsigned char *texture,
+		  int           width,
+		  int           y0,
+		  int           y1);
+
+/* A few threads that run one step for bands of rows together with the
+   calling thread. */
+class WaterWorkers {
+    public:
+	WaterWorkers ();
+	~WaterWorkers ();
+
+	/* Runs waterStepRows and waterBumpMapRows for all rows and returns
+	   the first and last row whose texels changed in *dirty0 and
+	   *dirty1, or -1 in *dirty0 if none did. */
+	void step (const float   *cur,
+		   float         *next,
+		   unsigned char *texture,
+		   int           width,
+		   int           height,
+		   float         dt,
+		   float         fade,
+		   int           *dirty0,
+		   int           *dirty1);
+
+    private:
+	struct Band {
+	    int y0, y1;
+	    int dirty0, dirty1;
+	};
+
+	static void *threadFunc (void *closure);
+
+	void runBand (Band &band);
+
+	std::vector<pthread_t> threads;
+	std::vector<Band>      bands;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t  startCond;
+	pthread_cond_t  doneCond;
+
+	unsigned int generation;
+	int          nextBand;
+	int          pending;
+	bool         quit;
+
+	const float   *cur;
+	float         *next;
+	unsigned char *texture;
+	int           width;
+	float         dt;
+	float         fade;
+};
+
+#endif
@@ -425,51 +425,25 @@ WaterScreen::fboVertices (GLenum type,
 void
 WaterScreen::softwareUpdate (float dt, float fade)
 {
-    float         *dTmp;
-    int           i, j;
-    float         v0, v1, inv;
-    float         accel, value;
-    unsigned char *t0, *t;
-    int           dWidth, dHeight;
-    float         *d01, *d10, *d11, *d12;
+    float *dTmp;
+    int   i, dWidth, dHeight;
+    int   dirty0, dirty1;
 
     if (!texture[TINDEX (this, 0)])
 	allocTexture (TINDEX (this, 0));
 
+    if (!workers)
+	workers = new WaterWorkers ();
+
     dt *= K * 2.0f;
     fade *= 0.99f;
 
     dWidth  = width  + 2;
     dHeight = height + 2;
 
-#define D(d, j) (*((d) + (j)))
-
-    d01 = d0 + dWidth;
-    d10 = d1;
-    d11 = d10 + dWidth;
-    d12 = d11 + dWidth;
-
-    for (i = 1; i < dHeight - 1; i++)
-    {
-	for (j = 1; j < dWidth - 1; j++)
-	{
-	    accel = dt * (D (d10, j)     +
-			  D (d12, j)     +
-			  D (d11, j - 1) +
-			  D (d11, j + 1) - 4.0f * D (d11, j));
-
-	    value = (2.0f * D (d11, j) - D (d01, j) + accel) * fade;
-
-	    value = CLAMP (value, 0.0f, 1.0f);
-
-	    D (d01, j) = value;
-	}
-
-	d01 += dWidth;
-	d10 += dWidth;
-	d11 += dWidth;
-	d12 += dWidth;
-    }
+    /* step the height map into d0 and turn the current one into the
+       texture, in bands of rows on all workers */
+    workers->step (d1, d0, t0, width, height, dt, fade, &dirty0, &dirty1);
 
     /* update border */
     memcpy (d0, d0 + dWidth, dWidth * sizeof (GLfloat));
@@ -477,71 +451,32 @@ WaterScreen::softwareUpdate (float dt, float fade)
 	    d0 + dWidth * (dHeight - 2),
 	    dWidth * sizeof (GLfloat));
 
-    d01 = d0 + dWidth;
-
     for (i = 1; i < dHeight - 1; i++)
     {
-	D (d01, 0)	    = D (d01, 1);
-	D (d01, dWidth - 1) = D (d01, dWidth - 2);
+	float *d = d0 + i * dWidth;
 
-	d01 += dWidth;
+	d[0]	      = d[1];
+	d[dWidth - 1] = d[dWidth - 2];
     }
 
-    d10 = d1;
-    d11 = d10 + dWidth;
-    d12 = d11 + dWidth;
-
-    t0 = this->t0;
-
-    /* update texture */
-    for (i = 0; i < height; i++)
-    {
-	for (j = 0; j < width; j++)
-	{
-	    v0 = (D (d12, j)     - D (d10, j))     * 1.5f;
-	    v1 = (D (d11, j - 1) - D (d11, j + 1)) * 1.5f;
-
-	    /* 0.5 for scale */
-	    inv = 0.5f / sqrtf (v0 * v0 + v1 * v1 + 1.0f);
-
-	    /* add scale and bias to normal */
-	    v0 = v0 * inv + 0.5f;
-	    v1 = v1 * inv + 0.5f;
-
-	    /* store normal map in RGB components */
-	    t = t0 + (j * 4);
-	    t[0] = (unsigned char) ((inv + 0.5f) * 255.0f);
-	    t[1] = (unsigned char) (v1 * 255.0f);
-	    t[2] = (unsigned char) (v0 * 255.0f);
-
-	    /* store height in A component */
-	    t[3] = (unsigned char) (D (d11, j) * 255.0f);
-	}
-
-	d10 += dWidth;
-	d11 += dWidth;
-	d12 += dWidth;
-
-	t0 += width * 4;
-    }
-
-#undef D
-
     /* swap height maps */
     dTmp   = d0;
     d0 = d1;
     d1 = dTmp;
 
-    if (texture[TINDEX (this, 0)])
+    /* only the rows that changed since the last upload */
+    if (texture[TINDEX (this, 0)] && dirty0 >= 0)
     {
 	glBindTexture (target, texture[TINDEX (this, 0)]);
-	glTexImage2D (target, 0, GL_RGBA, width, height, 0, GL_BGRA,
+	glTexSubImage2D (target, 0, 0, dirty0, width, dirty1 - dirty0 + 1,
+			 GL_BGRA,
 #if IMAGE_BYTE_ORDER == MSBFirst
-		      GL_UNSIGNED_INT_8_8_8_8_REV,
+			 GL_UNSIGNED_INT_8_8_8_8_REV,
 #else
-		      GL_UNSIGNED_BYTE,
+			 GL_UNSIGNED_BYTE,
 #endif
-		      this->t0);
+			 t0 + dirty0 * width * 4);
+	glBindTexture (target, 0);
     }
 }
 
@@ -1291,6 +1226,8 @@ WaterScreen::WaterScreen (CompScreen *screen) :
     d1 (NULL),
     t0 (NULL),
 
+    workers (NULL),
+
     wiperAngle (0),
     wiperSpeed (0),
 
@@ -1337,6 +1274,9 @@ WaterScreen::~WaterScreen ()
     if (data)
 	free (data);
 
+    if (workers)
+	delete workers;
+
     foreach (WaterFunction &f, bumpMapFunctions)
     {
 	GLFragment::destroyFragmentFunction (f.id);
@@ -38,6 +38,7 @@
 #include <opengl/opengl.h>
 
 #include "water_options.h"
+#include "simulation.h"
 
 #define WATER_SCREEN(s) \
     WaterScreen *ws = WaterScreen::get (s)
@@ -131,6 +132,9 @@ class WaterScreen :
 	float         *d1;
 	unsigned char *t0;
 
+	/* threads for the software path, created on first use */
+	WaterWorkers *workers;
+
 	CompTimer rainTimer;
 	CompTimer wiperTimer;
 
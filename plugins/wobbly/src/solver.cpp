@@ -0,0 +1,203 @@
+/*
+ * Copyright © 2005 Novell, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Novell, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Novell, Inc. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * NOVELL, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL NOVELL, INC. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Author: David Reveman <davidr@novell.com>
+ */
+
+/*
+ * Spring model implemented by Kristian Hogsberg.
+ */
+
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "solver.h"
+
+/* The arrays are handled as interleaved x and y floats, four floats
+   or two objects at a time. */
+
+/* d = k * 0.5 * (b - a - offset) for n floats */
+static void
+springDelta (const float *a,
+	     const float *b,
+	     float       *d,
+	     int         n,
+	     float       offsetX,
+	     float       offsetY,
+	     float       k)
+{
+    int i = 0;
+
+#ifdef __SSE2__
+    __m128 vOffset = _mm_setr_ps (offsetX, offsetY, offsetX, offsetY);
+    __m128 vHalf   = _mm_set1_ps (0.5f);
+    __m128 vK      = _mm_set1_ps (k);
+
+    for (; i + 4 <= n; i += 4)
+    {
+	__m128 v = _mm_sub_ps (_mm_loadu_ps (b + i), _mm_loadu_ps (a + i));
+
+	v = _mm_mul_ps (vHalf, _mm_sub_ps (v, vOffset));
+	_mm_storeu_ps (d + i, _mm_mul_ps (vK, v));
+    }
+#endif
+
+    for (; i < n; i += 2)
+    {
+	d[i]     = k * (0.5f * (b[i] - a[i] - offsetX));
+	d[i + 1] = k * (0.5f * (b[i + 1] - a[i + 1] - offsetY));
+    }
+}
+
+/* f += sign * d for n floats */
+static void
+applyDelta (float       *f,
+	    const float *d,
+	    int         n,
+	    bool        subtract)
+{
+    int i = 0;
+
+#ifdef __SSE2__
+    if (subtract)
+	for (; i + 4 <= n; i += 4)
+	    _mm_storeu_ps (f + i, _mm_sub_ps (_mm_loadu_ps (f + i),
+					      _mm_loadu_ps (d + i)));
+    else
+	for (; i + 4 <= n; i += 4)
+	    _mm_storeu_ps (f + i, _mm_add_ps (_mm_loadu_ps (f + i),
+					      _mm_loadu_ps (d + i)));
+#endif
+
+    if (subtract)
+	for (; i < n; i++)
+	    f[i] -= d[i];
+    else
+	for (; i < n; i++)
+	    f[i] += d[i];
+}
+
+void
+modelSpringForces (const Point *position,
+		   Vector      *force,
+		   Vector      *scratch,
+		   int         width,
+		   int         height,
+		   float       hpad,
+		   float       vpad,
+		   float       k)
+{
+    float *d = (float *) scratch;
+    int   n;
+
+    /* springs between an object and its right neighbour, the forces
+       on both ends are applied in separate passes as the ranges
+       overlap */
+    n = 2 * (width - 1);
+    for (int y = 0; y < height; y++)
+    {
+	const float *p = (const float *) (position + y * width);
+	float       *f = (float *) (force + y * width);
+
+	springDelta (p, p + 2, d, n, hpad, 0.0f, k);
+	applyDelta (f, d, n, false);
+	applyDelta (f + 2, d, n, true);
+    }
+
+    /* springs between an object and the one below it */
+    n = 2 * width;
+    for (int y = 0; y < height - 1; y++)
+    {
+	const float *p = (const float *) (position + y * width);
+	float       *f = (float *) (force + y * width);
+
+	springDelta (p, p + n, d, n, 0.0f, vpad, k);
+	applyDelta (f, d, n, false);
+	applyDelta (f + n, d, n, true);
+    }
+}
+
+float
+modelIntegrate (Point  *position,
+		Vector *velocity,
+		Vector *force,
+		int    n,
+		float  friction,
+		float  *forceSum)
+{
+    float *p = (float *) position;
+    float *v = (float *) velocity;
+    float *f = (float *) force;
+    float velocitySum = 0.0f;
+    int   i = 0;
+
+    n *= 2;
+
+#ifdef __SSE2__
+    __m128 vFriction = _mm_set1_ps (friction);
+    __m128 vMass     = _mm_set1_ps (MASS);
+    __m128 vAbs      = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+    __m128 vZero     = _mm_setzero_ps ();
+    __m128 vForceSum = _mm_setzero_ps ();
+    __m128 vVelSum   = _mm_setzero_ps ();
+    float  sums[4];
+
+    for (; i + 4 <= n; i += 4)
+    {
+	__m128 vf = _mm_loadu_ps (f + i);
+	__m128 vv = _mm_loadu_ps (v + i);
+
+	vf = _mm_sub_ps (vf, _mm_mul_ps (vFriction, vv));
+	vv = _mm_add_ps (vv, _mm_div_ps (vf, vMass));
+
+	_mm_storeu_ps (p + i, _mm_add_ps (_mm_loadu_ps (p + i), vv));
+	_mm_storeu_ps (v + i, vv);
+	_mm_storeu_ps (f + i, vZero);
+
+	vForceSum = _mm_add_ps (vForceSum, _mm_and_ps (vf, vAbs));
+	vVelSum   = _mm_add_ps (vVelSum, _mm_and_ps (vv, vAbs));
+    }
+
+    _mm_storeu_ps (sums, vForceSum);
+    *forceSum += sums[0] + sums[1] + sums[2] + sums[3];
+
+    _mm_storeu_ps (sums, vVelSum);
+    velocitySum += sums[0] + sums[1] + sums[2] + sums[3];
+#endif
+
+    for (; i < n; i++)
+    {
+	f[i] -= friction * v[i];
+	v[i] += f[i] / MASS;
+	p[i] += v[i];
+
+	*forceSum   += fabs (f[i]);
+	velocitySum += fabs (v[i]);
+
+	f[i] = 0.0f;
+    }
+
+    return velocitySum;
+}
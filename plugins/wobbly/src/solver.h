@@ -0,0 +1,72 @@
+/*
+ * Copyright © 2005 Novell, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Novell, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Novell, Inc. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * NOVELL, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL NOVELL, INC. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Author: David Reveman <davidr@novell.com>
+ */
+
+/*
+ * Spring model implemented by Kristian Hogsberg.
+ */
+
+#ifndef _WOBBLY_SOLVER_H
+#define _WOBBLY_SOLVER_H
+
+#define MASS 15.0f
+
+typedef struct _xy_pair {
+    float x, y;
+} Point, Vector;
+
+/*
+ * The parts of the spring model that run for every object on every
+ * step. They work on plain arrays of positions, velocities and forces,
+ * one per grid object in row major order, and use SSE2 when available.
+ * Nothing here depends on compiz so that the solver can be built and
+ * measured on its own.
+ */
+
+/* Accumulates the forces of the springs between horizontally and
+   vertically adjacent objects of a width x height grid. hpad and vpad
+   are the rest lengths of the springs, scratch needs room for width
+   vectors. */
+void
+modelSpringForces (const Point *position,
+		   Vector      *force,
+		   Vector      *scratch,
+		   int         width,
+		   int         height,
+		   float       hpad,
+		   float       vpad,
+		   float       k);
+
+/* Moves n objects that are neither immobile nor snapped to an edge by
+   one step, clearing their forces. Returns the sum of the velocities
+   and adds the sum of the forces to *forceSum. */
+float
+modelIntegrate (Point  *position,
+		Vector *velocity,
+		Vector *force,
+		int    n,
+		float  friction,
+		float  *forceSum);
+
+#endif
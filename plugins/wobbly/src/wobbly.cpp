@@ -460,6 +460,15 @@ WobblyWindow::findNextSouthEdge (Object *object)
     object->horzEdge.velocity = EDGE_VELOCITY;
 }
 
+Object::Object (Point  &position,
+		Vector &velocity,
+		Vector &force) :
+    force (force),
+    position (position),
+    velocity (velocity)
+{
+}
+
 void
 Object::init (float  positionX,
 	      float  positionY,
@@ -544,14 +553,14 @@ Model::setMiddleAnchor (int   x,
 {
     float gx, gy;
 
-    gx = ((GRID_WIDTH  - 1) / 2 * width)  / (float) (GRID_WIDTH  - 1);
-    gy = ((GRID_HEIGHT - 1) / 2 * height) / (float) (GRID_HEIGHT - 1);
+    gx = ((gridWidth  - 1) / 2 * width)  / (float) (gridWidth  - 1);
+    gy = ((gridHeight - 1) / 2 * height) / (float) (gridHeight - 1);
 
     if (anchorObject)
 	anchorObject->immobile = false;
 
-    anchorObject = &objects[GRID_WIDTH * ((GRID_HEIGHT - 1) / 2) +
-			    (GRID_WIDTH - 1) / 2];
+    anchorObject = &objects[gridWidth * ((gridHeight - 1) / 2) +
+			    (gridWidth - 1) / 2];
     anchorObject->position.x = x + gx;
     anchorObject->position.y = y + gy;
 
@@ -565,12 +574,12 @@ Model::setTopAnchor (int x,
 {
     float gx;
 
-    gx = ((GRID_WIDTH - 1) / 2 * width)  / (float) (GRID_WIDTH - 1);
+    gx = ((gridWidth - 1) / 2 * width)  / (float) (gridWidth - 1);
 
     if (anchorObject)
 	anchorObject->immobile = false;
 
-    anchorObject = &objects[(GRID_WIDTH - 1) / 2];
+    anchorObject = &objects[(gridWidth - 1) / 2];
     anchorObject->position.x = x + gx;
     anchorObject->position.y = y;
 
@@ -590,12 +599,12 @@ Model::addEdgeAnchors (int x,
     o->position.y = y;
     o->immobile = true;
 
-    o = &objects[GRID_WIDTH - 1];
+    o = &objects[gridWidth - 1];
     o->position.x = x + width;
     o->position.y = y;
     o->immobile = true;
 
-    o = &objects[GRID_WIDTH * (GRID_HEIGHT - 1)];
+    o = &objects[gridWidth * (gridHeight - 1)];
     o->position.x = x;
     o->position.y = y + height;
     o->immobile = true;
@@ -623,13 +632,13 @@ Model::removeEdgeAnchors (int x,
     if (o != anchorObject)
 	o->immobile = false;
 
-    o = &objects[GRID_WIDTH - 1];
+    o = &objects[gridWidth - 1];
     o->position.x = x + width;
     o->position.y = y;
     if (o != anchorObject)
 	o->immobile = false;
 
-    o = &objects[GRID_WIDTH * (GRID_HEIGHT - 1)];
+    o = &objects[gridWidth * (gridHeight - 1)];
     o->position.x = x;
     o->position.y = y + height;
     if (o != anchorObject)
@@ -652,15 +661,15 @@ Model::adjustObjectPosition (Object *object,
     Object *o;
     int	   gridX, gridY, i = 0;
 
-    for (gridY = 0; gridY < GRID_HEIGHT; gridY++)
+    for (gridY = 0; gridY < gridHeight; gridY++)
     {
-	for (gridX = 0; gridX < GRID_WIDTH; gridX++, i++)
+	for (gridX = 0; gridX < gridWidth; gridX++, i++)
 	{
 	    o = &objects[i];
 	    if (o == object)
 	    {
-		o->position.x = x + (gridX * width) / (GRID_WIDTH - 1);
-		o->position.y = y + (gridY * height) / (GRID_HEIGHT - 1);
+		o->position.x = x + (gridX * width) / (gridWidth - 1);
+		o->position.y = y + (gridY * height) / (gridHeight - 1);
 
 		return;
 	    }
@@ -676,13 +685,13 @@ Model::initObjects (int	x,
 {
     float gw, gh;
 
-    gw = GRID_WIDTH  - 1;
-    gh = GRID_HEIGHT - 1;
+    gw = gridWidth  - 1;
+    gh = gridHeight - 1;
 
     Object *object = objects;
-    for (int gridY = 0; gridY < GRID_HEIGHT; gridY++)
+    for (int gridY = 0; gridY < gridHeight; gridY++)
     {
-	for (int gridX = 0; gridX < GRID_WIDTH; gridX++, object++)
+	for (int gridX = 0; gridX < gridWidth; gridX++, object++)
 	{
 	    object->init (x + (gridX * width) / gw,
 			  y + (gridY * height) / gh,
@@ -711,22 +720,22 @@ WobblyWindow::updateModelSnapping ()
 	edgeMask &= ~WestEdgeMask;
 
     Object *object = model->objects;
-    for (int gridY = 0; gridY < GRID_HEIGHT; gridY++)
+    for (int gridY = 0; gridY < model->gridHeight; gridY++)
     {
 	if (gridY == 0)
 	    gridMask = edgeMask & NorthEdgeMask;
-	else if (gridY == GRID_HEIGHT - 1)
+	else if (gridY == model->gridHeight - 1)
 	    gridMask = edgeMask & SouthEdgeMask;
 	else
 	    gridMask = 0;
 
-	for (int gridX = 0; gridX < GRID_WIDTH; gridX++, object++)
+	for (int gridX = 0; gridX < model->gridWidth; gridX++, object++)
 	{
 	    mask = gridMask;
 
 	    if (gridX == 0)
 		mask |= edgeMask & WestEdgeMask;
-	    else if (gridX == GRID_WIDTH - 1)
+	    else if (gridX == model->gridWidth - 1)
 		mask |= edgeMask & EastEdgeMask;
 
 	    if (mask != object->edgeMask)
@@ -767,9 +776,9 @@ void
 Model::reduceEdgeEscapeVelocity ()
 {
     Object *object = objects;
-    for (int gridY = 0; gridY < GRID_HEIGHT; gridY++)
+    for (int gridY = 0; gridY < gridHeight; gridY++)
     {
-	for (int gridX = 0; gridX < GRID_WIDTH; gridX++, object++)
+	for (int gridX = 0; gridX < gridWidth; gridX++, object++)
 	{
 	    if (object->vertEdge.snapped)
 		object->vertEdge.velocity *= drand48 () * 0.25f;
@@ -786,9 +795,9 @@ Model::disableSnapping ()
     bool snapped = false;
 
     Object *object = objects;
-    for (int gridY = 0; gridY < GRID_HEIGHT; gridY++)
+    for (int gridY = 0; gridY < gridHeight; gridY++)
     {
-	for (int gridX = 0; gridX < GRID_WIDTH; gridX++, object++)
+	for (int gridX = 0; gridX < gridWidth; gridX++, object++)
 	{
 	    if (object->vertEdge.snapped ||
 		object->horzEdge.snapped)
@@ -820,9 +829,9 @@ Model::adjustObjectsForShiver (int   x,
     h = height;
 
     Object *object = objects;
-    for (int gridY = 0; gridY < GRID_HEIGHT; gridY++)
+    for (int gridY = 0; gridY < gridHeight; gridY++)
     {
-	for (int gridX = 0; gridX < GRID_WIDTH; gridX++, object++)
+	for (int gridX = 0; gridX < gridWidth; gridX++, object++)
 	{
 	    if (!object->immobile)
 	    {
@@ -848,16 +857,15 @@ Model::initSprings (int   x,
 		    int   height)
 {
     int   i = 0;
-    float hpad, vpad;
 
     numSprings = 0;
 
-    hpad = ((float) width) / (GRID_WIDTH  - 1);
-    vpad = ((float) height) / (GRID_HEIGHT - 1);
+    hpad = ((float) width) / (gridWidth  - 1);
+    vpad = ((float) height) / (gridHeight - 1);
 
-    for (int gridY = 0; gridY < GRID_HEIGHT; gridY++)
+    for (int gridY = 0; gridY < gridHeight; gridY++)
     {
-	for (int gridX = 0; gridX < GRID_WIDTH; gridX++, i++)
+	for (int gridX = 0; gridX < gridWidth; gridX++, i++)
 	{
 	    if (gridX > 0)
 		addSpring (&objects[i - 1],
@@ -865,7 +873,7 @@ Model::initSprings (int   x,
 			   hpad, 0);
 
 	    if (gridY > 0)
-		addSpring (&objects[i - GRID_WIDTH],
+		addSpring (&objects[i - gridWidth],
 			   &objects[i],
 			   0, vpad);
 	}
@@ -888,14 +896,30 @@ Model::Model (int	   x,
 	      int	   y,
 	      int	   width,
 	      int	   height,
+	      int	   gridSize,
 	      unsigned int edgeMask) :
-    numObjects (GRID_WIDTH * GRID_HEIGHT),
+    gridWidth (gridSize),
+    gridHeight (gridSize),
+    numObjects (gridWidth * gridHeight),
     numSprings (0),
     anchorObject (0),
     steps (0),
-    edgeMask (edgeMask)
+    edgeMask (edgeMask),
+    basisWidth (-1),
+    basisHeight (-1)
 {
-    objects = new Object [numObjects];
+    positions  = new Point [numObjects];
+    velocities = new Vector [numObjects];
+    forces     = new Vector [numObjects];
+    scratch    = new Vector [gridWidth];
+    rowPoints  = new Point [gridWidth];
+    springs    = new Spring [numObjects * 2];
+
+    /* objects refer to their entries in the arrays above */
+    objects = static_cast<Object *> (operator new[] (numObjects *
+						     sizeof (Object)));
+    for (int i = 0; i < numObjects; i++)
+	new (&objects[i]) Object (positions[i], velocities[i], forces[i]);
 
     memset (snapCnt, 0, sizeof (snapCnt));
 
@@ -913,23 +937,6 @@ Object::applyForce (float  fx,
     force.y += fy;
 }
 
-void
-Spring::exertForces (float k)
-{
-    Vector da, db;
-    Vector &aPos = a->position;
-    Vector &bPos = b->position;
-
-    da.x = 0.5f * (bPos.x - aPos.x - offset.x);
-    da.y = 0.5f * (bPos.y - aPos.y - offset.y);
-
-    db.x = 0.5f * (aPos.x - bPos.x + offset.x);
-    db.y = 0.5f * (aPos.y - bPos.y + offset.y);
-
-    a->applyForce (k * da.x, k * da.y);
-    b->applyForce (k * db.x, k * db.y);
-}
-
 bool
 WobblyWindow::objectReleaseWestEastEdge (Object	*object,
 					 Direction dir)
@@ -1185,15 +1192,40 @@ WobblyWindow::modelStep (float friction,
 
     for (int j = 0; j < steps; j++)
     {
-	for (int i = 0; i < model->numSprings; i++)
-	    model->springs[i].exertForces (k);
+	modelSpringForces (model->positions, model->forces, model->scratch,
+			   model->gridWidth, model->gridHeight,
+			   model->hpad, model->vpad, k);
 
-	for (int i = 0; i < model->numObjects; i++)
+	for (int i = 0; i < model->numObjects;)
 	{
-	    velocitySum += modelStepObject (&model->objects[i],
-					    friction,
-					    &force);
-	    forceSum += force;
+	    Object *object = &model->objects[i];
+	    int    n = 0;
+
+	    /* runs of objects that are free to move are integrated in
+	       one go, others need the snapping logic. The run is found
+	       at each object as snapping can change the edge masks of
+	       the objects that follow. */
+	    while (i + n < model->numObjects &&
+		   !object[n].immobile && !object[n].edgeMask)
+	    {
+		object[n].theta += 0.05f;
+		n++;
+	    }
+
+	    if (n)
+	    {
+		velocitySum += modelIntegrate (&model->positions[i],
+					       &model->velocities[i],
+					       &model->forces[i],
+					       n, friction, &forceSum);
+		i += n;
+	    }
+	    else
+	    {
+		velocitySum += modelStepObject (object, friction, &force);
+		forceSum += force;
+		i++;
+	    }
 	}
     }
 
@@ -1208,46 +1240,109 @@ WobblyWindow::modelStep (float friction,
     return wobbly;
 }
 
+/* Coefficients of the Bernstein polynomials of degree n - 1 at t */
+static void
+bernsteinCoefficients (float t,
+		       int   n,
+		       float *coeffs)
+{
+    float binomial = 1.0f;
+
+    for (int i = 0; i < n; i++)
+    {
+	coeffs[i] = binomial * powf (t, i) * powf (1 - t, n - 1 - i);
+	binomial  = binomial * (n - 1 - i) / (i + 1);
+    }
+}
+
+/* The coefficients only depend on the offset of a vertex into the
+   window and the model resolution, so they are kept in tables until
+   the window size changes. */
 void
-Model::bezierPatchEvaluate (float u,
-			    float v,
-			    float *patchX,
-			    float *patchY)
+Model::updateBasis (int width,
+		    int height)
 {
-    float coeffsU[4], coeffsV[4];
-    float x, y;
-    int   i, j;
+    if (width == basisWidth && height == basisHeight)
+	return;
+
+    basisWidth  = width;
+    basisHeight = height;
 
-    coeffsU[0] = (1 - u) * (1 - u) * (1 - u);
-    coeffsU[1] = 3 * u * (1 - u) * (1 - u);
-    coeffsU[2] = 3 * u * u * (1 - u);
-    coeffsU[3] = u * u * u;
+    basisU.resize ((width + 1) * gridWidth);
+    basisV.resize ((height + 1) * gridHeight);
 
-    coeffsV[0] = (1 - v) * (1 - v) * (1 - v);
-    coeffsV[1] = 3 * v * (1 - v) * (1 - v);
-    coeffsV[2] = 3 * v * v * (1 - v);
-    coeffsV[3] = v * v * v;
+    for (int x = 0; x <= width; x++)
+	bernsteinCoefficients (width ? (float) x / width : 0.0f, gridWidth,
+			       &basisU[x * gridWidth]);
 
-    x = y = 0.0f;
+    for (int y = 0; y <= height; y++)
+	bernsteinCoefficients (height ? (float) y / height : 0.0f, gridHeight,
+			       &basisV[y * gridHeight]);
+}
 
-    for (i = 0; i < 4; i++)
+void
+Model::releaseBasis ()
+{
+    std::vector<float> ().swap (basisU);
+    std::vector<float> ().swap (basisV);
+
+    basisWidth  = -1;
+    basisHeight = -1;
+}
+
+/* Collapses the patch to the curve of the vertex row at offset y, all
+   vertices of a row are then evaluated against gridWidth points. */
+void
+Model::bezierPatchRow (int y)
+{
+    int         row = MAX (0, MIN (y, basisHeight));
+    const float *coeffsV = &basisV[row * gridHeight];
+
+    for (int i = 0; i < gridWidth; i++)
     {
-	for (j = 0; j < 4; j++)
+	Object *object = &objects[i];
+
+	rowPoints[i].x = rowPoints[i].y = 0.0f;
+
+	for (int j = 0; j < gridHeight; j++, object += gridWidth)
 	{
-	    x += coeffsU[i] * coeffsV[j] *
-		objects[j * GRID_WIDTH + i].position.x;
-	    y += coeffsU[i] * coeffsV[j] *
-		objects[j * GRID_WIDTH + i].position.y;
+	    rowPoints[i].x += coeffsV[j] * object->position.x;
+	    rowPoints[i].y += coeffsV[j] * object->position.y;
 	}
     }
+}
 
-    *patchX = x;
-    *patchY = y;
+void
+Model::bezierPatchEvaluate (int   x,
+			    float *patchX,
+			    float *patchY)
+{
+    int         column = MAX (0, MIN (x, basisWidth));
+    const float *coeffsU = &basisU[column * gridWidth];
+    float       px = 0.0f, py = 0.0f;
+
+    for (int i = 0; i < gridWidth; i++)
+    {
+	px += coeffsU[i] * rowPoints[i].x;
+	py += coeffsU[i] * rowPoints[i].y;
+    }
+
+    *patchX = px;
+    *patchY = py;
 }
 
 bool
 WobblyWindow::ensureModel ()
 {
+    int gridSize = wScreen->optionGetModelResolution ();
+
+    /* a new resolution is picked up once the window is at rest */
+    if (model && model->gridWidth != gridSize && !wobblingMask && !grabbed)
+    {
+	delete model;
+	model = NULL;
+    }
+
     if (!model)
     {
 	unsigned int edgeMask = 0;
@@ -1260,7 +1355,7 @@ WobblyWindow::ensureModel ()
 	{
 	    model = new Model (outRect.x (), outRect.y (),
 			       outRect.width (), outRect.height (),
-			       edgeMask);
+			       gridSize, edgeMask);
 	}
 	catch (std::bad_alloc &)
 	{
@@ -1336,7 +1431,7 @@ WobblyScreen::preparePaint (int msSinceLastPaint)
 	springK  = optionGetSpringK ();
 
 	wobblingWindowsMask = false;
-	foreach (CompWindow *w, ::screen->windows ())
+	foreach (CompWindow *w, animatingWindows.windows ())
 	{
 	    WobblyWindow *ww = WobblyWindow::get (w);
 
@@ -1376,7 +1471,7 @@ WobblyScreen::preparePaint (int msSinceLastPaint)
 			    int   decorTop;
 			    int   decorTitleBottom;
 
-			    for (int i = 0; i < GRID_WIDTH; i++)
+			    for (int i = 0; i < model->gridWidth; i++)
 			    {
 				int modelY = model->objects[i].position.y;
 
@@ -1474,6 +1569,7 @@ WobblyScreen::preparePaint (int msSinceLastPaint)
 		{
 		    // Wobbling just finished for this window
 		    ww->enableWobbling (false);
+		    animatingWindows.remove (w);
 		}
 
 		wobblingWindowsMask |= ww->wobblingMask;
@@ -1602,6 +1698,8 @@ WobblyWindow::glAddGeometry (const GLTexture::MatrixList &matrix,
 
     vSize = 3 + (int) nMatrix * 2;
 
+    model->updateBasis (width, height);
+
     nVertices = geom.vCount;
     nIndices  = geom.indexCount;
 
@@ -1659,15 +1757,14 @@ WobblyWindow::glAddGeometry (const GLTexture::MatrixList &matrix,
 	    if (y > y2)
 		y = y2;
 
+	    model->bezierPatchRow (y - wy);
+
 	    for (x = x1;; x += gridW)
 	    {
 		if (x > x2)
 		    x = x2;
 
-		model->bezierPatchEvaluate ((x - wx) / width,
-						(y - wy) / height,
-						&deformedX,
-						&deformedY);
+		model->bezierPatchEvaluate (x - wx, &deformedX, &deformedY);
 
 		if (rect)
 		{
@@ -1921,6 +2018,9 @@ WobblyScreen::handleEvent (XEvent *event)
 void
 WobblyWindow::enableWobbling (bool enabling)
 {
+    if (!enabling && model)
+	model->releaseBasis ();
+
     gWindow->glPaintSetEnabled (this, enabling);
     gWindow->glAddGeometrySetEnabled (this, enabling);
     gWindow->glDrawGeometrySetEnabled (this, enabling);
@@ -1941,6 +2041,7 @@ WobblyScreen::startWobbling (WobblyWindow *ww)
     }
     ww->wobblingMask |= WobblyInitialMask;
     wobblingWindowsMask |= ww->wobblingMask;
+    animatingWindows.add (ww->window);
 
     cScreen->damagePending ();
 }
@@ -2364,7 +2465,16 @@ WobblyWindow::~WobblyWindow ()
 
 Model::~Model ()
 {
-    delete[] objects;
+    for (int i = 0; i < numObjects; i++)
+	objects[i].~Object ();
+    operator delete[] (objects);
+
+    delete[] positions;
+    delete[] velocities;
+    delete[] forces;
+    delete[] scratch;
+    delete[] rowPoints;
+    delete[] springs;
 }
 
 bool
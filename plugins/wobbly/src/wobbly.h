@@ -31,23 +31,20 @@
 #include <string.h>
 #include <math.h>
 
+#include <new>
+#include <vector>
+
 #include <composite/composite.h>
 #include <opengl/opengl.h>
 
 #include "wobbly_options.h"
+#include "solver.h"
 
 #define SNAP_WINDOW_TYPE (CompWindowTypeNormalMask  | \
 			  CompWindowTypeToolbarMask | \
 			  CompWindowTypeMenuMask    | \
 			  CompWindowTypeUtilMask)
 
-#define GRID_WIDTH  4
-#define GRID_HEIGHT 4
-
-#define MODEL_MAX_SPRINGS (GRID_WIDTH * GRID_HEIGHT * 2)
-
-#define MASS 15.0f
-
 #define NorthEdgeMask (1L << 0)
 #define SouthEdgeMask (1L << 1)
 #define WestEdgeMask  (1L << 2)
@@ -70,10 +67,6 @@ typedef enum
 
 class WobblyWindow;
 
-typedef struct _xy_pair {
-    float x, y;
-} Point, Vector;
-
 typedef struct _Edge
 {
     float next, prev;
@@ -90,9 +83,15 @@ typedef struct _Edge
 class Object
 {
 public:
-    Vector	 force;
-    Point	 position;
-    Vector	 velocity;
+    Object (Point  &position,
+	    Vector &velocity,
+	    Vector &force);
+
+    /* stored in the arrays of the model */
+    Vector	 &force;
+    Point	 &position;
+    Vector	 &velocity;
+
     float	 theta;
     bool	 immobile;
     unsigned int edgeMask;
@@ -120,7 +119,6 @@ public:
 	       Object *newB,
 	       float  newOffsetX,
 		   float  newOffsetY);
-    void exertForces (float k);
 };
 
 class Model
@@ -130,6 +128,7 @@ public:
 	   int          y,
 	   int          width,
 	   int          height,
+	   int          gridSize,
 	   unsigned int edgeMask);
     ~Model ();
 
@@ -174,23 +173,42 @@ public:
 				 int   height);
     void move (float tx,
 	       float ty);
-    void bezierPatchEvaluate (float u,
-			      float v,
+    void updateBasis (int width,
+		      int height);
+    void releaseBasis ();
+    void bezierPatchRow (int y);
+    void bezierPatchEvaluate (int   x,
 			      float *patchX,
 			      float *patchY);
     Object * findNearestObject (float x,
 				float y);
 
+    int		 gridWidth;
+    int		 gridHeight;
     Object	 *objects;
     int		 numObjects;
-    Spring	 springs[MODEL_MAX_SPRINGS];
+    Point	 *positions;
+    Vector	 *velocities;
+    Vector	 *forces;
+    Vector	 *scratch;
+    Spring	 *springs;
     int		 numSprings;
+    float	 hpad;
+    float	 vpad;
     Object	 *anchorObject;
     float	 steps;
     Point	 topLeft;
     Point	 bottomRight;
     unsigned int edgeMask;
     unsigned int snapCnt[4];
+
+    /* Bernstein coefficients for every column and row offset into the
+       window, see updateBasis */
+    int                basisWidth;
+    int                basisHeight;
+    std::vector<float> basisU;
+    std::vector<float> basisV;
+    Point	       *rowPoints;
 };
 
 class WobblyScreen :
@@ -232,6 +250,9 @@ public:
 
     unsigned int wobblingWindowsMask;
 
+    /* windows with a non-zero wobblingMask */
+    CompositeWindowSet animatingWindows;
+
     unsigned int grabMask;
     CompWindow	 *grabWindow;
     bool         moveWindow;
@@ -0,0 +1,746 @@
+/*
+ * Copyright © 2011 compiz contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * copyright holders not be used in advertising or publicity pertaining
+ * to distribution of the software without specific, written prior
+ * permission. The copyright holders make no representations about the
+ * suitability of this software for any purpose. It is provided "as is"
+ * without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <X11/Xatom.h>
+#include <X11/extensions/shape.h>
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/Xdamage.h>
+
+#include <compiz.h>
+#include <core/core.h>
+#include <core/atoms.h>
+
+#include "privatescreen.h"
+#include "privateeventrecorder.h"
+
+#define EVENT_STREAM_MAGIC   "CZEV"
+#define EVENT_STREAM_VERSION 2
+
+#define EVENT_LONGS (sizeof (XEvent) / sizeof (long))
+
+static const char *eventNames[LASTEvent] = {
+    0, 0,
+    "KeyPress", "KeyRelease", "ButtonPress", "ButtonRelease",
+    "MotionNotify", "EnterNotify", "LeaveNotify", "FocusIn", "FocusOut",
+    "KeymapNotify", "Expose", "GraphicsExpose", "NoExpose",
+    "VisibilityNotify", "CreateNotify", "DestroyNotify", "UnmapNotify",
+    "MapNotify", "MapRequest", "ReparentNotify", "ConfigureNotify",
+    "ConfigureRequest", "GravityNotify", "ResizeRequest",
+    "CirculateNotify", "CirculateRequest", "PropertyNotify",
+    "SelectionClear", "SelectionRequest", "SelectionNotify",
+    "ColormapNotify", "ClientMessage", "MappingNotify", "GenericEvent"
+};
+
+static int
+extensionEventBase (Display    *dpy,
+		    const char *name)
+{
+    int opcode, event, error;
+
+    if (!XQueryExtension (dpy, name, &opcode, &event, &error))
+	return -1;
+
+    return event;
+}
+
+EventRemapper::EventRemapper (Display *dpy)
+{
+    bases.damage = extensionEventBase (dpy, "DAMAGE");
+    bases.shape  = extensionEventBase (dpy, "SHAPE");
+    bases.sync   = extensionEventBase (dpy, "SYNC");
+    bases.randr  = extensionEventBase (dpy, "RANDR");
+
+    xdndFinished = XInternAtom (dpy, "XdndFinished", 0);
+}
+
+void
+EventRemapper::remapEvent (XEvent *event)
+{
+    switch (event->type) {
+    case KeyPress:
+    case KeyRelease:
+	event->xkey.window    = remapWindow (event->xkey.window);
+	event->xkey.root      = remapWindow (event->xkey.root);
+	event->xkey.subwindow = remapWindow (event->xkey.subwindow);
+	break;
+    case ButtonPress:
+    case ButtonRelease:
+	event->xbutton.window    = remapWindow (event->xbutton.window);
+	event->xbutton.root      = remapWindow (event->xbutton.root);
+	event->xbutton.subwindow = remapWindow (event->xbutton.subwindow);
+	break;
+    case MotionNotify:
+	event->xmotion.window    = remapWindow (event->xmotion.window);
+	event->xmotion.root      = remapWindow (event->xmotion.root);
+	event->xmotion.subwindow = remapWindow (event->xmotion.subwindow);
+	break;
+    case EnterNotify:
+    case LeaveNotify:
+	event->xcrossing.window    = remapWindow (event->xcrossing.window);
+	event->xcrossing.root      = remapWindow (event->xcrossing.root);
+	event->xcrossing.subwindow = remapWindow (event->xcrossing.subwindow);
+	break;
+    case CreateNotify:
+	event->xcreatewindow.parent = remapWindow (event->xcreatewindow.parent);
+	event->xcreatewindow.window = remapWindow (event->xcreatewindow.window);
+	break;
+    case DestroyNotify:
+	event->xdestroywindow.event  = remapWindow (event->xdestroywindow.event);
+	event->xdestroywindow.window =
+	    remapWindow (event->xdestroywindow.window);
+	break;
+    case UnmapNotify:
+	event->xunmap.event  = remapWindow (event->xunmap.event);
+	event->xunmap.window = remapWindow (event->xunmap.window);
+	break;
+    case MapNotify:
+	event->xmap.event  = remapWindow (event->xmap.event);
+	event->xmap.window = remapWindow (event->xmap.window);
+	break;
+    case MapRequest:
+	event->xmaprequest.parent = remapWindow (event->xmaprequest.parent);
+	event->xmaprequest.window = remapWindow (event->xmaprequest.window);
+	break;
+    case ReparentNotify:
+	event->xreparent.event  = remapWindow (event->xreparent.event);
+	event->xreparent.window = remapWindow (event->xreparent.window);
+	event->xreparent.parent = remapWindow (event->xreparent.parent);
+	break;
+    case ConfigureNotify:
+	event->xconfigure.event  = remapWindow (event->xconfigure.event);
+	event->xconfigure.window = remapWindow (event->xconfigure.window);
+	event->xconfigure.above  = remapWindow (event->xconfigure.above);
+	break;
+    case ConfigureRequest:
+	event->xconfigurerequest.parent =
+	    remapWindow (event->xconfigurerequest.parent);
+	event->xconfigurerequest.window =
+	    remapWindow (event->xconfigurerequest.window);
+	event->xconfigurerequest.above =
+	    remapWindow (event->xconfigurerequest.above);
+	break;
+    case GravityNotify:
+	event->xgravity.event  = remapWindow (event->xgravity.event);
+	event->xgravity.window = remapWindow (event->xgravity.window);
+	break;
+    case CirculateNotify:
+	event->xcirculate.event  = remapWindow (event->xcirculate.event);
+	event->xcirculate.window = remapWindow (event->xcirculate.window);
+	break;
+    case CirculateRequest:
+	event->xcirculaterequest.parent =
+	    remapWindow (event->xcirculaterequest.parent);
+	event->xcirculaterequest.window =
+	    remapWindow (event->xcirculaterequest.window);
+	break;
+    case PropertyNotify:
+	event->xproperty.window = remapWindow (event->xproperty.window);
+	event->xproperty.atom   = remapAtom (event->xproperty.atom);
+	break;
+    case SelectionClear:
+	event->xselectionclear.window =
+	    remapWindow (event->xselectionclear.window);
+	event->xselectionclear.selection =
+	    remapAtom (event->xselectionclear.selection);
+	break;
+    case SelectionRequest:
+	event->xselectionrequest.owner =
+	    remapWindow (event->xselectionrequest.owner);
+	event->xselectionrequest.requestor =
+	    remapWindow (event->xselectionrequest.requestor);
+	event->xselectionrequest.selection =
+	    remapAtom (event->xselectionrequest.selection);
+	event->xselectionrequest.target =
+	    remapAtom (event->xselectionrequest.target);
+	event->xselectionrequest.property =
+	    remapAtom (event->xselectionrequest.property);
+	break;
+    case SelectionNotify:
+	event->xselection.requestor = remapWindow (event->xselection.requestor);
+	event->xselection.selection = remapAtom (event->xselection.selection);
+	event->xselection.target    = remapAtom (event->xselection.target);
+	event->xselection.property  = remapAtom (event->xselection.property);
+	break;
+    case ClientMessage:
+	remapClientMessage (&event->xclient);
+	break;
+    default:
+	/* the remaining core events have their window where the window
+	   of XAnyEvent is, extension events are laid out as they like */
+	if (event->type < LASTEvent)
+	    event->xany.window = remapWindow (event->xany.window);
+	else
+	    remapExtensionEvent (event);
+	break;
+    }
+}
+
+/* What data.l holds depends on the message type, this covers the
+   messages that carry atoms or windows among those core handles. The
+   message type is an atom of the display here, both when recording and
+   when replaying. */
+void
+EventRemapper::remapClientMessage (XClientMessageEvent *event)
+{
+    Atom type;
+    long *l = event->data.l;
+
+    event->window       = remapWindow (event->window);
+    event->message_type = type = remapAtom (event->message_type);
+
+    if (event->format != 32)
+	return;
+
+    if (type == Atoms::winState)
+    {
+	l[1] = remapAtom (l[1]);
+	l[2] = remapAtom (l[2]);
+    }
+    else if (type == Atoms::wmProtocols)
+    {
+	l[0] = remapAtom (l[0]);
+
+	if ((Atom) l[0] == Atoms::wmPing)
+	    l[2] = remapWindow (l[2]);
+    }
+    else if (type == Atoms::winActive)
+    {
+	l[2] = remapWindow (l[2]);
+    }
+    else if (type == Atoms::restackWindow)
+    {
+	l[1] = remapWindow (l[1]);
+    }
+    else if (type == Atoms::xdndEnter)
+    {
+	l[0] = remapWindow (l[0]);
+	l[2] = remapAtom (l[2]);
+	l[3] = remapAtom (l[3]);
+	l[4] = remapAtom (l[4]);
+    }
+    else if (type == Atoms::xdndPosition || type == Atoms::xdndStatus)
+    {
+	l[0] = remapWindow (l[0]);
+	l[4] = remapAtom (l[4]);
+    }
+    else if (type == xdndFinished)
+    {
+	l[0] = remapWindow (l[0]);
+	l[2] = remapAtom (l[2]);
+    }
+    else if (type == Atoms::xdndLeave || type == Atoms::xdndDrop)
+    {
+	l[0] = remapWindow (l[0]);
+    }
+}
+
+/* Extension events are told apart by the event bases of the stream,
+   events of other extensions carry nothing that is remapped */
+void
+EventRemapper::remapExtensionEvent (XEvent *event)
+{
+    int type = event->type;
+
+    if (bases.damage >= 0 && type == bases.damage + XDamageNotify)
+    {
+	XDamageNotifyEvent *de = (XDamageNotifyEvent *) event;
+
+	de->drawable = remapWindow (de->drawable);
+	de->damage   = remapResource (de->damage);
+    }
+    else if (bases.shape >= 0 && type == bases.shape + ShapeNotify)
+    {
+	XShapeEvent *se = (XShapeEvent *) event;
+
+	se->window = remapWindow (se->window);
+    }
+    else if (bases.sync >= 0 && type == bases.sync + XSyncCounterNotify)
+    {
+	XSyncCounterNotifyEvent *ce = (XSyncCounterNotifyEvent *) event;
+
+	ce->counter = remapResource (ce->counter);
+    }
+    else if (bases.sync >= 0 && type == bases.sync + XSyncAlarmNotify)
+    {
+	XSyncAlarmNotifyEvent *ae = (XSyncAlarmNotifyEvent *) event;
+
+	ae->alarm = remapResource (ae->alarm);
+    }
+    else if (bases.randr >= 0 && type == bases.randr + RRScreenChangeNotify)
+    {
+	XRRScreenChangeNotifyEvent *re = (XRRScreenChangeNotifyEvent *) event;
+
+	re->window = remapWindow (re->window);
+	re->root   = remapWindow (re->root);
+    }
+    else if (bases.randr >= 0 && type == bases.randr + RRNotify)
+    {
+	XRRNotifyEvent *re = (XRRNotifyEvent *) event;
+
+	re->window = remapWindow (re->window);
+    }
+}
+
+EventRecorder::EventRecorder (Display *dpy, Window root) :
+    EventRemapper (dpy),
+    dpy (dpy),
+    fp (NULL),
+    count (0)
+{
+    windows[None] = None;
+    windows[root] = 1;
+}
+
+EventRecorder::~EventRecorder ()
+{
+    if (fp)
+    {
+	fclose (fp);
+
+	compLogMessage ("core", CompLogLevelInfo,
+			"recorded %u events of %d windows", count,
+			(int) windows.size () - 2);
+    }
+}
+
+bool
+EventRecorder::open (const char *file)
+{
+    uint32_t header[6] = { EVENT_STREAM_VERSION, sizeof (XEvent),
+			   (uint32_t) bases.damage, (uint32_t) bases.shape,
+			   (uint32_t) bases.sync, (uint32_t) bases.randr };
+
+    fp = fopen (file, "w");
+    if (!fp)
+    {
+	compLogMessage ("core", CompLogLevelError,
+			"Couldn't open event recording file %s", file);
+	return false;
+    }
+
+    fwrite (EVENT_STREAM_MAGIC, 1, 4, fp);
+    fwrite (header, sizeof (uint32_t), 6, fp);
+
+    gettimeofday (&lastEvent, 0);
+
+    return true;
+}
+
+Window
+EventRecorder::remapWindow (Window id)
+{
+    std::map<Window, Window>::iterator it = windows.find (id);
+
+    if (it != windows.end ())
+	return it->second;
+
+    /* None and the root window are always in the map */
+    Window remapped = windows.size ();
+
+    windows[id] = remapped;
+
+    return remapped;
+}
+
+XID
+EventRecorder::remapResource (XID id)
+{
+    if (id == None)
+	return None;
+
+    std::map<XID, XID>::iterator it = resources.find (id);
+
+    if (it != resources.end ())
+	return it->second;
+
+    XID remapped = resources.size () + 1;
+
+    resources[id] = remapped;
+
+    return remapped;
+}
+
+Atom
+EventRecorder::remapAtom (Atom atom)
+{
+    if (atom == None || atom <= XA_LAST_PREDEFINED || atoms[atom])
+	return atom;
+
+    char *name = XGetAtomName (dpy, atom);
+
+    if (name)
+    {
+	uint32_t value = atom;
+	uint16_t length = strlen (name);
+
+	fputc ('A', fp);
+	fwrite (&value, sizeof (value), 1, fp);
+	fwrite (&length, sizeof (length), 1, fp);
+	fwrite (name, 1, length, fp);
+
+	XFree (name);
+    }
+
+    atoms[atom] = true;
+
+    return atom;
+}
+
+void
+EventRecorder::record (const XEvent *event)
+{
+    struct timeval tv;
+    XEvent         copy = *event;
+    uint32_t       delta;
+    uint8_t        n = EVENT_LONGS;
+
+    if (!fp)
+	return;
+
+    gettimeofday (&tv, 0);
+    delta = (tv.tv_sec - lastEvent.tv_sec) * 1000000 +
+	    (tv.tv_usec - lastEvent.tv_usec);
+    lastEvent = tv;
+
+    /* atoms are written out here as well, before the event itself */
+    remapEvent (&copy);
+    copy.xany.display = NULL;
+
+    while (n > 0 && copy.pad[n - 1] == 0)
+	n--;
+
+    fputc ('E', fp);
+    fwrite (&delta, sizeof (delta), 1, fp);
+    fwrite (&n, sizeof (n), 1, fp);
+    fwrite (copy.pad, sizeof (long), n, fp);
+
+    count++;
+}
+
+EventReplayer::EventReplayer (Display *dpy, Window root) :
+    EventRemapper (dpy),
+    dpy (dpy),
+    parent (None),
+    fp (NULL),
+    recorded (0),
+    displayBases (bases)
+{
+    XSetWindowAttributes attr;
+
+    windows[None] = None;
+    windows[1]    = root;
+
+    /* replayed windows are created as children of an unmapped window
+       so that only the recorded events reach core and no events the
+       X server generates for the new windows */
+    attr.override_redirect = true;
+    parent = XCreateWindow (dpy, root, -100, -100, 1, 1, 0,
+			    CopyFromParent, InputOutput, CopyFromParent,
+			    CWOverrideRedirect, &attr);
+}
+
+EventReplayer::~EventReplayer ()
+{
+    if (fp)
+	fclose (fp);
+
+    XDestroyWindow (dpy, parent);
+}
+
+bool
+EventReplayer::open (const char *file)
+{
+    char     magic[4];
+    uint32_t header[6];
+
+    this->file = file;
+
+    fp = fopen (file, "r");
+    if (!fp)
+    {
+	compLogMessage ("core", CompLogLevelError,
+			"Couldn't open event recording %s", file);
+	return false;
+    }
+
+    if (fread (magic, 1, 4, fp) != 4 ||
+	fread (header, sizeof (uint32_t), 2, fp) != 2 ||
+	memcmp (magic, EVENT_STREAM_MAGIC, 4))
+    {
+	compLogMessage ("core", CompLogLevelError,
+			"%s is not an event recording", file);
+	return false;
+    }
+
+    if (header[0] != EVENT_STREAM_VERSION || header[1] != sizeof (XEvent) ||
+	fread (header + 2, sizeof (uint32_t), 4, fp) != 4)
+    {
+	compLogMessage ("core", CompLogLevelError,
+			"Event recording %s has an unsupported format", file);
+	return false;
+    }
+
+    /* extension events are remapped with the event bases of the
+       recording and moved to those of this display afterwards */
+    bases.damage = (int32_t) header[2];
+    bases.shape  = (int32_t) header[3];
+    bases.sync   = (int32_t) header[4];
+    bases.randr  = (int32_t) header[5];
+
+    return true;
+}
+
+Window
+EventReplayer::remapWindow (Window id)
+{
+    std::map<Window, Window>::iterator it = windows.find (id);
+
+    if (it != windows.end ())
+	return it->second;
+
+    Window window = XCreateWindow (dpy, parent, 0, 0, 1, 1, 0,
+				   CopyFromParent, InputOutput, CopyFromParent,
+				   0, NULL);
+
+    windows[id] = window;
+
+    return window;
+}
+
+XID
+EventReplayer::remapResource (XID id)
+{
+    if (id == None)
+	return None;
+
+    std::map<XID, XID>::iterator it = resources.find (id);
+
+    if (it != resources.end ())
+	return it->second;
+
+    /* an id nothing else on this display is going to use */
+    XID remapped = XAllocID (dpy);
+
+    resources[id] = remapped;
+
+    return remapped;
+}
+
+Atom
+EventReplayer::remapAtom (Atom atom)
+{
+    std::map<Atom, Atom>::iterator it = atoms.find (atom);
+
+    if (it != atoms.end ())
+	return it->second;
+
+    return atom;
+}
+
+bool
+EventReplayer::next (XEvent *event)
+{
+    int c;
+
+    if (!fp)
+	return false;
+
+    for (;;)
+    {
+	uint32_t delta;
+	uint8_t  n;
+
+	while ((c = fgetc (fp)) == 'A')
+	{
+	    uint32_t value;
+	    uint16_t length;
+
+	    if (fread (&value, sizeof (value), 1, fp) != 1 ||
+		fread (&length, sizeof (length), 1, fp) != 1)
+		break;
+
+	    std::vector<char> name (length + 1, 0);
+
+	    if (fread (&name[0], 1, length, fp) != length)
+		break;
+
+	    atoms[value] = XInternAtom (dpy, &name[0], false);
+	}
+
+	if (c != 'E')
+	    break;
+
+	memset (event, 0, sizeof (XEvent));
+
+	if (fread (&delta, sizeof (delta), 1, fp) != 1 ||
+	    fread (&n, sizeof (n), 1, fp) != 1 || n > EVENT_LONGS ||
+	    fread (event->pad, sizeof (long), n, fp) != n)
+	    break;
+
+	/* give new windows the geometry they were created with */
+	if (event->type == CreateNotify &&
+	    windows.find (event->xcreatewindow.window) == windows.end ())
+	{
+	    XSetWindowAttributes attr;
+	    XCreateWindowEvent   *ce = &event->xcreatewindow;
+
+	    attr.override_redirect = ce->override_redirect;
+	    windows[ce->window] =
+		XCreateWindow (dpy, parent, ce->x, ce->y,
+			       MAX (ce->width, 1), MAX (ce->height, 1),
+			       ce->border_width, CopyFromParent,
+			       InputOutput, CopyFromParent,
+			       CWOverrideRedirect, &attr);
+	}
+
+	remapEvent (event);
+
+	recorded += delta;
+
+	if (!translateEventType (event))
+	    continue;
+
+	event->xany.display = dpy;
+
+	return true;
+    }
+
+    if (c != EOF)
+	compLogMessage ("core", CompLogLevelWarn,
+			"Event recording %s is truncated", file.c_str ());
+
+    return false;
+}
+
+bool
+EventReplayer::translateEventType (XEvent *event)
+{
+    int stream[]  = { bases.damage, bases.shape, bases.sync, bases.randr };
+    int display[] = { displayBases.damage, displayBases.shape,
+		      displayBases.sync, displayBases.randr };
+    int number[]  = { XDamageNumberEvents, ShapeNumberEvents,
+		      XSyncNumberEvents, RRNumberEvents };
+
+    if (event->type < LASTEvent)
+	return true;
+
+    for (unsigned int i = 0; i < sizeof (stream) / sizeof (stream[0]); i++)
+    {
+	if (stream[i] < 0 || event->type < stream[i] ||
+	    event->type >= stream[i] + number[i])
+	    continue;
+
+	if (display[i] < 0)
+	    return false;
+
+	event->type = display[i] + event->type - stream[i];
+
+	return true;
+    }
+
+    /* the event numbers of other extensions can't be told apart from
+       those of a different extension on this display */
+    return false;
+}
+
+/* Feeds a recorded event stream to core and the plugins as fast as
+   possible and prints how long dispatching each type of event took.
+   Events the X server generates in response are handled in between,
+   outside of the measurement. Timers do not run during replay. */
+void
+PrivateScreen::replayEvents (const char *file)
+{
+    struct ReplayStats {
+	unsigned int       count;
+	unsigned long long total;
+	unsigned int       max;
+    };
+
+    EventReplayer  replayer (dpy, root);
+    ReplayStats    stats[256];
+    XEvent         event;
+    struct timeval start, tv1, tv2;
+    unsigned int   count = 0, elapsed;
+
+    if (!replayer.open (file))
+	return;
+
+    memset (stats, 0, sizeof (stats));
+
+    processEvents ();
+
+    gettimeofday (&start, 0);
+
+    while (!shutDown && replayer.next (&event))
+    {
+	ReplayStats  &s = stats[event.type & 0xff];
+	unsigned int time;
+
+	gettimeofday (&tv1, 0);
+	dispatchEvent (&event);
+	gettimeofday (&tv2, 0);
+
+	time = (tv2.tv_sec - tv1.tv_sec) * 1000000 +
+	       (tv2.tv_usec - tv1.tv_usec);
+
+	s.count++;
+	s.total += time;
+	s.max    = MAX (s.max, time);
+	count++;
+
+	processEvents ();
+    }
+
+    XSync (dpy, false);
+    processEvents ();
+
+    gettimeofday (&tv2, 0);
+    elapsed = TIMEVALDIFF (&tv2, &start);
+
+    printf ("replayed %u events in %u ms (recorded in %u ms)\n",
+	    count, elapsed, replayer.recordedTime ());
+    printf ("%-20s %8s %12s %10s %10s\n",
+	    "event", "count", "total (us)", "mean (us)", "max (us)");
+
+    for (int i = 0; i < 256; i++)
+    {
+	char name[32];
+
+	if (!stats[i].count)
+	    continue;
+
+	if (i < LASTEvent && eventNames[i])
+	    snprintf (name, sizeof (name), "%s", eventNames[i]);
+	else
+	    snprintf (name, sizeof (name), "extension %d", i);
+
+	printf ("%-20s %8u %12llu %10.1f %10u\n", name, stats[i].count,
+		stats[i].total, (double) stats[i].total / stats[i].count,
+		stats[i].max);
+    }
+}
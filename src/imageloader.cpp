@@ -0,0 +1,517 @@
+/*
+ * Copyright © 2011 compiz contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * copyright holders not be used in advertising or publicity pertaining
+ * to distribution of the software without specific, written prior
+ * permission. The copyright holders make no representations about the
+ * suitability of this software for any purpose. It is provided "as is"
+ * without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#define foreach BOOST_FOREACH
+
+#include <core/core.h>
+
+#include "privateimageloader.h"
+
+bool
+ImageLoader::Key::operator< (const Key &k) const
+{
+    if (mtime != k.mtime)
+	return mtime < k.mtime;
+    if (mtimeNsec != k.mtimeNsec)
+	return mtimeNsec < k.mtimeNsec;
+    if (fileSize != k.fileSize)
+	return fileSize < k.fileSize;
+    if (width != k.width)
+	return width < k.width;
+    if (height != k.height)
+	return height < k.height;
+
+    return file < k.file;
+}
+
+ImageLoader::ImageLoader () :
+    lastDecoderHandle (1),
+    cacheSize (0),
+    hits (0),
+    misses (0),
+    running (false),
+    quit (false),
+    watchFdHandle (0),
+    current (NULL),
+    lastLoadHandle (1)
+{
+    wakeUp[0] = wakeUp[1] = -1;
+
+    pthread_mutex_init (&decodeMutex, NULL);
+    pthread_cond_init (&decodeCond, NULL);
+    pthread_mutex_init (&cacheMutex, NULL);
+    pthread_mutex_init (&mutex, NULL);
+    pthread_cond_init (&cond, NULL);
+}
+
+ImageLoader::~ImageLoader ()
+{
+    if (running)
+    {
+	pthread_mutex_lock (&mutex);
+	quit = true;
+	pthread_cond_signal (&cond);
+	pthread_mutex_unlock (&mutex);
+
+	pthread_join (thread, NULL);
+    }
+
+    if (watchFdHandle)
+	screen->removeWatchFd (watchFdHandle);
+
+    if (wakeUp[0] >= 0)
+    {
+	close (wakeUp[0]);
+	close (wakeUp[1]);
+    }
+
+    foreach (Job *job, queue)
+	delete job;
+
+    foreach (Job *job, done)
+    {
+	if (job->data)
+	    free (job->data);
+
+	delete job;
+    }
+
+    foreach (Entry &e, entries)
+	free (e.data);
+
+    compLogMessage ("core", CompLogLevelDebug,
+		    "%u images decoded, %u loaded from the image cache",
+		    misses, hits);
+
+    pthread_cond_destroy (&cond);
+    pthread_mutex_destroy (&mutex);
+    pthread_mutex_destroy (&cacheMutex);
+    pthread_cond_destroy (&decodeCond);
+    pthread_mutex_destroy (&decodeMutex);
+}
+
+bool
+ImageLoader::lookup (const Key &key,
+		     CompSize  &size,
+		     void      *&data)
+{
+    std::map<Key, EntryList::iterator>::iterator it = index.find (key);
+    size_t                                       bytes;
+
+    if (it == index.end ())
+	return false;
+
+    /* move to the front of the list */
+    entries.splice (entries.begin (), entries, it->second);
+
+    bytes = it->second->size.width () * it->second->size.height () * 4;
+
+    data = malloc (bytes);
+    if (!data)
+	return false;
+
+    memcpy (data, it->second->data, bytes);
+    size = it->second->size;
+
+    return true;
+}
+
+void
+ImageLoader::insert (const Key      &key,
+		     const CompSize &size,
+		     const void     *data)
+{
+    size_t bytes = size.width () * size.height () * 4;
+    Entry  e;
+
+    if (bytes > IMAGE_CACHE_SIZE || index.find (key) != index.end ())
+	return;
+
+    while (cacheSize + bytes > IMAGE_CACHE_SIZE)
+    {
+	Entry &last = entries.back ();
+
+	cacheSize -= last.size.width () * last.size.height () * 4;
+	free (last.data);
+	index.erase (last.key);
+	entries.pop_back ();
+    }
+
+    e.key  = key;
+    e.size = size;
+    e.data = malloc (bytes);
+    if (!e.data)
+	return;
+
+    memcpy (e.data, data, bytes);
+
+    entries.push_front (e);
+    index[key] = entries.begin ();
+    cacheSize += bytes;
+}
+
+bool
+ImageLoader::load (const CompString &path,
+		   const CompSize   &request,
+		   CompSize         &size,
+		   void             *&data)
+{
+    std::list<DecoderPtr> list;
+    bool                  status = false;
+
+    pthread_mutex_lock (&decodeMutex);
+    list = decoders;
+    pthread_mutex_unlock (&decodeMutex);
+
+    foreach (DecoderPtr &d, list)
+    {
+	CompString  file = path;
+	unsigned    len = d->extension.length ();
+	struct stat st;
+	Key         key;
+	bool        found;
+
+	if (file.length () <= len ||
+	    file.compare (file.length () - len, len, d->extension) != 0)
+	    file += d->extension;
+
+	if (stat (file.c_str (), &st) || !S_ISREG (st.st_mode))
+	    continue;
+
+	key.file      = file;
+	key.fileSize  = st.st_size;
+	key.mtime     = st.st_mtim.tv_sec;
+	key.mtimeNsec = st.st_mtim.tv_nsec;
+	key.width     = request.width ();
+	key.height    = request.height ();
+
+	pthread_mutex_lock (&cacheMutex);
+	found = lookup (key, size, data);
+	if (found)
+	    hits++;
+	pthread_mutex_unlock (&cacheMutex);
+
+	if (found)
+	{
+	    status = true;
+	    break;
+	}
+
+	/* unregistered since the list was copied */
+	pthread_mutex_lock (&decodeMutex);
+	if (d->removed)
+	{
+	    pthread_mutex_unlock (&decodeMutex);
+	    continue;
+	}
+	d->users++;
+	pthread_mutex_unlock (&decodeMutex);
+
+	status = d->proc (file, request, size, data);
+
+	pthread_mutex_lock (&decodeMutex);
+	if (!--d->users && d->removed)
+	    pthread_cond_broadcast (&decodeCond);
+	pthread_mutex_unlock (&decodeMutex);
+
+	if (status)
+	{
+	    pthread_mutex_lock (&cacheMutex);
+	    insert (key, size, data);
+	    misses++;
+	    pthread_mutex_unlock (&cacheMutex);
+	    break;
+	}
+    }
+
+    return status;
+}
+
+CompImageDecoderHandle
+ImageLoader::addDecoder (const CompString &extension,
+			 ImageDecodeProc  proc)
+{
+    DecoderPtr d (new Decoder);
+
+    d->extension = extension;
+    d->proc      = proc;
+    d->users     = 0;
+    d->removed   = false;
+
+    pthread_mutex_lock (&decodeMutex);
+
+    d->handle = lastDecoderHandle++;
+    decoders.push_back (d);
+
+    pthread_mutex_unlock (&decodeMutex);
+
+    return d->handle;
+}
+
+void
+ImageLoader::removeDecoder (CompImageDecoderHandle handle)
+{
+    std::list<DecoderPtr>::iterator it;
+
+    pthread_mutex_lock (&decodeMutex);
+
+    for (it = decoders.begin (); it != decoders.end (); it++)
+    {
+	DecoderPtr d = *it;
+
+	if (d->handle == handle)
+	{
+	    decoders.erase (it);
+	    d->removed = true;
+
+	    /* waits for the loads that are running this decoder */
+	    while (d->users)
+		pthread_cond_wait (&decodeCond, &decodeMutex);
+
+	    break;
+	}
+    }
+
+    pthread_mutex_unlock (&decodeMutex);
+}
+
+void *
+ImageLoader::threadFunc (void *closure)
+{
+    ImageLoader *l = (ImageLoader *) closure;
+
+    pthread_mutex_lock (&l->mutex);
+
+    for (;;)
+    {
+	Job *job;
+	char c = 0;
+
+	while (!l->quit && l->queue.empty ())
+	    pthread_cond_wait (&l->cond, &l->mutex);
+
+	if (l->quit)
+	    break;
+
+	job = l->current = l->queue.front ();
+	l->queue.pop_front ();
+
+	pthread_mutex_unlock (&l->mutex);
+
+	foreach (const CompString &path, job->paths)
+	{
+	    job->status = l->load (path, job->request, job->size, job->data);
+	    if (job->status)
+		break;
+	}
+
+	pthread_mutex_lock (&l->mutex);
+
+	l->current = NULL;
+
+	if (job->cancelled)
+	{
+	    if (job->data)
+		free (job->data);
+
+	    delete job;
+	    continue;
+	}
+
+	l->done.push_back (job);
+
+	if (write (l->wakeUp[1], &c, 1) < 0)
+	    ; /* pipe is full, the main thread is going to wake up anyway */
+    }
+
+    pthread_mutex_unlock (&l->mutex);
+
+    return NULL;
+}
+
+bool
+ImageLoader::startThread ()
+{
+    sigset_t all, old;
+    int      status;
+
+    if (pipe (wakeUp))
+    {
+	wakeUp[0] = wakeUp[1] = -1;
+	return false;
+    }
+
+    fcntl (wakeUp[0], F_SETFL, O_NONBLOCK);
+    fcntl (wakeUp[1], F_SETFL, O_NONBLOCK);
+
+    /* signals are for the main thread only */
+    sigfillset (&all);
+    pthread_sigmask (SIG_BLOCK, &all, &old);
+    status = pthread_create (&thread, NULL, threadFunc, this);
+    pthread_sigmask (SIG_SETMASK, &old, NULL);
+
+    if (status)
+    {
+	close (wakeUp[0]);
+	close (wakeUp[1]);
+	wakeUp[0] = wakeUp[1] = -1;
+
+	return false;
+    }
+
+    watchFdHandle =
+	screen->addWatchFd (wakeUp[0], POLLIN,
+			    boost::bind (&ImageLoader::handleWakeUp, this, _1));
+
+    running = true;
+
+    return true;
+}
+
+void
+ImageLoader::handleWakeUp (short int events)
+{
+    char buf[64];
+
+    while (read (wakeUp[0], buf, sizeof (buf)) > 0);
+
+    /* one job at a time, so that a callback can still cancel the
+       loads that finished with its own */
+    for (;;)
+    {
+	Job *job;
+
+	pthread_mutex_lock (&mutex);
+
+	if (done.empty ())
+	{
+	    pthread_mutex_unlock (&mutex);
+	    break;
+	}
+
+	job = done.front ();
+	done.pop_front ();
+
+	pthread_mutex_unlock (&mutex);
+
+	if (job->cancelled)
+	{
+	    if (job->data)
+		free (job->data);
+
+	    delete job;
+	    continue;
+	}
+
+	/* formats without a decoder go through the plugins that wrap
+	   fileToImage, as with readImageFromFile */
+	if (!job->status)
+	{
+	    foreach (CompString &path, job->paths)
+	    {
+		int stride;
+
+		job->status = screen->fileToImage (path, job->size,
+						   stride, job->data);
+		if (job->status)
+		    break;
+	    }
+	}
+
+	job->callBack (job->status, job->size,
+		       job->status ? job->data : NULL);
+
+	delete job;
+    }
+}
+
+CompImageLoadHandle
+ImageLoader::loadAsync (const std::vector<CompString> &paths,
+			const CompSize                &request,
+			ImageLoadCallBack             callBack)
+{
+    Job *job;
+
+    if (!running && !startThread ())
+	return 0;
+
+    job = new Job;
+    job->paths     = paths;
+    job->request   = request;
+    job->callBack  = callBack;
+    job->cancelled = false;
+    job->status    = false;
+    job->data      = NULL;
+
+    pthread_mutex_lock (&mutex);
+
+    job->handle = lastLoadHandle++;
+    if (lastLoadHandle == MAXSHORT)
+	lastLoadHandle = 1;
+
+    queue.push_back (job);
+    pthread_cond_signal (&cond);
+
+    pthread_mutex_unlock (&mutex);
+
+    return job->handle;
+}
+
+void
+ImageLoader::cancel (CompImageLoadHandle handle)
+{
+    std::list<Job *>::iterator it;
+
+    pthread_mutex_lock (&mutex);
+
+    for (it = queue.begin (); it != queue.end (); it++)
+    {
+	if ((*it)->handle == handle)
+	{
+	    delete *it;
+	    queue.erase (it);
+	    pthread_mutex_unlock (&mutex);
+	    return;
+	}
+    }
+
+    if (current && current->handle == handle)
+	current->cancelled = true;
+
+    /* finished jobs are dropped by handleWakeUp */
+    foreach (Job *job, done)
+	if (job->handle == handle)
+	    job->cancelled = true;
+
+    pthread_mutex_unlock (&mutex);
+}
@@ -38,6 +38,7 @@
 
 #include <core/core.h>
 #include "privatescreen.h"
+#include "privateeventrecorder.h"
 
 char *programName;
 char **programArgv;
@@ -76,7 +77,9 @@ CompManager::usage ()
 	    "[--use-root-window] "
 	    "[--debug] "
 	    "[--version] "
-	    "[--help] "
+	    "[--help]\n       "
+	    "[--record-events FILE] "
+	    "[--replay-events FILE] "
 	    "[PLUGIN]...\n",
 	    programName);
 }
@@ -159,6 +162,16 @@ CompManager::parseArguments (int argc, char **argv)
 	    if (i + 1 < argc)
 		backgroundImage = argv[++i];
 	}
+	else if (!strcmp (argv[i], "--record-events"))
+	{
+	    if (i + 1 < argc)
+		recordFile = argv[++i];
+	}
+	else if (!strcmp (argv[i], "--replay-events"))
+	{
+	    if (i + 1 < argc)
+		replayFile = argv[++i];
+	}
 	else if (*argv[i] == '-')
 	{
 	    compLogMessage ("core", CompLogLevelWarn,
@@ -178,7 +191,9 @@ CompManager::parseArguments (int argc, char **argv)
 CompManager::CompManager () :
     disableSm (false),
     clientId (NULL),
-    displayName (NULL)
+    displayName (NULL),
+    recordFile (NULL),
+    replayFile (NULL)
 {
 }
 
@@ -239,13 +254,27 @@ CompManager::init ()
     if (!screen->init (displayName))
 	return false;
 
+    if (recordFile)
+    {
+	EventRecorder *recorder = new EventRecorder (screen->dpy (),
+						     screen->root ());
+
+	if (recorder->open (recordFile))
+	    screen->priv->eventRecorder = recorder;
+	else
+	    delete recorder;
+    }
+
     return true;
 }
 
 void
 CompManager::run ()
 {
-    screen->eventLoop ();
+    if (replayFile)
+	screen->priv->replayEvents (replayFile);
+    else
+	screen->eventLoop ();
 }
 
 void
@@ -0,0 +1,146 @@
+/*
+ * Copyright © 2011 compiz contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * copyright holders not be used in advertising or publicity pertaining
+ * to distribution of the software without specific, written prior
+ * permission. The copyright holders make no representations about the
+ * suitability of this software for any purpose. It is provided "as is"
+ * without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _PRIVATEEVENTRECORDER_H
+#define _PRIVATEEVENTRECORDER_H
+
+#include <stdio.h>
+#include <sys/time.h>
+
+#include <map>
+
+#include <X11/Xlib.h>
+
+#include <compiz.h>
+
+/*
+ * Recorded event streams are stored as a header followed by records.
+ *
+ * header: "CZEV", format version, sizeof (XEvent) and the first event
+ *         of the damage, shape, sync and randr extensions or -1, all
+ *         as written by the recording machine, streams are not portable
+ *         between architectures
+ * 'A'   : atom number and name, written before the first event that
+ *         refers to the atom
+ * 'E'   : microseconds since the previous event, the number of longs
+ *         that follow and the event itself with trailing zero longs
+ *         stripped
+ *
+ * Window ids are replaced by small numbers in order of appearance with
+ * the root window always being 1, other resources like damage handles
+ * and sync alarms are numbered the same way starting at 1, so that a
+ * stream can be replayed against a different X server. Extension
+ * events are translated to the event bases of the replaying server.
+ */
+
+/* first event of each extension, -1 when it is missing */
+struct EventBases {
+    int damage;
+    int shape;
+    int sync;
+    int randr;
+};
+
+class EventRemapper {
+    public:
+	EventRemapper (Display *dpy);
+	virtual ~EventRemapper () {}
+
+	void remapEvent (XEvent *event);
+
+    protected:
+	virtual Window remapWindow (Window id) = 0;
+	virtual Atom   remapAtom (Atom atom) = 0;
+	virtual XID    remapResource (XID id) = 0;
+
+	/* event bases of the stream, which are those of the display
+	   when recording */
+	EventBases bases;
+
+    private:
+	void remapClientMessage (XClientMessageEvent *event);
+	void remapExtensionEvent (XEvent *event);
+
+	Atom xdndFinished;
+};
+
+class EventRecorder : public EventRemapper {
+    public:
+	EventRecorder (Display *dpy, Window root);
+	~EventRecorder ();
+
+	bool open (const char *file);
+	void record (const XEvent *event);
+
+    protected:
+	Window remapWindow (Window id);
+	Atom   remapAtom (Atom atom);
+	XID    remapResource (XID id);
+
+    private:
+	Display        *dpy;
+	FILE           *fp;
+	struct timeval lastEvent;
+	unsigned int   count;
+
+	std::map<Window, Window> windows;
+	std::map<Atom, bool>     atoms;
+	std::map<XID, XID>       resources;
+};
+
+class EventReplayer : public EventRemapper {
+    public:
+	EventReplayer (Display *dpy, Window root);
+	~EventReplayer ();
+
+	bool open (const char *file);
+
+	/* reads the next event, returns false at the end of the stream */
+	bool next (XEvent *event);
+
+	/* time between the first and the last recorded event in ms */
+	unsigned int recordedTime () const { return recorded / 1000; }
+
+    protected:
+	Window remapWindow (Window id);
+	Atom   remapAtom (Atom atom);
+	XID    remapResource (XID id);
+
+    private:
+	/* moves extension events to the event bases of the display,
+	   returns false for events of extensions the display lacks */
+	bool translateEventType (XEvent *event);
+
+	Display     *dpy;
+	Window      parent;
+	FILE        *fp;
+	CompString  file;
+	unsigned long long recorded;
+	EventBases  displayBases;
+
+	std::map<Window, Window> windows;
+	std::map<Atom, Atom>     atoms;
+	std::map<XID, XID>       resources;
+};
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Copyright © 2011 compiz contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * copyright holders not be used in advertising or publicity pertaining
+ * to distribution of the software without specific, written prior
+ * permission. The copyright holders make no representations about the
+ * suitability of this software for any purpose. It is provided "as is"
+ * without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _PRIVATEIMAGELOADER_H
+#define _PRIVATEIMAGELOADER_H
+
+#include <pthread.h>
+#include <time.h>
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <core/screen.h>
+
+/* decoded images kept for repeated loads, in bytes */
+#define IMAGE_CACHE_SIZE (32 * 1024 * 1024)
+
+/*
+ * Loads images with the decoders that plugins register for a file
+ * extension, on the calling thread or on a worker thread that is
+ * started for the first asynchronous load. Decoded images are cached
+ * by file, size, modification time and requested size, least recently used
+ * images are dropped when the cache grows beyond IMAGE_CACHE_SIZE.
+ *
+ * The decoder list is guarded by decodeMutex, the cache by cacheMutex
+ * and the job lists by mutex. None of them is held while a decoder
+ * runs, each decoder counts its users instead so that unregistering
+ * it waits only for the loads that are running it.
+ */
+class ImageLoader {
+    public:
+	ImageLoader ();
+	~ImageLoader ();
+
+	/* decodes the first of the files named by path and the registered
+	   extensions that exists and that its decoder can read */
+	bool load (const CompString &path,
+		   const CompSize   &request,
+		   CompSize         &size,
+		   void             *&data);
+
+	/* tries the paths in order on the worker thread and, if no
+	   decoder can read any of them, with CompScreen::fileToImage on the
+	   main thread before calling back */
+	CompImageLoadHandle loadAsync (const std::vector<CompString> &paths,
+				       const CompSize                &request,
+				       ImageLoadCallBack             callBack);
+
+	void cancel (CompImageLoadHandle handle);
+
+	CompImageDecoderHandle addDecoder (const CompString &extension,
+					   ImageDecodeProc  proc);
+
+	void removeDecoder (CompImageDecoderHandle handle);
+
+    private:
+	struct Decoder {
+	    CompImageDecoderHandle handle;
+	    CompString             extension;
+	    ImageDecodeProc        proc;
+
+	    unsigned int users;
+	    bool         removed;
+	};
+
+	typedef boost::shared_ptr<Decoder> DecoderPtr;
+
+	struct Key {
+	    CompString file;
+	    off_t      fileSize;
+	    time_t     mtime;
+	    long       mtimeNsec;
+	    int        width;
+	    int        height;
+
+	    bool operator< (const Key &k) const;
+	};
+
+	struct Entry {
+	    Key      key;
+	    CompSize size;
+	    void     *data;
+	};
+
+	typedef std::list<Entry> EntryList;
+
+	struct Job {
+	    CompImageLoadHandle     handle;
+	    std::vector<CompString> paths;
+	    CompSize                request;
+	    ImageLoadCallBack       callBack;
+
+	    bool     cancelled;
+	    bool     status;
+	    CompSize size;
+	    void     *data;
+	};
+
+	static void *threadFunc (void *closure);
+
+	bool startThread ();
+	void handleWakeUp (short int events);
+
+	bool lookup (const Key &key, CompSize &size, void *&data);
+	void insert (const Key &key, const CompSize &size, const void *data);
+
+	pthread_mutex_t decodeMutex;
+	pthread_cond_t  decodeCond;
+
+	std::list<DecoderPtr>  decoders;
+	CompImageDecoderHandle lastDecoderHandle;
+
+	pthread_mutex_t cacheMutex;
+
+	/* most recently used first */
+	EntryList                          entries;
+	std::map<Key, EntryList::iterator> index;
+	size_t                             cacheSize;
+
+	unsigned int hits;
+	unsigned int misses;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+
+	bool      running;
+	bool      quit;
+	pthread_t thread;
+
+	int               wakeUp[2];
+	CompWatchFdHandle watchFdHandle;
+
+	std::list<Job *>    queue;
+	std::list<Job *>    done;
+	Job                 *current;
+	CompImageLoadHandle lastLoadHandle;
+};
+
+#endif
@@ -43,6 +43,8 @@
 CompPlugin::VTable * getCoreVTable ();
 
 class CoreWindow;
+class EventRecorder;
+class ImageLoader;
 
 extern bool shutDown;
 extern bool restartSignal;
@@ -209,6 +211,10 @@ class PrivateScreen : public CoreOptions {
 
 	void processEvents ();
 
+	void dispatchEvent (XEvent *event);
+
+	void replayEvents (const char *file);
+
 	void removeDestroyed ();
 
 	void updatePassiveGrabs ();
@@ -248,6 +254,8 @@ class PrivateScreen : public CoreOptions {
 
 	bool handlePingTimeout ();
 
+	bool handleDeferredConfigureTimeout ();
+
 	bool handleActionEvent (XEvent *event);
 
 	void handleSelectionRequest (XEvent *event);
@@ -506,6 +514,12 @@ class PrivateScreen : public CoreOptions {
 
 	unsigned int pendingDestroys;
 
+	/* windows with a position not yet sent to the server */
+	std::list<CompWindow *> deferredConfigures;
+	CompTimer		deferredConfigureTimer;
+	unsigned int		configuresDeferred;
+	unsigned int		configuresSaved;
+
 	CompRect workArea;
 
 	unsigned int showingDesktopMask;
@@ -516,6 +530,10 @@ class PrivateScreen : public CoreOptions {
 	Window	      edgeWindow;
 	Window	      xdndWindow;
 
+	EventRecorder *eventRecorder;
+
+	ImageLoader *imageLoader;
+
         bool initialized;
 };
 
@@ -541,6 +559,8 @@ class CompManager
 	bool		       disableSm;
 	char		       *clientId;
 	char		       *displayName;
+	char		       *recordFile;
+	char		       *replayFile;
 };
 
 #endif
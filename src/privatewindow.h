@@ -300,6 +300,8 @@ class PrivateWindow {
 	bool                 syncWait;
 	CompWindow::Geometry syncGeometry;
 
+	bool positionDeferred;
+
 	bool closeRequests;
 	Time lastCloseRequestTime;
 };
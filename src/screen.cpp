@@ -58,6 +58,8 @@
 #include <core/icon.h>
 #include <core/atoms.h>
 #include "privatescreen.h"
+#include "privateeventrecorder.h"
+#include "privateimageloader.h"
 #include "privatewindow.h"
 #include "privateaction.h"
 
@@ -700,20 +702,9 @@ PrivateScreen::processEvents ()
     {
 	XNextEvent (dpy, &event);
 
-	switch (event.type) {
-	case ButtonPress:
-	case ButtonRelease:
-	    pointerX = event.xbutton.x_root;
-	    pointerY = event.xbutton.y_root;
-	    pointerMods = event.xbutton.state;
-	    break;
-	case KeyPress:
-	case KeyRelease:
-	    pointerX = event.xkey.x_root;
-	    pointerY = event.xkey.y_root;
-	    pointerMods = event.xbutton.state;
-	    break;
-	case MotionNotify:
+	/* only the last of a series of motion events is of interest */
+	if (event.type == MotionNotify)
+	{
 	    while (XPending (dpy))
 	    {
 		XPeekEvent (dpy, &peekEvent);
@@ -723,55 +714,79 @@ PrivateScreen::processEvents ()
 
 		XNextEvent (dpy, &event);
 	    }
+	}
 
-	    pointerX = event.xmotion.x_root;
-	    pointerY = event.xmotion.y_root;
-	    pointerMods = event.xbutton.state;
-	    break;
-	case EnterNotify:
-	case LeaveNotify:
-	    pointerX = event.xcrossing.x_root;
-	    pointerY = event.xcrossing.y_root;
-	    pointerMods = event.xbutton.state;
-	    break;
-	case ClientMessage:
-	    if (event.xclient.message_type == Atoms::xdndPosition)
-	    {
-		pointerX = event.xclient.data.l[2] >> 16;
-		pointerY = event.xclient.data.l[2] & 0xffff;
-		/* FIXME: Xdnd provides us no way of getting the pointer mods
-		 * without doing XQueryPointer, which is a round-trip */
-		pointerMods = 0;
-	    }
-	    else if (event.xclient.message_type == Atoms::wmMoveResize)
-	    {
-		int i;
-		Window child, root;
-		/* _NET_WM_MOVERESIZE is most often sent by clients who provide
-		 * a special "grab space" on a window for the user to initiate
-		 * adjustment by the window manager. Since we don't have a
-		 * passive grab on Button1 for active and raised windows, we
-		 * need to update the pointer buffer here */
-
-		XQueryPointer (screen->dpy (), screen->root (),
-			       &root, &child, &pointerX, &pointerY,
-			       &i, &i, &pointerMods);
-	    }
-	    break;
-	default:
-	    break;
-        }
-
-	sn_display_process_event (snDisplay, &event);
+	if (eventRecorder)
+	    eventRecorder->record (&event);
 
-	inHandleEvent = true;
-	screen->handleEvent (&event);
-	inHandleEvent = false;
+	dispatchEvent (&event);
+    }
+}
 
-	lastPointerX = pointerX;
-	lastPointerY = pointerY;
-	lastPointerMods = pointerMods;
+void
+PrivateScreen::dispatchEvent (XEvent *event)
+{
+    switch (event->type) {
+    case ButtonPress:
+    case ButtonRelease:
+	pointerX = event->xbutton.x_root;
+	pointerY = event->xbutton.y_root;
+	pointerMods = event->xbutton.state;
+	break;
+    case KeyPress:
+    case KeyRelease:
+	pointerX = event->xkey.x_root;
+	pointerY = event->xkey.y_root;
+	pointerMods = event->xbutton.state;
+	break;
+    case MotionNotify:
+	pointerX = event->xmotion.x_root;
+	pointerY = event->xmotion.y_root;
+	pointerMods = event->xbutton.state;
+	break;
+    case EnterNotify:
+    case LeaveNotify:
+	pointerX = event->xcrossing.x_root;
+	pointerY = event->xcrossing.y_root;
+	pointerMods = event->xbutton.state;
+	break;
+    case ClientMessage:
+	if (event->xclient.message_type == Atoms::xdndPosition)
+	{
+	    pointerX = event->xclient.data.l[2] >> 16;
+	    pointerY = event->xclient.data.l[2] & 0xffff;
+	    /* FIXME: Xdnd provides us no way of getting the pointer mods
+	     * without doing XQueryPointer, which is a round-trip */
+	    pointerMods = 0;
+	}
+	else if (event->xclient.message_type == Atoms::wmMoveResize)
+	{
+	    int i;
+	    Window child, root;
+	    /* _NET_WM_MOVERESIZE is most often sent by clients who provide
+	     * a special "grab space" on a window for the user to initiate
+	     * adjustment by the window manager. Since we don't have a
+	     * passive grab on Button1 for active and raised windows, we
+	     * need to update the pointer buffer here */
+
+	    XQueryPointer (screen->dpy (), screen->root (),
+			   &root, &child, &pointerX, &pointerY,
+			   &i, &i, &pointerMods);
+	}
+	break;
+    default:
+	break;
     }
+
+    sn_display_process_event (snDisplay, event);
+
+    inHandleEvent = true;
+    screen->handleEvent (event);
+    inHandleEvent = false;
+
+    lastPointerX = pointerX;
+    lastPointerY = pointerY;
+    lastPointerMods = pointerMods;
 }
 
 void
@@ -1064,49 +1079,100 @@ PrivateScreen::handleSelectionClear (XEvent *event)
 #define IMAGEDIR "images"
 #define HOMECOMPIZDIR ".compiz-1"
 
-bool
-CompScreen::readImageFromFile (CompString &name,
-			       CompString &pname,
-			       CompSize   &size,
-			       void       *&data)
+/* the file as given, then in the plugin directories of the user and
+   of the installation */
+static std::vector<CompString>
+imagePaths (CompString &name,
+	    CompString &pname)
 {
-    bool status;
-    int  stride;
+    std::vector<CompString> paths;
+    char                    *home = getenv ("HOME");
+    CompString              path;
 
-    status = fileToImage (name, size, stride, data);
-    if (!status)
-    {
-	char       *home = getenv ("HOME");
-	CompString path;
-	if (home)
-	{
-	    path =  home;
-	    path += "/";
-	    path += HOMECOMPIZDIR;
-	    path += "/";
-	    path += pname;
-	    path += "/";
-	    path += IMAGEDIR;
-	    path += "/";
-	    path += name;
-
-	    status = fileToImage (path, size, stride, data);
-
-	    if (status)
-		return true;
-	}
+    paths.push_back (name);
 
-	path = SHAREDIR;
+    if (home)
+    {
+	path =  home;
+	path += "/";
+	path += HOMECOMPIZDIR;
 	path += "/";
 	path += pname;
 	path += "/";
 	path += IMAGEDIR;
 	path += "/";
 	path += name;
-	status = fileToImage (path, size, stride, data);
+
+	paths.push_back (path);
+    }
+
+    path = SHAREDIR;
+    path += "/";
+    path += pname;
+    path += "/";
+    path += IMAGEDIR;
+    path += "/";
+    path += name;
+
+    paths.push_back (path);
+
+    return paths;
+}
+
+bool
+CompScreen::readImageFromFile (CompString &name,
+			       CompString &pname,
+			       CompSize   &size,
+			       void       *&data)
+{
+    std::vector<CompString> paths = imagePaths (name, pname);
+    int                     stride;
+
+    foreach (CompString &path, paths)
+    {
+	if (priv->imageLoader &&
+	    priv->imageLoader->load (path, CompSize (), size, data))
+	    return true;
+
+	if (fileToImage (path, size, stride, data))
+	    return true;
     }
 
-    return status;
+    return false;
+}
+
+/* Decodes on a worker thread and calls back from the main loop, never
+   before this returns. Returns 0 if the worker could not be started. */
+CompImageLoadHandle
+CompScreen::readImageFromFileAsync (CompString        &name,
+				    CompString        &pname,
+				    const CompSize    &request,
+				    ImageLoadCallBack callBack)
+{
+    return priv->imageLoader->loadAsync (imagePaths (name, pname),
+					 request, callBack);
+}
+
+void
+CompScreen::cancelImageLoad (CompImageLoadHandle handle)
+{
+    priv->imageLoader->cancel (handle);
+}
+
+/* The decoder is tried before the plugins that wrap fileToImage for
+   files with its extension. It must be safe to call from another
+   thread, also while the main thread is running it. */
+CompImageDecoderHandle
+CompScreen::registerImageDecoder (const CompString &extension,
+				  ImageDecodeProc  proc)
+{
+    return priv->imageLoader->addDecoder (extension, proc);
+}
+
+void
+CompScreen::unregisterImageDecoder (CompImageDecoderHandle handle)
+{
+    priv->imageLoader->removeDecoder (handle);
 }
 
 bool
@@ -4139,6 +4205,26 @@ CompScreen::shouldSerializePlugins ()
     return priv->optionGetDoSerialize ();
 }
 
+bool
+PrivateScreen::handleDeferredConfigureTimeout ()
+{
+    screen->flushDeferredConfigures ();
+
+    return false;
+}
+
+void
+CompScreen::flushDeferredConfigures ()
+{
+    priv->deferredConfigureTimer.stop ();
+
+    while (!priv->deferredConfigures.empty ())
+    {
+	/* syncPosition takes the window off the list */
+	priv->deferredConfigures.front ()->syncPosition ();
+    }
+}
+
 void
 PrivateScreen::removeDestroyed ()
 {
@@ -4692,6 +4778,9 @@ CompScreen::~CompScreen ()
     while ((p = CompPlugin::pop ()))
 	CompPlugin::unload (p);
 
+    delete priv->imageLoader;
+    priv->imageLoader = NULL;
+
     XUngrabKey (priv->dpy, AnyKey, AnyModifier, priv->root);
 
     priv->initialized = false;
@@ -4763,11 +4852,17 @@ PrivateScreen::PrivateScreen (CompScreen *screen) :
     grabs (0),
     grabbed (false),
     pendingDestroys (0),
+    deferredConfigures (),
+    deferredConfigureTimer (),
+    configuresDeferred (0),
+    configuresSaved (0),
     showingDesktopMask (0),
     desktopHintData (0),
     desktopHintSize (0),
     edgeWindow (None),
     xdndWindow (None),
+    eventRecorder (NULL),
+    imageLoader (new ImageLoader),
     initialized (false)
 {
     gettimeofday (&lastTimeout, 0);
@@ -4779,6 +4874,11 @@ PrivateScreen::PrivateScreen (CompScreen *screen) :
 	boost::bind (&PrivateScreen::handleStartupSequenceTimeout, this));
     startupSequenceTimer.setTimes (1000, 1500);
 
+    /* only runs when no compositing plugin flushes per frame */
+    deferredConfigureTimer.setCallback (
+	boost::bind (&PrivateScreen::handleDeferredConfigureTimeout, this));
+    deferredConfigureTimer.setTimes (40, 50);
+
     optionSetCloseWindowKeyInitiate (CompScreen::closeWin);
     optionSetCloseWindowButtonInitiate (CompScreen::closeWin);
     optionSetRaiseWindowKeyInitiate (CompScreen::raiseWin);
@@ -4815,4 +4915,10 @@ PrivateScreen::PrivateScreen (CompScreen *screen) :
 
 PrivateScreen::~PrivateScreen ()
 {
+    compLogMessage ("core", CompLogLevelDebug,
+		    "%u window positions deferred, %u configure requests "
+		    "saved", configuresDeferred, configuresSaved);
+
+    if (eventRecorder)
+	delete eventRecorder;
 }
@@ -1636,6 +1636,13 @@ PrivateWindow::configureFrame (XConfigureEvent *ce)
     width  = ce->width - priv->input.left - priv->input.right;
     height = ce->height - priv->input.top - priv->input.bottom;
 
+    /* the server is behind until the deferred position is sent */
+    if (priv->positionDeferred)
+    {
+	x = priv->attrib.x;
+	y = priv->attrib.y;
+    }
+
     if (priv->syncWait)
     {
 	priv->syncGeometry.set (x, y, width, height, ce->border_width);
@@ -1699,6 +1706,12 @@ CompWindow::move (int  dx,
 void
 CompWindow::syncPosition ()
 {
+    if (priv->positionDeferred)
+    {
+	priv->positionDeferred = false;
+	screen->priv->deferredConfigures.remove (this);
+    }
+
     priv->serverGeometry.setX (priv->attrib.x);
     priv->serverGeometry.setY (priv->attrib.y);
 
@@ -1714,6 +1727,25 @@ CompWindow::syncPosition ()
     }
 }
 
+void
+CompWindow::deferSyncPosition ()
+{
+    screen->priv->configuresDeferred++;
+
+    if (priv->positionDeferred)
+    {
+	/* the next flush sends this position instead */
+	screen->priv->configuresSaved++;
+	return;
+    }
+
+    priv->positionDeferred = true;
+    screen->priv->deferredConfigures.push_back (this);
+
+    if (!screen->priv->deferredConfigureTimer.active ())
+	screen->priv->deferredConfigureTimer.start ();
+}
+
 bool
 CompWindow::focus ()
 {
@@ -1845,6 +1877,9 @@ CompWindow::ungrabNotify ()
 {
     WRAPABLE_HND_FUNC (10, ungrabNotify)
     priv->grabbed = false;
+
+    if (priv->positionDeferred)
+	syncPosition ();
 }
 
 void
@@ -5320,6 +5355,9 @@ CompWindow::CompWindow (Window aboveId,
 
 CompWindow::~CompWindow ()
 {
+    if (priv->positionDeferred)
+	screen->priv->deferredConfigures.remove (this);
+
     screen->unhookWindow (this);
 
     if (!priv->destroyed)
@@ -5438,6 +5476,7 @@ PrivateWindow::PrivateWindow (CoreWindow *window) :
     syncWaitTimer (),
 
     syncWait (false),
+    positionDeferred (false),
     closeRequests (false),
     lastCloseRequestTime (0)
 {